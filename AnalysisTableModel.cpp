@@ -0,0 +1,47 @@
+// AnalysisTableModel.cpp
+
+#include "AnalysisTableModel.h"
+#include <utility>
+using namespace std;
+
+AnalysisTableModel::AnalysisTableModel(const QStringList &headers, QObject *parent)
+    : QAbstractTableModel(parent), headers(headers) {}
+
+void AnalysisTableModel::show(int rows, CellText cellText)
+{
+    beginResetModel();
+    this->rows = rows;
+    this->cellText = move(cellText);
+    endResetModel();
+}
+
+void AnalysisTableModel::clear()
+{
+    show(0, nullptr);
+}
+
+int AnalysisTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+int AnalysisTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : headers.size();
+}
+
+QVariant AnalysisTableModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rows)
+        return QVariant();
+    return cellText(index.row(), index.column());
+}
+
+QVariant AnalysisTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+    if (orientation == Qt::Horizontal)
+        return section < headers.size() ? headers[section] : QVariant();
+    return section + 1;
+}
@@ -0,0 +1,37 @@
+#ifndef ANALYSISTABLEMODEL_H
+#define ANALYSISTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <functional>
+
+// Read-only table for the lexer and parser output. Cells are formatted
+// only when a view asks for them, so showing a million tokens costs the
+// same as showing ten; nothing is copied out of the lexer.
+class AnalysisTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    // Text of cell (row, column)
+    using CellText = std::function<QString(int row, int column)>;
+
+    explicit AnalysisTableModel(const QStringList &headers, QObject *parent = nullptr);
+
+    // Shows `rows` rows read through `cellText`; whatever it reads must
+    // stay unchanged until the next show() or clear(), which rules out
+    // text in a memory-mapped file
+    void show(int rows, CellText cellText);
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QStringList headers;
+    int rows = 0;
+    CellText cellText;
+};
+
+#endif // ANALYSISTABLEMODEL_H
@@ -1,14 +1,26 @@
 // ParseTreeWidget.cpp
 
 #include "ParseTreeWidget.h"
-#include <QFontMetrics>
 #include <algorithm>
+#include <climits>
+#include <cmath>
 using namespace std;
 
-bool isComparisonOperator(const string& op) {
-    return op == ">" || op == "<" || op == ">=" || op == "<=" ||
-           op == "==" || op == "!=" || op == "in" || op == "not in" ||
-           op == "is" || op == "is not";
+static const int nodeHeight = 35; // Reduced from 40 to 35
+static const int verticalSpacing = 160; // INCREASED from 120 to 160
+static const int levelHeight = nodeHeight + verticalSpacing;
+static const int gridCellWidth = 512;  // culling grid columns, in scene units
+static const double minLabelHeight = 4.0;  // on screen, in pixels; smaller is drawn as plain boxes
+static const int collapsedStubLength = 40;
+static const int clickDistance = 4;  // pixels the mouse may move during a click
+
+static QString toQString(string_view text) {
+    return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+}
+
+bool isComparisonOperator(OpCode op) {
+    // ==, !=, <, >, <=, >= have consecutive IDs
+    return op >= LEX_EQ && op <= LEX_GE;
 }
 
 
@@ -24,8 +36,10 @@ ParseTreeWidget::ParseTreeWidget(QWidget *parent) :
     setCursor(Qt::OpenHandCursor);
 }
 
-void ParseTreeWidget::setParseTree(shared_ptr<ASTNode> root) {
-    this->root = root;
+void ParseTreeWidget::setParseTree(shared_ptr<const ParseResult> tree) {
+    this->tree = move(tree);
+    buildViewTree();
+    layoutTree();
     // Reset view with a better default scale
     scale = 0.4;  // Even more zoomed out for taller tree
     offset = QPoint(width() / 2, 30);  // Move up slightly
@@ -42,147 +56,284 @@ void ParseTreeWidget::paintEvent(QPaintEvent *event) {
     painter.scale(scale, scale);
 
     // Draw the tree if we have one
-    if (root) {
-        drawNode(painter, root, 0, 0, 0);
-    } else {
+    if (layoutNodes.empty()) {
         // Draw a message if no tree is available
         painter.setPen(Qt::black);
         painter.drawText(rect(), Qt::AlignCenter, "No parse tree to display");
+        return;
     }
-}
 
-int ParseTreeWidget::calculateSubtreeWidth(shared_ptr<ASTNode> node, int level) {
-    if (!node) return 0;
-
-    // Get the width needed for this node itself
-    QString label = getNodeLabel(node);
-    int nodeWidth = calculateNodeWidth(label);
-
-    // Get children
-    vector<shared_ptr<ASTNode>> children = getNodeChildren(node);
-    if (children.empty()) {
-        // Leaf node - needs its own width plus padding
-        return nodeWidth + 20; // Further reduced padding from 30 to 20
+    // Only the grid cells under the exposed area are visited, so the cost
+    // follows what is on screen rather than the size of the tree
+    QRect visible = painter.worldTransform().inverted().mapRect(QRectF(event->rect()))
+                        .toAlignedRect().adjusted(-1, -1, 1, 1);
+    if (visible.right() < gridLeft || visible.left() >= gridLeft + gridColumns * gridCellWidth) return;
+    // A row's edges reach down to the top of the next row
+    const int firstRow = visible.top() <= 0 ? 0 : (visible.top() - 1) / levelHeight;
+    const int lastRow = min(gridRows - 1, max(visible.bottom(), 0) / levelHeight);
+    const int firstColumn = max(0, (visible.left() - gridLeft) / gridCellWidth);
+    const int lastColumn = min(gridColumns - 1, (visible.right() - gridLeft) / gridCellWidth);
+
+    // Too far out to read, so skip the text and the rounded corners
+    const bool drawLabels = labelHeight * scale >= minLabelHeight;
+
+    visibleEdges.clear();
+    visibleNodes.clear();
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            const int cell = row * gridColumns + column;
+            for (int i = gridStart[cell]; i < gridStart[cell + 1]; i++) {
+                const LayoutNode& node = layoutNodes[gridItems[i]];
+                // A node spanning several visited cells is taken from the first
+                if (column != max(node.firstColumn, firstColumn)) continue;
+                if (node.rect.intersects(visible)) visibleNodes.push_back(gridItems[i]);
+                for (int e = node.firstEdge; e < node.firstEdge + node.edgeCount; e++) {
+                    const QLine& edge = layoutEdges[e];
+                    if (max(edge.x1(), edge.x2()) >= visible.left() && min(edge.x1(), edge.x2()) <= visible.right()
+                        && edge.y2() >= visible.top() && edge.y1() <= visible.bottom()) {
+                        visibleEdges.push_back(edge);
+                    }
+                }
+            }
+        }
     }
 
-    // Calculate total width needed by all children
-    int totalChildrenWidth = 0;
-    // Further reduced from 120 to 90, still adaptive
-    const int horizontalSpacingForLevel = 90 - level * 10;
-
-    for (const auto& child : children) {
-        totalChildrenWidth += calculateSubtreeWidth(child, level + 1);
+    painter.setPen(Qt::black);
+    painter.drawLines(visibleEdges.data(), static_cast<int>(visibleEdges.size()));
+    for (int index : visibleNodes) {
+        const LayoutNode& node = layoutNodes[index];
+        const ViewNode& view = viewNodes[node.view];
+        painter.setBrush(QBrush(view.color));
+        if (drawLabels) {
+            painter.drawRoundedRect(node.rect, 5, 5);
+            painter.drawText(node.rect, Qt::AlignCenter, view.label);
+        } else {
+            painter.drawRect(node.rect);
+        }
     }
+}
 
-    // Add spacing between children
-    if (children.size() > 1) {
-        totalChildrenWidth += horizontalSpacingForLevel * (children.size() - 1);
+void ParseTreeWidget::changeEvent(QEvent *event) {
+    // Node widths depend on the font
+    if (event->type() == QEvent::FontChange) {
+        layoutTree();
+        update();
     }
-
-    // Return the max of node's width and the width of all its children
-    return max(nodeWidth, totalChildrenWidth);
+    QWidget::changeEvent(event);
 }
 
-void ParseTreeWidget::drawNode(QPainter &painter, shared_ptr<ASTNode> node,
-                               int x, int y, int level) {
-    if (!node) return;
-
-    const int nodeHeight = 35; // Reduced from 40 to 35
-    const int verticalSpacing = 160; // INCREASED from 120 to 160
-    // Further reduced from 120 to 90, still adaptive
-    const int horizontalSpacing = 90 - level * 10;
-
-    // Get node label and calculate width
-    QString label = getNodeLabel(node);
-    int nodeWidth = calculateNodeWidth(label);
-
-    // Different colors for different node types
-    QColor nodeColor;
-    switch (node->type) {
+// Different colors for different node types
+static QColor nodeColor(NodeType type) {
+    switch (type) {
     case NodeType::PROGRAM:
-        nodeColor = QColor(173, 216, 230); // Light blue
-        break;
+        return QColor(173, 216, 230); // Light blue
     case NodeType::BINARY_EXPR:
-        nodeColor = QColor(144, 238, 144); // Light green
-        break;
+        return QColor(144, 238, 144); // Light green
     case NodeType::ASSIGNMENT_STMT:
-        nodeColor = QColor(255, 182, 193); // Light pink
-        break;
+        return QColor(255, 182, 193); // Light pink
     case NodeType::IDENTIFIER:
-        nodeColor = QColor(255, 255, 224); // Light yellow
-        break;
+        return QColor(255, 255, 224); // Light yellow
     case NodeType::LITERAL:
-        nodeColor = QColor(221, 160, 221); // Plum
-        break;
+        return QColor(221, 160, 221); // Plum
     case NodeType::CALL_EXPR:
-        nodeColor = QColor(255, 222, 173); // Navajo white
-        break;
+        return QColor(255, 222, 173); // Navajo white
     case NodeType::CONDITION_NODE:
-        nodeColor = QColor(135, 206, 235); // Sky blue
-        break;
+        return QColor(135, 206, 235); // Sky blue
     default:
-        nodeColor = QColor(173, 216, 230); // Default light blue
+        return QColor(173, 216, 230); // Default light blue
     }
+}
 
-    // Draw node ellipse
-    painter.setPen(Qt::black);
-    painter.setBrush(QBrush(nodeColor));
-    QRect nodeRect(x - nodeWidth/2, y, nodeWidth, nodeHeight);
-    painter.drawRoundedRect(nodeRect, 5, 5);
-
-    // Draw the node text
-    painter.drawText(nodeRect, Qt::AlignCenter, label);
-
-    // Get children nodes
-    vector<shared_ptr<ASTNode>> children = getNodeChildren(node);
-
-    if (!children.empty()) {
-        // Calculate the total width needed for children
-        vector<int> childrenWidths;
-        int totalChildrenWidth = 0;
-
-        // Calculate width for each child's subtree
-        for (const auto& child : children) {
-            int width = calculateSubtreeWidth(child, level + 1);
-            childrenWidths.push_back(width);
-            totalChildrenWidth += width;
-        }
+void ParseTreeWidget::buildViewTree() {
+    viewNodes.clear();
+    wrappers.clear();
+    if (!tree || !tree->root) return;
+
+    // Only the top levels are expanded; deeper display nodes (and their
+    // wrappers) are made when the user opens their parent
+    viewNodes.push_back({tree->root, 0, 0, 0, false, false, getNodeLabel(tree->root), nodeColor(tree->root->type)});
+    exploreNode(0);
+    for (size_t i = 0; i < viewNodes.size(); i++) {
+        if (viewNodes[i].level < expandedLevels) expandNode(static_cast<int>(i));
+    }
+}
 
-        // Add spacing between children
-        totalChildrenWidth += horizontalSpacing * (children.size() - 1);
+void ParseTreeWidget::exploreNode(int index) {
+    if (viewNodes[index].explored || !viewNodes[index].node) return;
+    getNodeChildren(viewNodes[index].node, childBuffer);
+    // A node's children are added together, after it, so they stay
+    // adjacent. A null child still gets a node (and an edge), as it always
+    // has, but no box.
+    const int level = viewNodes[index].level + 1;
+    viewNodes[index].firstChild = static_cast<int>(viewNodes.size());
+    viewNodes[index].childCount = static_cast<int>(childBuffer.size());
+    viewNodes[index].explored = true;
+    for (ASTNode* child : childBuffer) {
+        if (child) {
+            viewNodes.push_back({child, level, 0, 0, false, false, getNodeLabel(child), nodeColor(child->type)});
+        } else {
+            viewNodes.push_back({nullptr, level, 0, 0, true, false, QString(), QColor()});
+        }
+    }
+}
 
-        // Calculate starting X position for first child
-        int startX = x - (totalChildrenWidth / 2);
+// Its children are explored too, so each can show whether it has more
+void ParseTreeWidget::expandNode(int index) {
+    exploreNode(index);
+    viewNodes[index].expanded = true;
+    const int firstChild = viewNodes[index].firstChild;
+    for (int c = 0; c < viewNodes[index].childCount; c++) {
+        exploreNode(firstChild + c);
+    }
+}
 
-        // Draw each child with appropriate spacing
-        int currentX = startX;
-        for (size_t i = 0; i < children.size(); i++) {
-            const auto& child = children[i];
-            int childWidth = childrenWidths[i];
+void ParseTreeWidget::layoutTree() {
+    layoutNodes.clear();
+    layoutEdges.clear();
+    if (viewNodes.empty()) {
+        indexLayout();
+        return;
+    }
 
-            // Position the child at the center of its allocated space
-            int childX = currentX + childWidth / 2;
-            int childY = y + nodeHeight + verticalSpacing;
+    QFontMetrics metrics(font());
+    labelHeight = metrics.height();
+
+    struct Placement {
+        bool shown;         // every ancestor is expanded
+        int width;          // of the node's own box
+        int childrenWidth;  // of its children side by side
+        int subtreeWidth;
+        int x;
+        int y;
+    };
+    vector<Placement> places(viewNodes.size(), Placement{false, 0, 0, 0, 0, 0});
+    places[0].shown = true;
+    for (size_t i = 0; i < viewNodes.size(); i++) {
+        const ViewNode& view = viewNodes[i];
+        if (!places[i].shown || !view.expanded) continue;
+        for (int c = 0; c < view.childCount; c++) places[view.firstChild + c].shown = true;
+    }
 
-            // Draw line to child
-            painter.drawLine(x, y + nodeHeight, childX, childY);
+    // Subtree widths, children before parents; a collapsed node is laid
+    // out as a leaf
+    for (size_t i = viewNodes.size(); i-- > 0;) {
+        const ViewNode& view = viewNodes[i];
+        Placement& place = places[i];
+        if (!view.node || !place.shown) continue;
+        place.width = calculateNodeWidth(metrics, view.label);
+        if (!view.expanded || view.childCount == 0) {
+            // Leaf node - needs its own width plus padding
+            place.subtreeWidth = place.width + 20; // Further reduced padding from 30 to 20
+            continue;
+        }
+        // Further reduced from 120 to 90, still adaptive
+        const int horizontalSpacing = 90 - view.level * 10;
+        int totalChildrenWidth = horizontalSpacing * (view.childCount - 1);
+        for (int c = 0; c < view.childCount; c++) {
+            totalChildrenWidth += places[view.firstChild + c].subtreeWidth;
+        }
+        place.childrenWidth = totalChildrenWidth;
+        place.subtreeWidth = max(place.width, totalChildrenWidth);
+    }
 
-            // Recursively draw the child
-            drawNode(painter, child, childX, childY, level + 1);
+    // Positions, parents before children: each child is centred in its
+    // share of the space under its parent
+    for (size_t i = 0; i < viewNodes.size(); i++) {
+        const ViewNode& view = viewNodes[i];
+        const Placement& place = places[i];
+        if (!view.node || !place.shown) continue;
+        LayoutNode node;
+        node.rect = QRect(place.x - place.width / 2, place.y, place.width, nodeHeight);
+        node.view = static_cast<int>(i);
+        node.firstEdge = static_cast<int>(layoutEdges.size());
+        node.edgeCount = 0;
+        node.firstColumn = 0;
+
+        if (!view.expanded) {
+            // A short stub marks a collapsed node that has children
+            if (view.childCount > 0) {
+                layoutEdges.emplace_back(place.x, place.y + nodeHeight, place.x, place.y + nodeHeight + collapsedStubLength);
+                node.edgeCount = 1;
+            }
+            layoutNodes.push_back(node);
+            continue;
+        }
+        const int horizontalSpacing = 90 - view.level * 10;
+        int currentX = place.x - (place.childrenWidth / 2);
+        for (int c = 0; c < view.childCount; c++) {
+            Placement& child = places[view.firstChild + c];
+            child.x = currentX + child.subtreeWidth / 2;
+            child.y = place.y + levelHeight;
+            layoutEdges.emplace_back(place.x, place.y + nodeHeight, child.x, child.y);
+            currentX += child.subtreeWidth + horizontalSpacing;
+        }
+        node.edgeCount = view.childCount;
+        layoutNodes.push_back(node);
+    }
+    indexLayout();
+}
 
-            // Move to next child position
-            currentX += childWidth + horizontalSpacing;
+void ParseTreeWidget::indexLayout() {
+    gridStart.assign(1, 0);
+    gridItems.clear();
+    gridColumns = 0;
+    gridRows = 0;
+    gridLeft = 0;
+    if (layoutNodes.empty()) return;
+
+    // Each node is listed in its level's row, in every column its box or
+    // the edges down to its children cross
+    auto extent = [this](const LayoutNode& node) {
+        int left = node.rect.left();
+        int right = node.rect.right();
+        for (int e = node.firstEdge; e < node.firstEdge + node.edgeCount; e++) {
+            left = min(left, layoutEdges[e].x2());
+            right = max(right, layoutEdges[e].x2());
+        }
+        return make_pair(left, right);
+    };
+    int left = INT_MAX;
+    int right = INT_MIN;
+    for (const LayoutNode& node : layoutNodes) {
+        auto [nodeLeft, nodeRight] = extent(node);
+        left = min(left, nodeLeft);
+        right = max(right, nodeRight);
+        gridRows = max(gridRows, node.rect.top() / levelHeight + 1);
+    }
+    gridLeft = left;
+    gridColumns = (right - left) / gridCellWidth + 1;
+
+    // Counting pass, then fill: the cells' lists end up in one array
+    gridStart.assign(static_cast<size_t>(gridRows) * gridColumns + 1, 0);
+    for (LayoutNode& node : layoutNodes) {
+        auto [nodeLeft, nodeRight] = extent(node);
+        node.firstColumn = (nodeLeft - gridLeft) / gridCellWidth;
+        const int lastColumn = (nodeRight - gridLeft) / gridCellWidth;
+        const int row = node.rect.top() / levelHeight;
+        for (int column = node.firstColumn; column <= lastColumn; column++) {
+            gridStart[row * gridColumns + column + 1]++;
+        }
+    }
+    for (size_t cell = 1; cell < gridStart.size(); cell++) gridStart[cell] += gridStart[cell - 1];
+    gridItems.resize(gridStart.back());
+    vector<int> filled(gridStart.begin(), gridStart.end() - 1);
+    for (size_t i = 0; i < layoutNodes.size(); i++) {
+        const LayoutNode& node = layoutNodes[i];
+        const int lastColumn = (extent(node).second - gridLeft) / gridCellWidth;
+        const int row = node.rect.top() / levelHeight;
+        for (int column = node.firstColumn; column <= lastColumn; column++) {
+            gridItems[filled[row * gridColumns + column]++] = static_cast<int>(i);
         }
     }
 }
 
-vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode> node) {
-    vector<shared_ptr<ASTNode>> children;
-    if (!node) return children;
+void ParseTreeWidget::getNodeChildren(ASTNode* node, vector<ASTNode*>& children) {
+    children.clear();
+    if (!node) return;
 
     switch (node->type) {
     case NodeType::PROGRAM: {
-        for (auto& stmt : static_cast<ProgramNode*>(node.get())->statements) {
+        for (auto& stmt : static_cast<ProgramNode*>(node)->statements) {
             // Check if this is an expression or assignment used as a statement
             if (stmt->type == NodeType::BINARY_EXPR ||
                 stmt->type == NodeType::CALL_EXPR ||
@@ -194,7 +345,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
                 stmt->type == NodeType::FOR_STMT) {
 
                 // Create a statement wrapper node
-                auto stmtNode = make_shared<StatementNode>(stmt);
+                auto stmtNode = wrappers.make<StatementNode>(stmt);
                 children.push_back(stmtNode);
                 } else {
                     // Other statement types (if, while, def, etc.) are already clearly statements
@@ -205,7 +356,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         break;
     }
     case NodeType::STATEMENT_LIST: {
-        for (auto& stmt : static_cast<StatementListNode*>(node.get())->statements) {
+        for (auto& stmt : static_cast<StatementListNode*>(node)->statements) {
             // Same logic as above
             if (stmt->type == NodeType::BINARY_EXPR ||
                 stmt->type == NodeType::CALL_EXPR ||
@@ -217,7 +368,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
                 stmt->type == NodeType::FOR_STMT) {
 
 
-                auto stmtNode = make_shared<StatementNode>(stmt);
+                auto stmtNode = wrappers.make<StatementNode>(stmt);
                 children.push_back(stmtNode);
                 } else {
                     children.push_back(stmt);
@@ -227,14 +378,14 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::STATEMENT: {
-        auto stmtNode = static_cast<StatementNode*>(node.get());
+        auto stmtNode = static_cast<StatementNode*>(node);
 
         // // Special handling for return statements
         // if (stmtNode->statement->type == NodeType::RETURN_STMT) {
-        //     auto returnNode = static_pointer_cast<ReturnNode>(stmtNode->statement);
+        //     auto returnNode = static_cast<ReturnNode*>(stmtNode->statement);
         //
         //     // Add "return" keyword as a terminal node
-        //     auto returnKeyword = make_shared<TerminalNode>("return",
+        //     auto returnKeyword = wrappers.make<TerminalNode>("return",
         //         returnNode->line_number, returnNode->column_number);
         //     children.push_back(returnKeyword);
         //
@@ -245,8 +396,8 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         // }
         // Add back special handling for assignment statements
         if (stmtNode->statement->type == NodeType::ASSIGNMENT_STMT) {
-            auto assignNode = static_pointer_cast<AssignmentNode>(stmtNode->statement);
-            auto assignStmtNode = make_shared<AssignStmtNode>(stmtNode->statement);
+            auto assignNode = static_cast<AssignmentNode*>(stmtNode->statement);
+            auto assignStmtNode = wrappers.make<AssignStmtNode>(stmtNode->statement);
             children.push_back(assignStmtNode);
         }
         else {
@@ -258,38 +409,38 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // Add this new case
     case NodeType::ASSIGNMENT_WRAPPER: {
-        auto assignWrapper = static_cast<AssignStmtNode*>(node.get());
-        auto assignNode = static_pointer_cast<AssignmentNode>(assignWrapper->assignment);
+        auto assignWrapper = static_cast<AssignStmtNode*>(node);
+        auto assignNode = static_cast<AssignmentNode*>(assignWrapper->assignment);
 
         // Add left side (target) as first child
         children.push_back(assignNode->target);
 
         // Add equals sign as second child
-        auto equalsNode = make_shared<TerminalNode>(assignNode->op, assignNode->line_number, assignNode->column_number);
+        auto equalsNode = wrappers.make<TerminalNode>(lexemeText(assignNode->op), assignNode->line_number, assignNode->column_number);
         children.push_back(equalsNode);
 
         // Add expression wrapper as third child
-        auto expNode = make_shared<ExpressionNode>(assignNode->value);
+        auto expNode = wrappers.make<ExpressionNode>(assignNode->value);
         children.push_back(expNode);
         break;
     }
 
     case NodeType::EXPRESSION: {
-        auto expNode = static_cast<ExpressionNode*>(node.get());
+        auto expNode = static_cast<ExpressionNode*>(node);
 
             if (expNode->expression->type == NodeType::UNARY_EXPR) {
-                auto unary = static_pointer_cast<UnaryExprNode>(expNode->expression);
+                auto unary = static_cast<UnaryExprNode*>(expNode->expression);
 
                 // Handle ALL unary minus expressions, not just for literals
-                if (unary->op == "-") {
-                    auto minusNode = make_shared<TerminalNode>("-",
+                if (unary->op == LEX_MINUS) {
+                    auto minusNode = wrappers.make<TerminalNode>("-",
                         unary->line_number, unary->column_number);
                     children.push_back(minusNode);
                     children.push_back(unary->operand);
                     break;
-                } else if (unary->op == "not") {
+                } else if (unary->op == LEX_NOT) {
                     // Keep existing handling for "not" operator
-                    auto notNode = make_shared<TerminalNode>("not",
+                    auto notNode = wrappers.make<TerminalNode>("not",
                         unary->line_number, unary->column_number);
                     children.push_back(notNode);
                     children.push_back(unary->operand);
@@ -299,19 +450,19 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // Handle parenthesized expression
         else if (expNode->expression->type == NodeType::GROUP_EXPR) {
-            auto groupExpr = static_pointer_cast<GroupExprNode>(expNode->expression);
+            auto groupExpr = static_cast<GroupExprNode*>(expNode->expression);
 
             // Add opening parenthesis
-            auto leftParenNode = make_shared<TerminalNode>("(",
+            auto leftParenNode = wrappers.make<TerminalNode>("(",
                 groupExpr->line_number, groupExpr->column_number);
             children.push_back(leftParenNode);
 
             // Add the expression itself, wrapped in an ExpressionNode
-            auto innerExpNode = make_shared<ExpressionNode>(groupExpr->expression);
+            auto innerExpNode = wrappers.make<ExpressionNode>(groupExpr->expression);
             children.push_back(innerExpNode);
 
             // Add closing parenthesis
-            auto rightParenNode = make_shared<TerminalNode>(")",
+            auto rightParenNode = wrappers.make<TerminalNode>(")",
                 groupExpr->line_number, groupExpr->column_number);
             children.push_back(rightParenNode);
 
@@ -320,13 +471,13 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // Existing code for binary expressions and other types
         else if (expNode->expression->type == NodeType::BINARY_EXPR) {
-            auto binary = static_cast<BinaryExprNode*>(expNode->expression.get());
+            auto binary = static_cast<BinaryExprNode*>(expNode->expression);
 
             // Check if left side is also a binary expression or a group expression
             if (binary->left->type == NodeType::BINARY_EXPR ||
                 binary->left->type == NodeType::GROUP_EXPR) {
                 // Wrap in an ExpressionNode to maintain hierarchy
-                auto leftExpNode = make_shared<ExpressionNode>(binary->left);
+                auto leftExpNode = wrappers.make<ExpressionNode>(binary->left);
                 children.push_back(leftExpNode);
             } else {
                 // Add left operand directly
@@ -334,14 +485,14 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
             }
 
             // Add the operator as a terminal node
-            auto opNode = make_shared<TerminalNode>(binary->op, binary->line_number, binary->column_number);
+            auto opNode = wrappers.make<TerminalNode>(lexemeText(binary->op), binary->line_number, binary->column_number);
             children.push_back(opNode);
 
             // Check if right side is also a binary expression or a group expression
             if (binary->right->type == NodeType::BINARY_EXPR ||
                 binary->right->type == NodeType::GROUP_EXPR) {
                 // Wrap in an ExpressionNode to maintain hierarchy
-                auto rightExpNode = make_shared<ExpressionNode>(binary->right);
+                auto rightExpNode = wrappers.make<ExpressionNode>(binary->right);
                 children.push_back(rightExpNode);
             } else {
                 // Add right operand directly
@@ -349,13 +500,13 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
             }
         } // Handle subscript expressions (bypass the "subscript" node)
         else if (expNode->expression->type == NodeType::SUBSCRIPT_EXPR) {
-            auto subscript = static_pointer_cast<SubscriptExprNode>(expNode->expression);
+            auto subscript = static_cast<SubscriptExprNode*>(expNode->expression);
 
             // Add container directly
             children.push_back(subscript->container);
 
             // Add opening bracket
-            auto leftBracketNode = make_shared<TerminalNode>("[",
+            auto leftBracketNode = wrappers.make<TerminalNode>("[",
                 subscript->line_number, subscript->column_number);
             children.push_back(leftBracketNode);
 
@@ -363,7 +514,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
             children.push_back(subscript->index);
 
             // Add closing bracket
-            auto rightBracketNode = make_shared<TerminalNode>("]",
+            auto rightBracketNode = wrappers.make<TerminalNode>("]",
                 subscript->line_number, subscript->column_number);
             children.push_back(rightBracketNode);
         } else {
@@ -374,19 +525,19 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::GROUP_EXPR: {
-        auto groupExpr = static_cast<GroupExprNode*>(node.get());
+        auto groupExpr = static_cast<GroupExprNode*>(node);
 
         // Add opening parenthesis as terminal node
-        auto leftParenNode = make_shared<TerminalNode>("(",
+        auto leftParenNode = wrappers.make<TerminalNode>("(",
             groupExpr->line_number, groupExpr->column_number);
         children.push_back(leftParenNode);
 
         // Add the expression itself, wrapped in an ExpressionNode
-        auto innerExpNode = make_shared<ExpressionNode>(groupExpr->expression);
+        auto innerExpNode = wrappers.make<ExpressionNode>(groupExpr->expression);
         children.push_back(innerExpNode);
 
         // Add closing parenthesis as terminal node
-        auto rightParenNode = make_shared<TerminalNode>(")",
+        auto rightParenNode = wrappers.make<TerminalNode>(")",
             groupExpr->line_number, groupExpr->column_number);
         children.push_back(rightParenNode);
 
@@ -394,20 +545,20 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     // case NodeType::COMPARISON_WRAPPER: {
-    //     auto compWrapper = static_cast<ComparisonExprNode*>(node.get());
-    //     auto binaryNode = static_pointer_cast<BinaryExprNode>(compWrapper->comparison);
+    //     auto compWrapper = static_cast<ComparisonExprNode*>(node);
+    //     auto binaryNode = static_cast<BinaryExprNode*>(compWrapper->comparison);
     //
     //     // Add left operand
     //     children.push_back(binaryNode->left);
     //
     //     // Add operator as a terminal node
-    //     auto opNode = make_shared<TerminalNode>(binaryNode->op, binaryNode->line_number, binaryNode->column_number);
+    //     auto opNode = wrappers.make<TerminalNode>(lexemeText(binaryNode->op), binaryNode->line_number, binaryNode->column_number);
     //     children.push_back(opNode);
     //
     //     // Check if right side is a binary expression
     //     if (binaryNode->right->type == NodeType::BINARY_EXPR) {
     //         // Wrap the right binary expression in an ExpressionNode
-    //         auto rightExpNode = make_shared<ExpressionNode>(binaryNode->right);
+    //         auto rightExpNode = wrappers.make<ExpressionNode>(binaryNode->right);
     //         children.push_back(rightExpNode);
     //     } else {
     //         // For non-binary expressions, add directly
@@ -416,18 +567,18 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     //     break;
     // }
     case NodeType::COMPARISON_WRAPPER: {
-        auto compWrapper = static_cast<ComparisonExprNode*>(node.get());
-        auto binaryNode = static_pointer_cast<BinaryExprNode>(compWrapper->comparison);
+        auto compWrapper = static_cast<ComparisonExprNode*>(node);
+        auto binaryNode = static_cast<BinaryExprNode*>(compWrapper->comparison);
 
         // Check if left side is itself a binary expression
         if (binaryNode->left->type == NodeType::BINARY_EXPR) {
-            auto leftBinary = static_pointer_cast<BinaryExprNode>(binaryNode->left);
+            auto leftBinary = static_cast<BinaryExprNode*>(binaryNode->left);
 
             // Add left operand of nested binary expression
             children.push_back(leftBinary->left);
 
             // Add the operator of nested binary expression as a terminal node
-            auto leftOpNode = make_shared<TerminalNode>(leftBinary->op, leftBinary->line_number, leftBinary->column_number);
+            auto leftOpNode = wrappers.make<TerminalNode>(lexemeText(leftBinary->op), leftBinary->line_number, leftBinary->column_number);
             children.push_back(leftOpNode);
 
             // Add right operand of nested binary expression
@@ -438,13 +589,13 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         }
 
         // Add the comparison operator (keep your existing code)
-        auto opNode = make_shared<TerminalNode>(binaryNode->op, binaryNode->line_number, binaryNode->column_number);
+        auto opNode = wrappers.make<TerminalNode>(lexemeText(binaryNode->op), binaryNode->line_number, binaryNode->column_number);
         children.push_back(opNode);
 
         // Keep your existing right-side handling
         if (binaryNode->right->type == NodeType::BINARY_EXPR) {
             // Wrap the right binary expression in an ExpressionNode
-            auto rightExpNode = make_shared<ExpressionNode>(binaryNode->right);
+            auto rightExpNode = wrappers.make<ExpressionNode>(binaryNode->right);
             children.push_back(rightExpNode);
         } else {
             // For non-binary expressions, add directly
@@ -455,12 +606,12 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::BLOCK: {
-        auto blockNode = static_cast<BlockNode*>(node.get());
+        auto blockNode = static_cast<BlockNode*>(node);
 
         // Check if blockNode->statements is a StatementListNode
         if (blockNode->statements && blockNode->statements->type == NodeType::STATEMENT_LIST) {
             // Bypass the StatementList and add its children directly
-            auto stmtList = static_cast<StatementListNode*>(blockNode->statements.get());
+            auto stmtList = static_cast<StatementListNode*>(blockNode->statements);
             for (auto& stmt : stmtList->statements) {
                 // Keep the same logic for statements that need wrappers
                 if (stmt->type == NodeType::BINARY_EXPR ||
@@ -472,7 +623,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
                     stmt->type == NodeType::WHILE_STMT ||
                     stmt->type == NodeType::FOR_STMT) {
 
-                    auto stmtNode = make_shared<StatementNode>(stmt);
+                    auto stmtNode = wrappers.make<StatementNode>(stmt);
                     children.push_back(stmtNode);
                     } else {
                         children.push_back(stmt);
@@ -487,24 +638,24 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // This is what you should use - it matches your NodeType enum
     case NodeType::ASSIGNMENT_STMT: {
-        auto assignWrapper = static_cast<AssignStmtNode*>(node.get());
-        auto assignNode = static_pointer_cast<AssignmentNode>(assignWrapper->assignment);
+        auto assignWrapper = static_cast<AssignStmtNode*>(node);
+        auto assignNode = static_cast<AssignmentNode*>(assignWrapper->assignment);
 
         // Add left side (target) as first child
         children.push_back(assignNode->target);
 
         // Add the actual operator (=, +=, -=, etc.) as second child
-        auto opNode = make_shared<TerminalNode>(assignNode->op, assignNode->line_number, assignNode->column_number);
+        auto opNode = wrappers.make<TerminalNode>(lexemeText(assignNode->op), assignNode->line_number, assignNode->column_number);
         children.push_back(opNode);
 
         // Add expression wrapper as third child
-        auto expNode = make_shared<ExpressionNode>(assignNode->value);
+        auto expNode = wrappers.make<ExpressionNode>(assignNode->value);
         children.push_back(expNode);
         break;
     }
 
     case NodeType::BINARY_EXPR: {
-        auto binary = static_cast<BinaryExprNode*>(node.get());
+        auto binary = static_cast<BinaryExprNode*>(node);
 
         // Check if this is a comparison operator
         if (isComparisonOperator(binary->op)) {
@@ -513,7 +664,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
             children.push_back(binary->left);
 
             // Add operator as a terminal node
-            auto opNode = make_shared<TerminalNode>(binary->op, binary->line_number, binary->column_number);
+            auto opNode = wrappers.make<TerminalNode>(lexemeText(binary->op), binary->line_number, binary->column_number);
             children.push_back(opNode);
 
             // Add right operand
@@ -527,31 +678,31 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::IF_STMT: {
-        auto ifNode = static_cast<IfNode*>(node.get());
+        auto ifNode = static_cast<IfNode*>(node);
 
         // Create a terminal node for "if" keyword
-        auto ifKeywordNode = make_shared<TerminalNode>("if", ifNode->line_number, ifNode->column_number);
+        auto ifKeywordNode = wrappers.make<TerminalNode>("if", ifNode->line_number, ifNode->column_number);
         children.push_back(ifKeywordNode);
 
         // Add left parenthesis if present
         if (ifNode->hasParentheses) {
-            auto leftParenNode = make_shared<TerminalNode>("(", ifNode->line_number, ifNode->column_number);
+            auto leftParenNode = wrappers.make<TerminalNode>("(", ifNode->line_number, ifNode->column_number);
             children.push_back(leftParenNode);
         }
 
         // Create a condition wrapper node that will have the actual condition as its child
-        auto conditionNode = make_shared<ConditionNode>(
+        auto conditionNode = wrappers.make<ConditionNode>(
             ifNode->condition, ifNode->line_number, ifNode->column_number);
         children.push_back(conditionNode);
 
         // Add right parenthesis if present
         if (ifNode->hasParentheses) {
-            auto rightParenNode = make_shared<TerminalNode>(")", ifNode->line_number, ifNode->column_number);
+            auto rightParenNode = wrappers.make<TerminalNode>(")", ifNode->line_number, ifNode->column_number);
             children.push_back(rightParenNode);
         }
 
         // Add colon
-        auto colonNode = make_shared<TerminalNode>(":", ifNode->line_number, ifNode->column_number);
+        auto colonNode = wrappers.make<TerminalNode>(":", ifNode->line_number, ifNode->column_number);
         children.push_back(colonNode);
 
         // Add the if block
@@ -559,9 +710,9 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // Create an else-part node if we have any elif or else clauses
         if (!ifNode->elif_clauses.empty() || ifNode->else_block) {
-            auto elsePartNode = make_shared<ElsePartNode>(
+            auto elsePartNode = wrappers.make<ElsePartNode>(
                 ifNode->elif_clauses,
-                dynamic_pointer_cast<ElseNode>(ifNode->else_block),
+                dynamic_cast<ElseNode*>(ifNode->else_block),
                 ifNode->line_number, ifNode->column_number);
             children.push_back(elsePartNode);
         }
@@ -569,7 +720,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::ELSE_PART: {
-        auto elsePart = static_cast<ElsePartNode*>(node.get());
+        auto elsePart = static_cast<ElsePartNode*>(node);
 
         // If we have elif clauses, handle them specially
         if (!elsePart->elif_clauses.empty()) {
@@ -577,28 +728,28 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
             auto& firstElif = elsePart->elif_clauses[0];
 
             // Create a terminal node for "elif" keyword
-            auto elifKeywordNode = make_shared<TerminalNode>("elif", firstElif->line_number, firstElif->column_number);
+            auto elifKeywordNode = wrappers.make<TerminalNode>("elif", firstElif->line_number, firstElif->column_number);
             children.push_back(elifKeywordNode);
 
             // Add left parenthesis if present
             if (firstElif->hasParentheses) {
-                auto leftParenNode = make_shared<TerminalNode>("(", firstElif->line_number, firstElif->column_number);
+                auto leftParenNode = wrappers.make<TerminalNode>("(", firstElif->line_number, firstElif->column_number);
                 children.push_back(leftParenNode);
             }
 
             // Create a condition wrapper node for the elif
-            auto conditionNode = make_shared<ConditionNode>(
+            auto conditionNode = wrappers.make<ConditionNode>(
                 firstElif->condition, firstElif->line_number, firstElif->column_number);
             children.push_back(conditionNode);
 
             // Add right parenthesis if present
             if (firstElif->hasParentheses) {
-                auto rightParenNode = make_shared<TerminalNode>(")", firstElif->line_number, firstElif->column_number);
+                auto rightParenNode = wrappers.make<TerminalNode>(")", firstElif->line_number, firstElif->column_number);
                 children.push_back(rightParenNode);
             }
 
             // Add colon
-            auto colonNode = make_shared<TerminalNode>(":", firstElif->line_number, firstElif->column_number);
+            auto colonNode = wrappers.make<TerminalNode>(":", firstElif->line_number, firstElif->column_number);
             children.push_back(colonNode);
 
             // Add the elif block
@@ -606,14 +757,13 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
             // If there are more elifs or an else, create a new ElsePartNode for them
             if (elsePart->elif_clauses.size() > 1 || elsePart->else_block) {
-                // Create a vector with remaining elifs (skipping the first one)
-                vector<shared_ptr<ElifNode>> remainingElifs;
-                for (size_t i = 1; i < elsePart->elif_clauses.size(); i++) {
-                    remainingElifs.push_back(elsePart->elif_clauses[i]);
-                }
+                // The remaining elifs (skipping the first one)
+                NodeList<ElifNode*> remainingElifs = elsePart->elif_clauses;
+                remainingElifs.items++;
+                remainingElifs.count--;
 
                 // Create a new ElsePartNode for the remaining elifs and the else block
-                auto nestedElsePart = make_shared<ElsePartNode>(
+                auto nestedElsePart = wrappers.make<ElsePartNode>(
                     remainingElifs,
                     elsePart->else_block,
                     firstElif->line_number,
@@ -625,12 +775,12 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         // If no elif clauses but we have an else, add "else" keyword and block separately
         else if (elsePart->else_block) {
             // Create a terminal node for "else" keyword
-            auto elseKeywordNode = make_shared<TerminalNode>("else",
+            auto elseKeywordNode = wrappers.make<TerminalNode>("else",
                 elsePart->else_block->line_number, elsePart->else_block->column_number);
             children.push_back(elseKeywordNode);
 
             // Create a terminal node for the colon
-            auto colonNode = make_shared<TerminalNode>(":",
+            auto colonNode = wrappers.make<TerminalNode>(":",
                 elsePart->else_block->line_number, elsePart->else_block->column_number);
             children.push_back(colonNode);
 
@@ -642,19 +792,19 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::CONDITION_NODE: {
-        auto condNode = static_cast<ConditionNode*>(node.get());
+        auto condNode = static_cast<ConditionNode*>(node);
         if (condNode->condition) {
             // Check if this is a binary expression with logical operators (and, or)
             if (condNode->condition->type == NodeType::BINARY_EXPR) {
-                auto binary = static_cast<BinaryExprNode*>(condNode->condition.get());
+                auto binary = static_cast<BinaryExprNode*>(condNode->condition);
 
                 // Check if operator is a logical operator (and, or)
-                if (binary->op == "and" || binary->op == "or") {
+                if (binary->op == LEX_AND || binary->op == LEX_OR) {
                     // Flatten the structure - add left operand directly
                     children.push_back(binary->left);
 
                     // Add the operator as a terminal node
-                    auto opNode = make_shared<TerminalNode>(binary->op, binary->line_number, binary->column_number);
+                    auto opNode = wrappers.make<TerminalNode>(lexemeText(binary->op), binary->line_number, binary->column_number);
                     children.push_back(opNode);
 
                     // Add right operand directly
@@ -663,8 +813,8 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
                 // Keep existing comparison operator handling
                 else if (isComparisonOperator(binary->op)) {
                     // Wrap it in a ComparisonExprNode (same as your existing code)
-                    auto compNode = make_shared<ComparisonExprNode>(
-                        make_shared<BinaryExprNode>(*binary));
+                    auto compNode = wrappers.make<ComparisonExprNode>(
+                        wrappers.make<BinaryExprNode>(*binary));
                     children.push_back(compNode);
                 } else {
                     // Regular binary expression (same as your existing code)
@@ -673,12 +823,12 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
             }
             // Handle unary "not" operator
             else if (condNode->condition->type == NodeType::UNARY_EXPR) {
-                auto unary = static_cast<UnaryExprNode*>(condNode->condition.get());
+                auto unary = static_cast<UnaryExprNode*>(condNode->condition);
 
                 // Check if this is the "not" operator
-                if (unary->op == "not") {
+                if (unary->op == LEX_NOT) {
                     // Add the "not" operator as a terminal node
-                    auto notNode = make_shared<TerminalNode>("not", unary->line_number, unary->column_number);
+                    auto notNode = wrappers.make<TerminalNode>("not", unary->line_number, unary->column_number);
                     children.push_back(notNode);
 
                     // Add the operand directly
@@ -697,10 +847,10 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::ELIF_CLAUSE: {
-        auto elif = static_cast<ElifNode*>(node.get());
+        auto elif = static_cast<ElifNode*>(node);
 
         // Create a virtual condition node for elif as well
-        auto conditionNode = make_shared<ConditionNode>(
+        auto conditionNode = wrappers.make<ConditionNode>(
             elif->condition, elif->line_number, elif->column_number);
 
         children.push_back(conditionNode);
@@ -709,35 +859,35 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::ELSE_CLAUSE:
-        children.push_back(static_cast<ElseNode*>(node.get())->block);
+        children.push_back(static_cast<ElseNode*>(node)->block);
         break;
 
     case NodeType::WHILE_STMT: {
-        auto whileNode = static_cast<WhileNode*>(node.get());
+        auto whileNode = static_cast<WhileNode*>(node);
 
         // Create a terminal node for "while" keyword
-        auto whileKeywordNode = make_shared<TerminalNode>("while", whileNode->line_number, whileNode->column_number);
+        auto whileKeywordNode = wrappers.make<TerminalNode>("while", whileNode->line_number, whileNode->column_number);
         children.push_back(whileKeywordNode);
 
         // Add left parenthesis if present
         if (whileNode->hasParentheses) {
-            auto leftParenNode = make_shared<TerminalNode>("(", whileNode->line_number, whileNode->column_number);
+            auto leftParenNode = wrappers.make<TerminalNode>("(", whileNode->line_number, whileNode->column_number);
             children.push_back(leftParenNode);
         }
 
         // Create a condition wrapper node
-        auto conditionNode = make_shared<ConditionNode>(
+        auto conditionNode = wrappers.make<ConditionNode>(
             whileNode->condition, whileNode->line_number, whileNode->column_number);
         children.push_back(conditionNode);
 
         // Add right parenthesis if present
         if (whileNode->hasParentheses) {
-            auto rightParenNode = make_shared<TerminalNode>(")", whileNode->line_number, whileNode->column_number);
+            auto rightParenNode = wrappers.make<TerminalNode>(")", whileNode->line_number, whileNode->column_number);
             children.push_back(rightParenNode);
         }
 
         // Add colon
-        auto colonNode = make_shared<TerminalNode>(":", whileNode->line_number, whileNode->column_number);
+        auto colonNode = wrappers.make<TerminalNode>(":", whileNode->line_number, whileNode->column_number);
         children.push_back(colonNode);
 
         // Add the block
@@ -746,15 +896,15 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::FOR_STMT: {
-        auto forNode = static_cast<ForNode*>(node.get());
+        auto forNode = static_cast<ForNode*>(node);
 
         // Create a terminal node for "for" keyword
-        auto forKeywordNode = make_shared<TerminalNode>("for", forNode->line_number, forNode->column_number);
+        auto forKeywordNode = wrappers.make<TerminalNode>("for", forNode->line_number, forNode->column_number);
         children.push_back(forKeywordNode);
 
         // Add left parenthesis if present
         if (forNode->hasParentheses) {
-            auto leftParenNode = make_shared<TerminalNode>("(", forNode->line_number, forNode->column_number);
+            auto leftParenNode = wrappers.make<TerminalNode>("(", forNode->line_number, forNode->column_number);
             children.push_back(leftParenNode);
         }
 
@@ -762,7 +912,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         children.push_back(forNode->target);
 
         // Add "in" keyword
-        auto inKeywordNode = make_shared<TerminalNode>("in", forNode->line_number, forNode->column_number);
+        auto inKeywordNode = wrappers.make<TerminalNode>("in", forNode->line_number, forNode->column_number);
         children.push_back(inKeywordNode);
 
         // Add iterable expression
@@ -770,12 +920,12 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // Add right parenthesis if present
         if (forNode->hasParentheses) {
-            auto rightParenNode = make_shared<TerminalNode>(")", forNode->line_number, forNode->column_number);
+            auto rightParenNode = wrappers.make<TerminalNode>(")", forNode->line_number, forNode->column_number);
             children.push_back(rightParenNode);
         }
 
         // Add colon
-        auto colonNode = make_shared<TerminalNode>(":", forNode->line_number, forNode->column_number);
+        auto colonNode = wrappers.make<TerminalNode>(":", forNode->line_number, forNode->column_number);
         children.push_back(colonNode);
 
         // Add the block
@@ -785,7 +935,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // Update the FUNC_DEF case in getNodeChildren
         case NodeType::FUNC_DEF: {
-        auto funcDef = static_cast<FunctionDefNode*>(node.get());
+        auto funcDef = static_cast<FunctionDefNode*>(node);
 
         // First show the 'def' keyword terminal
         if (funcDef->defKeyword) {
@@ -821,7 +971,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         }
 
     case NodeType::PARAM_LIST: {
-        auto paramList = static_cast<ParamListNode*>(node.get());
+        auto paramList = static_cast<ParamListNode*>(node);
         for (const auto& param : paramList->parameters) {
             children.push_back(param);
         }
@@ -829,7 +979,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     // case NodeType::RETURN_STMT: {
-    //     // auto ret = static_cast<ReturnNode*>(node.get());
+    //     // auto ret = static_cast<ReturnNode*>(node);
     //     // if (ret->expression) {
     //     //     children.push_back(ret->expression);
     //     // }
@@ -837,16 +987,16 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     // }
 
     case NodeType::RETURN_STMT: {
-            auto returnNode = static_cast<ReturnNode*>(node.get());
+            auto returnNode = static_cast<ReturnNode*>(node);
 
             // Add "return" keyword as a terminal node
-            auto returnKeyword = make_shared<TerminalNode>("return",
+            auto returnKeyword = wrappers.make<TerminalNode>("return",
                 returnNode->line_number, returnNode->column_number);
             children.push_back(returnKeyword);
 
             // If there's an expression, wrap it in an ExpressionNode
             if (returnNode->expression) {
-                auto expNode = make_shared<ExpressionNode>(returnNode->expression);
+                auto expNode = wrappers.make<ExpressionNode>(returnNode->expression);
                 children.push_back(expNode);
             }
 
@@ -854,21 +1004,21 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::UNARY_EXPR:
-        children.push_back(static_cast<UnaryExprNode*>(node.get())->operand);
+        children.push_back(static_cast<UnaryExprNode*>(node)->operand);
         break;
 
     case NodeType::CALL_EXPR: {
-        auto call = static_cast<CallExprNode*>(node.get());
+        auto call = static_cast<CallExprNode*>(node);
 
         // Check if the function is an attribute reference (method call)
         if (call->function->type == NodeType::ATTR_REF) {
-            auto attrRef = static_pointer_cast<AttrRefNode>(call->function);
+            auto attrRef = static_cast<AttrRefNode*>(call->function);
 
             // Add the object directly (e.g., "results")
             children.push_back(attrRef->object);
 
             // Add the attribute as a terminal node (e.g., ".append")
-            auto methodNode = make_shared<TerminalNode>("." + attrRef->attribute,
+            auto methodNode = wrappers.make<TerminalNode>(wrappers.copy("." + string(attrRef->attribute)),
                 call->line_number, call->column_number);
             children.push_back(methodNode);
         }
@@ -891,13 +1041,13 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::SUBSCRIPT_EXPR: {
-        auto subscript = static_cast<SubscriptExprNode*>(node.get());
+        auto subscript = static_cast<SubscriptExprNode*>(node);
 
         // Add the container (e.g., "my_list")
         children.push_back(subscript->container);
 
         // Add opening bracket as a terminal node
-        auto leftBracketNode = make_shared<TerminalNode>("[",
+        auto leftBracketNode = wrappers.make<TerminalNode>("[",
             subscript->line_number, subscript->column_number);
         children.push_back(leftBracketNode);
 
@@ -905,7 +1055,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
         children.push_back(subscript->index);
 
         // Add closing bracket as a terminal node
-        auto rightBracketNode = make_shared<TerminalNode>("]",
+        auto rightBracketNode = wrappers.make<TerminalNode>("]",
             subscript->line_number, subscript->column_number);
         children.push_back(rightBracketNode);
 
@@ -913,20 +1063,20 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::ATTR_REF:
-        children.push_back(static_cast<AttrRefNode*>(node.get())->object);
+        children.push_back(static_cast<AttrRefNode*>(node)->object);
         break;
 
     case NodeType::LIST_LITERAL: {
-            auto listNode = static_cast<ListNode*>(node.get());
+            auto listNode = static_cast<ListNode*>(node);
             for (auto& elem : listNode->elements) {
                 // Check if this is a unary minus expression
                 if (elem->type == NodeType::UNARY_EXPR) {
-                    auto unary = static_pointer_cast<UnaryExprNode>(elem);
+                    auto unary = static_cast<UnaryExprNode*>(elem);
 
                     // Handle all unary minus expressions, not just on literals
-                    if (unary->op == "-") {
+                    if (unary->op == LEX_MINUS) {
                         // Add the minus sign as a separate terminal node
-                        auto minusNode = make_shared<TerminalNode>("-",
+                        auto minusNode = wrappers.make<TerminalNode>("-",
                             unary->line_number, unary->column_number);
                         children.push_back(minusNode);
 
@@ -945,17 +1095,17 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::DICT_LITERAL: {
-            auto dictNode = static_cast<DictNode*>(node.get());
+            auto dictNode = static_cast<DictNode*>(node);
 
             for (const auto& item : dictNode->items) {
                 // Process key
                 if (item.first) {
                     if (item.first->type == NodeType::UNARY_EXPR) {
-                        auto unary = static_pointer_cast<UnaryExprNode>(item.first);
+                        auto unary = static_cast<UnaryExprNode*>(item.first);
 
-                        if (unary->op == "-") {
+                        if (unary->op == LEX_MINUS) {
                             // Add minus sign
-                            auto minusNode = make_shared<TerminalNode>("-",
+                            auto minusNode = wrappers.make<TerminalNode>("-",
                                 unary->line_number, unary->column_number);
                             children.push_back(minusNode);
 
@@ -972,11 +1122,11 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
                 // Process value
                 if (item.second) {
                     if (item.second->type == NodeType::UNARY_EXPR) {
-                        auto unary = static_pointer_cast<UnaryExprNode>(item.second);
+                        auto unary = static_cast<UnaryExprNode*>(item.second);
 
-                        if (unary->op == "-") {
+                        if (unary->op == LEX_MINUS) {
                             // Add minus sign
-                            auto minusNode = make_shared<TerminalNode>("-",
+                            auto minusNode = wrappers.make<TerminalNode>("-",
                                 unary->line_number, unary->column_number);
                             children.push_back(minusNode);
 
@@ -994,16 +1144,16 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::ARG_LIST: {
-            auto argList = static_cast<ArgListNode*>(node.get());
+            auto argList = static_cast<ArgListNode*>(node);
             for (auto& arg : argList->arguments) {
                 // Check if this is a unary minus expression
                 if (arg->type == NodeType::UNARY_EXPR) {
-                    auto unary = static_pointer_cast<UnaryExprNode>(arg);
+                    auto unary = static_cast<UnaryExprNode*>(arg);
 
                     // Handle all unary minus expressions, not just on literals
-                    if (unary->op == "-") {
+                    if (unary->op == LEX_MINUS) {
                         // Add the minus sign as a separate terminal node
-                        auto minusNode = make_shared<TerminalNode>("-",
+                        auto minusNode = wrappers.make<TerminalNode>("-",
                             unary->line_number, unary->column_number);
                         children.push_back(minusNode);
 
@@ -1022,7 +1172,7 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     }
 
     case NodeType::PARAMETER_NODE: {
-        auto param = static_cast<ParameterNode*>(node.get());
+        auto param = static_cast<ParameterNode*>(node);
 
         // If this is a comma, don't add any children
         if (param->name == ",") {
@@ -1032,21 +1182,21 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
 
         // For regular parameters without default values, just add name as child
         if (!param->default_value) {
-            auto nameNode = make_shared<IdentifierNode>(param->name, param->line_number, param->column_number);
+            auto nameNode = wrappers.make<IdentifierNode>(param->name, param->line_number, param->column_number);
             children.push_back(nameNode);
             break;
         }
 
         // For parameters with default values, create the name-equals-value structure
-        auto nameNode = make_shared<IdentifierNode>(param->name, param->line_number, param->column_number);
+        auto nameNode = wrappers.make<IdentifierNode>(param->name, param->line_number, param->column_number);
         children.push_back(nameNode);
 
-        auto equalsNode = make_shared<TerminalNode>("=", param->line_number, param->column_number);
+        auto equalsNode = wrappers.make<TerminalNode>("=", param->line_number, param->column_number);
         children.push_back(equalsNode);
 
         // Add the default value, bypassing any StatementList wrapper
         if (param->default_value->type == NodeType::STATEMENT_LIST) {
-            auto stmtList = static_cast<StatementListNode*>(param->default_value.get());
+            auto stmtList = static_cast<StatementListNode*>(param->default_value);
             if (stmtList->statements.size() > 1) {
                 children.push_back(stmtList->statements[1]);
             }
@@ -1059,11 +1209,9 @@ vector<shared_ptr<ASTNode>> ParseTreeWidget::getNodeChildren(shared_ptr<ASTNode>
     default:
         break;
     }
-
-    return children;
 }
 
-QString ParseTreeWidget::getNodeLabel(shared_ptr<ASTNode> node) {
+QString ParseTreeWidget::getNodeLabel(ASTNode* node) {
     // Return a concise label based on node type
     switch (node->type) {
     case NodeType::PROGRAM:
@@ -1095,16 +1243,16 @@ QString ParseTreeWidget::getNodeLabel(shared_ptr<ASTNode> node) {
     case NodeType::RETURN_STMT:
         return "return-stmt";
     case NodeType::IMPORT_STMT: {
-        auto import = static_pointer_cast<ImportNode>(node);
-        return QString("%1").arg(import->module.c_str());
+        auto import = static_cast<ImportNode*>(node);
+        return toQString(import->module);
     }
     case NodeType::BINARY_EXPR: {
-        auto binary = static_pointer_cast<BinaryExprNode>(node);
-        return QString::fromStdString(binary->op);
+        auto binary = static_cast<BinaryExprNode*>(node);
+        return toQString(lexemeText(binary->op));
     }
     case NodeType::UNARY_EXPR: {
-        auto unary = static_pointer_cast<UnaryExprNode>(node);
-        return QString::fromStdString(unary->op);
+        auto unary = static_cast<UnaryExprNode*>(node);
+        return toQString(lexemeText(unary->op));
     }
     case NodeType::GROUP_EXPR:
         return "group";
@@ -1113,16 +1261,16 @@ QString ParseTreeWidget::getNodeLabel(shared_ptr<ASTNode> node) {
     case NodeType::SUBSCRIPT_EXPR:
         return "subscript";
     case NodeType::ATTR_REF: {
-        auto attr = static_pointer_cast<AttrRefNode>(node);
-        return QString(".%1").arg(attr->attribute.c_str());
+        auto attr = static_cast<AttrRefNode*>(node);
+        return "." + toQString(attr->attribute);
     }
     case NodeType::IDENTIFIER: {
-        auto id = static_pointer_cast<IdentifierNode>(node);
-        return QString::fromStdString(id->name);
+        auto id = static_cast<IdentifierNode*>(node);
+        return toQString(id->name);
     }
     case NodeType::LITERAL: {
-        auto literal = static_pointer_cast<LiteralNode>(node);
-        QString value = QString::fromStdString(literal->value);
+        auto literal = static_cast<LiteralNode*>(node);
+        QString value = toQString(literal->value);
         // Truncate long values
         if (value.length() > 8) {
             value = value.left(6) + "...";
@@ -1131,12 +1279,12 @@ QString ParseTreeWidget::getNodeLabel(shared_ptr<ASTNode> node) {
     }
 
     case NodeType::TERMINAL: {
-    auto terminal = static_pointer_cast<TerminalNode>(node);
-    return QString::fromStdString(terminal->value);
+    auto terminal = static_cast<TerminalNode*>(node);
+    return toQString(terminal->value);
     }
 
     case NodeType::PARAMETER_NODE: {
-        auto param = static_cast<ParameterNode*>(node.get());
+        auto param = static_cast<ParameterNode*>(node);
 
         // Check if this is a comma (special case in your parser)
         if (param->name == ",") {
@@ -1168,10 +1316,9 @@ QString ParseTreeWidget::getNodeLabel(shared_ptr<ASTNode> node) {
     }
 }
 
-int ParseTreeWidget::calculateNodeWidth(const QString &text) {
-    QFontMetrics fm(font());
+int ParseTreeWidget::calculateNodeWidth(const QFontMetrics &metrics, const QString &text) {
     // Further reduced minimum width from 70 to 60, and padding from 40 to 30
-    return max(60, fm.horizontalAdvance(text) + 30);
+    return max(60, metrics.horizontalAdvance(text) + 30);
 }
 
 void ParseTreeWidget::wheelEvent(QWheelEvent *event) {
@@ -1203,6 +1350,7 @@ void ParseTreeWidget::mousePressEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
         isDragging = true;
         dragStart = event->pos();
+        pressPos = event->pos();
         setCursor(Qt::ClosedHandCursor);
     }
 }
@@ -1219,5 +1367,51 @@ void ParseTreeWidget::mouseReleaseEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton && isDragging) {
         isDragging = false;
         setCursor(Qt::OpenHandCursor);
+        // A click rather than a drag opens or closes the node under it
+        if ((event->pos() - pressPos).manhattanLength() <= clickDistance) {
+            toggleNode(event->pos());
+        }
+    }
+}
+
+int ParseTreeWidget::nodeAt(const QPoint &pos) const {
+    if (layoutNodes.empty()) return -1;
+    QPointF scenePos = (QPointF(pos) - QPointF(offset)) / scale;
+    const QPoint point(static_cast<int>(floor(scenePos.x())), static_cast<int>(floor(scenePos.y())));
+    if (point.y() < 0 || point.x() < gridLeft) return -1;
+    const int row = point.y() / levelHeight;
+    const int column = (point.x() - gridLeft) / gridCellWidth;
+    if (row >= gridRows || column >= gridColumns) return -1;
+
+    // Where boxes overlap, the one drawn last is on top
+    int hit = -1;
+    const int cell = row * gridColumns + column;
+    for (int i = gridStart[cell]; i < gridStart[cell + 1]; i++) {
+        if (layoutNodes[gridItems[i]].rect.contains(point)) hit = gridItems[i];
+    }
+    return hit;
+}
+
+void ParseTreeWidget::toggleNode(const QPoint &pos) {
+    const int hit = nodeAt(pos);
+    if (hit < 0) return;
+    const int index = layoutNodes[hit].view;
+    if (viewNodes[index].childCount == 0) return;
+    const QPoint before = layoutNodes[hit].rect.topLeft();
+
+    if (viewNodes[index].expanded) {
+        viewNodes[index].expanded = false;
+    } else {
+        expandNode(index);
     }
+    layoutTree();
+
+    // Keep the clicked node under the mouse
+    for (const LayoutNode& node : layoutNodes) {
+        if (node.view == index) {
+            offset -= (QPointF(node.rect.topLeft() - before) * scale).toPoint();
+            break;
+        }
+    }
+    update();
 }
\ No newline at end of file
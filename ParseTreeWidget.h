@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include <QPainter>
+#include <QFontMetrics>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <memory>
@@ -13,8 +14,10 @@ class ParseTreeWidget : public QWidget {
 
 public:
     explicit ParseTreeWidget(QWidget *parent = nullptr);
-    void setParseTree(std::shared_ptr<ASTNode> root);
-    std::shared_ptr<ASTNode> getCurrentTree() const { return root; }
+    void setParseTree(std::shared_ptr<const ParseResult> tree);
+    ASTNode* getCurrentTree() const { return tree ? tree->root : nullptr; }
+    // How many levels setParseTree() opens; deeper nodes open on click
+    void setExpandedLevels(int levels) { expandedLevels = levels; }
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -22,19 +25,69 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+    void changeEvent(QEvent *event) override;
 
 private:
-    std::shared_ptr<ASTNode> root;
+    // One node of the tree as displayed: an AST node, or a wrapper or
+    // terminal node that getNodeChildren adds for display
+    struct ViewNode {
+        ASTNode* node;      // null for a missing child, drawn as an edge only
+        int level;
+        int firstChild;     // children are viewNodes[firstChild, firstChild + childCount)
+        int childCount;
+        bool explored;      // its children have been added
+        bool expanded;      // its children are shown
+        QString label;
+        QColor color;
+    };
+    // A drawn box, in scene coordinates, with the edges down to its children
+    struct LayoutNode {
+        QRect rect;
+        int view;           // index into viewNodes
+        int firstEdge;      // edges are layoutEdges[firstEdge, firstEdge + edgeCount)
+        int edgeCount;
+        int firstColumn;    // leftmost grid column it is listed in
+    };
+
+    std::shared_ptr<const ParseResult> tree;
+    // The display tree, started by buildViewTree() and grown as nodes
+    // are expanded
+    std::vector<ViewNode> viewNodes;
+    AstArena wrappers;  // display-only nodes that viewNodes refer to
+    std::vector<ASTNode*> childBuffer;
+    int expandedLevels = 4;
+    // Geometry of the shown nodes, computed by layoutTree() when the tree,
+    // the font or what is expanded changes; painting only draws these
+    std::vector<LayoutNode> layoutNodes;
+    std::vector<QLine> layoutEdges;
+    int labelHeight = 0;
+    // Grid over the layout for culling, one row per tree level: cell
+    // (row, column) lists layoutNodes indices in
+    // gridItems[gridStart[cell], gridStart[cell + 1])
+    int gridLeft = 0;
+    int gridColumns = 0;
+    int gridRows = 0;
+    std::vector<int> gridStart;
+    std::vector<int> gridItems;
+    // What paintEvent found visible; kept to reuse their storage
+    std::vector<int> visibleNodes;
+    std::vector<QLine> visibleEdges;
     double scale;
     QPoint offset;
     QPoint dragStart;
+    QPoint pressPos;
     bool isDragging;
 
-    void drawNode(QPainter &painter, std::shared_ptr<ASTNode> node, int x, int y, int level);
-    std::vector<std::shared_ptr<ASTNode>> getNodeChildren(std::shared_ptr<ASTNode> node);
-    QString getNodeLabel(std::shared_ptr<ASTNode> node);
-    int calculateNodeWidth(const QString &text);
-    int calculateSubtreeWidth(std::shared_ptr<ASTNode> node, int level);
+    void buildViewTree();
+    void exploreNode(int index);
+    void expandNode(int index);
+    int nodeAt(const QPoint &pos) const;
+    void toggleNode(const QPoint &pos);
+    void layoutTree();
+    void indexLayout();
+    void getNodeChildren(ASTNode* node, std::vector<ASTNode*>& children);
+    QString getNodeLabel(ASTNode* node);
+    int calculateNodeWidth(const QFontMetrics &metrics, const QString &text);
 };
 
 #endif // PARSETREEWIDGET_H
@@ -0,0 +1,623 @@
+// astfile.cpp
+
+#include "astfile.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// --- Writing ---
+namespace {
+
+class AstFileWriter {
+public:
+    string write(const ASTNode* root);
+
+private:
+    static constexpr size_t NO_SLOT = SIZE_MAX;
+
+    vector<AstFileNode> nodes;
+    vector<uint32_t> children;
+    string strings;
+    unordered_map<string_view, uint32_t> string_offsets;
+    // Nodes still to be written, each with the child slot that gets its index
+    vector<pair<const ASTNode*, size_t>> pending;
+    vector<const ASTNode*> slots;    // children of the node being written
+
+    AstFileString intern(string_view text);
+    void describe(const ASTNode* node, AstFileNode& record);
+};
+
+AstFileString AstFileWriter::intern(string_view text) {
+    // Keys view the tree being written, which outlives the writer
+    auto [it, added] = string_offsets.try_emplace(text, static_cast<uint32_t>(strings.size()));
+    if (added) strings += text;
+    return {it->second, static_cast<uint32_t>(text.size())};
+}
+
+// Fills in the record's type-specific fields and collects its children in
+// `slots`, in the order listed in astfile.h.
+void AstFileWriter::describe(const ASTNode* node, AstFileNode& record) {
+    switch (node->type) {
+    case NodeType::PROGRAM:
+        for (ASTNode* statement : static_cast<const ProgramNode*>(node)->statements) slots.push_back(statement);
+        break;
+    case NodeType::STATEMENT_LIST:
+        for (ASTNode* statement : static_cast<const StatementListNode*>(node)->statements) slots.push_back(statement);
+        break;
+    case NodeType::BLOCK:
+        slots.push_back(static_cast<const BlockNode*>(node)->statements);
+        break;
+    case NodeType::STATEMENT:
+        slots.push_back(static_cast<const StatementNode*>(node)->statement);
+        break;
+    case NodeType::ASSIGNMENT_STMT: {
+        auto assign = static_cast<const AssignmentNode*>(node);
+        record.op = static_cast<uint16_t>(assign->op);
+        slots.push_back(assign->target);
+        slots.push_back(assign->value);
+        break;
+    }
+    case NodeType::IF_STMT: {
+        auto ifNode = static_cast<const IfNode*>(node);
+        record.flags = ifNode->hasParentheses ? AST_FILE_PARENTHESES : 0;
+        slots.push_back(ifNode->condition);
+        slots.push_back(ifNode->if_block);
+        slots.push_back(ifNode->else_block);
+        for (ElifNode* elif : ifNode->elif_clauses) slots.push_back(elif);
+        break;
+    }
+    case NodeType::ELIF_CLAUSE: {
+        auto elif = static_cast<const ElifNode*>(node);
+        record.flags = elif->hasParentheses ? AST_FILE_PARENTHESES : 0;
+        slots.push_back(elif->condition);
+        slots.push_back(elif->block);
+        break;
+    }
+    case NodeType::ELSE_CLAUSE:
+        slots.push_back(static_cast<const ElseNode*>(node)->block);
+        break;
+    case NodeType::ELSE_PART: {
+        auto elsePart = static_cast<const ElsePartNode*>(node);
+        slots.push_back(elsePart->else_block);
+        for (ElifNode* elif : elsePart->elif_clauses) slots.push_back(elif);
+        break;
+    }
+    case NodeType::WHILE_STMT: {
+        auto whileNode = static_cast<const WhileNode*>(node);
+        record.flags = whileNode->hasParentheses ? AST_FILE_PARENTHESES : 0;
+        slots.push_back(whileNode->condition);
+        slots.push_back(whileNode->block);
+        break;
+    }
+    case NodeType::FOR_STMT: {
+        auto forNode = static_cast<const ForNode*>(node);
+        record.flags = forNode->hasParentheses ? AST_FILE_PARENTHESES : 0;
+        slots.push_back(forNode->target);
+        slots.push_back(forNode->iterable);
+        slots.push_back(forNode->block);
+        break;
+    }
+    case NodeType::FUNC_DEF: {
+        auto funcDef = static_cast<const FunctionDefNode*>(node);
+        record.text[0] = intern(funcDef->name);
+        slots.push_back(funcDef->params);
+        slots.push_back(funcDef->body);
+        slots.push_back(funcDef->defKeyword);
+        slots.push_back(funcDef->nameNode);
+        slots.push_back(funcDef->openParen);
+        slots.push_back(funcDef->closeParen);
+        slots.push_back(funcDef->colon);
+        break;
+    }
+    case NodeType::RETURN_STMT:
+        slots.push_back(static_cast<const ReturnNode*>(node)->expression);
+        break;
+    case NodeType::IMPORT_STMT: {
+        auto import = static_cast<const ImportNode*>(node);
+        record.text[0] = intern(import->module);
+        record.text[1] = intern(import->alias);
+        break;
+    }
+    case NodeType::BINARY_EXPR: {
+        auto binary = static_cast<const BinaryExprNode*>(node);
+        record.op = static_cast<uint16_t>(binary->op);
+        slots.push_back(binary->left);
+        slots.push_back(binary->right);
+        break;
+    }
+    case NodeType::UNARY_EXPR: {
+        auto unary = static_cast<const UnaryExprNode*>(node);
+        record.op = static_cast<uint16_t>(unary->op);
+        slots.push_back(unary->operand);
+        break;
+    }
+    case NodeType::CALL_EXPR: {
+        auto call = static_cast<const CallExprNode*>(node);
+        slots.push_back(call->function);
+        slots.push_back(call->arguments);
+        slots.push_back(call->openParen);
+        slots.push_back(call->closeParen);
+        break;
+    }
+    case NodeType::SUBSCRIPT_EXPR: {
+        auto subscript = static_cast<const SubscriptExprNode*>(node);
+        slots.push_back(subscript->container);
+        slots.push_back(subscript->index);
+        break;
+    }
+    case NodeType::ATTR_REF: {
+        auto attr = static_cast<const AttrRefNode*>(node);
+        record.text[0] = intern(attr->attribute);
+        slots.push_back(attr->object);
+        break;
+    }
+    case NodeType::EXPRESSION:
+        slots.push_back(static_cast<const ExpressionNode*>(node)->expression);
+        break;
+    case NodeType::GROUP_EXPR:
+        slots.push_back(static_cast<const GroupExprNode*>(node)->expression);
+        break;
+    case NodeType::ASSIGNMENT_WRAPPER:
+        slots.push_back(static_cast<const AssignStmtNode*>(node)->assignment);
+        break;
+    case NodeType::COMPARISON_WRAPPER:
+        slots.push_back(static_cast<const ComparisonExprNode*>(node)->comparison);
+        break;
+    case NodeType::CONDITION_NODE:
+        slots.push_back(static_cast<const ConditionNode*>(node)->condition);
+        break;
+    case NodeType::IDENTIFIER:
+        record.text[0] = intern(static_cast<const IdentifierNode*>(node)->name);
+        break;
+    case NodeType::LITERAL: {
+        auto literal = static_cast<const LiteralNode*>(node);
+        record.text[0] = intern(literal->value);
+        record.text[1] = intern(literal->type);
+        break;
+    }
+    case NodeType::LIST_LITERAL:
+        for (ASTNode* element : static_cast<const ListNode*>(node)->elements) slots.push_back(element);
+        break;
+    case NodeType::DICT_LITERAL:
+        for (const auto& item : static_cast<const DictNode*>(node)->items) {
+            slots.push_back(item.first);
+            slots.push_back(item.second);
+        }
+        break;
+    case NodeType::PARAM_LIST:
+        for (ParameterNode* param : static_cast<const ParamListNode*>(node)->parameters) slots.push_back(param);
+        break;
+    case NodeType::PARAMETER_NODE: {
+        auto param = static_cast<const ParameterNode*>(node);
+        record.text[0] = intern(param->name);
+        slots.push_back(param->default_value);
+        break;
+    }
+    case NodeType::ARG_LIST:
+        for (ASTNode* arg : static_cast<const ArgListNode*>(node)->arguments) slots.push_back(arg);
+        break;
+    case NodeType::TERMINAL:
+        record.text[0] = intern(static_cast<const TerminalNode*>(node)->value);
+        break;
+    case NodeType::ERROR_NODE:
+        record.text[0] = intern(static_cast<const ErrorNode*>(node)->message);
+        break;
+    }
+}
+
+string AstFileWriter::write(const ASTNode* root) {
+    // Pre-order with an explicit stack: a node's index is known once it is
+    // popped, and is then patched into the slot its parent reserved for it
+    if (root) pending.push_back({root, NO_SLOT});
+    while (!pending.empty()) {
+        auto [node, slot] = pending.back();
+        pending.pop_back();
+
+        auto index = static_cast<uint32_t>(nodes.size());
+        if (slot != NO_SLOT) children[slot] = index;
+
+        AstFileNode record{};
+        record.type = static_cast<uint8_t>(node->type);
+        record.line_number = node->line_number;
+        record.column_number = node->column_number;
+        slots.clear();
+        describe(node, record);
+
+        record.first_child = static_cast<uint32_t>(children.size());
+        record.child_count = static_cast<uint32_t>(slots.size());
+        children.resize(children.size() + slots.size(), AST_FILE_NONE);
+        nodes.push_back(record);
+
+        // Reversed, so that the first child is written next
+        for (size_t i = slots.size(); i-- > 0;) {
+            if (slots[i]) pending.push_back({slots[i], record.first_child + i});
+        }
+    }
+
+    AstFileHeader header{};
+    header.magic = AST_FILE_MAGIC;
+    header.version = AST_FILE_VERSION;
+    header.node_count = static_cast<uint32_t>(nodes.size());
+    header.child_count = static_cast<uint32_t>(children.size());
+    header.string_bytes = static_cast<uint32_t>(strings.size());
+
+    string file;
+    file.reserve(sizeof(header) + nodes.size() * sizeof(AstFileNode) + children.size() * sizeof(uint32_t)
+                 + strings.size());
+    file.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.append(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(AstFileNode));
+    file.append(reinterpret_cast<const char*>(children.data()), children.size() * sizeof(uint32_t));
+    file += strings;
+    return file;
+}
+
+} // namespace
+
+string serializeAst(const ASTNode* root) {
+    return AstFileWriter().write(root);
+}
+
+void saveAstFile(const ASTNode* root, const string& path) {
+    string file = serializeAst(root);
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.write(file.data(), static_cast<streamsize>(file.size())) || !out.flush()) {
+        throw runtime_error("Could not write file: " + path);
+    }
+}
+
+// --- Reading ---
+void AstFile::openFile(const string& path) {
+    auto file = make_unique<SourceBuffer>();
+    file->mapFile(path);
+    open(file->text);
+    mapping = move(file);
+}
+
+void AstFile::open(string_view bytes) {
+    mapping.reset();
+    header = nullptr;
+    nodes = nullptr;
+    children = nullptr;
+    strings = nullptr;
+
+    if (bytes.size() < sizeof(AstFileHeader)) {
+        throw runtime_error("Not an AST file: too short");
+    }
+    auto file_header = reinterpret_cast<const AstFileHeader*>(bytes.data());
+    if (file_header->magic != AST_FILE_MAGIC) {
+        throw runtime_error("Not an AST file (or written on a machine of the other byte order)");
+    }
+    if (file_header->version != AST_FILE_VERSION) {
+        throw runtime_error("Unsupported AST file version " + to_string(file_header->version));
+    }
+    uint64_t expected = sizeof(AstFileHeader) + uint64_t(file_header->node_count) * sizeof(AstFileNode)
+                        + uint64_t(file_header->child_count) * sizeof(uint32_t) + file_header->string_bytes;
+    if (bytes.size() != expected) {
+        throw runtime_error("AST file is truncated or has trailing data");
+    }
+
+    header = file_header;
+    nodes = reinterpret_cast<const AstFileNode*>(bytes.data() + sizeof(AstFileHeader));
+    children = reinterpret_cast<const uint32_t*>(nodes + header->node_count);
+    strings = reinterpret_cast<const char*>(children + header->child_count);
+}
+
+AstFile::Node::Node(const AstFile* file, uint32_t index)
+    : file(file), record(file->nodes + index), index(index) {}
+
+size_t AstFile::Node::childCount() const {
+    // Clamped to the child section, so a damaged count cannot send a caller
+    // through billions of empty slots
+    uint32_t slots = file->header->child_count;
+    if (record->first_child >= slots) return 0;
+    return min(record->child_count, slots - record->first_child);
+}
+
+AstFile::Node AstFile::Node::child(size_t i) const {
+    if (i >= childCount()) return Node();
+    uint32_t slot = record->first_child + static_cast<uint32_t>(i);
+    uint32_t child = file->children[slot];
+    // Children always come after their parent, so no walk can cycle
+    if (child == AST_FILE_NONE || child <= index || child >= file->header->node_count) return Node();
+    return Node(file, child);
+}
+
+string_view AstFile::Node::text(size_t i) const {
+    if (i >= 2) return {};
+    const AstFileString& text = record->text[i];
+    if (uint64_t(text.offset) + text.length > file->header->string_bytes) return {};
+    return string_view(file->strings + text.offset, text.length);
+}
+
+namespace {
+
+// Children a node type must have: exactly `count`, or at least `count`
+// when `variable` (with DICT_LITERAL's in pairs)
+struct Arity {
+    uint32_t count;
+    bool variable;
+};
+
+Arity arityOf(NodeType type) {
+    switch (type) {
+    case NodeType::PROGRAM:
+    case NodeType::STATEMENT_LIST:
+    case NodeType::LIST_LITERAL:
+    case NodeType::DICT_LITERAL:
+    case NodeType::PARAM_LIST:
+    case NodeType::ARG_LIST:
+        return {0, true};
+    case NodeType::IF_STMT:
+        return {3, true};
+    case NodeType::ELSE_PART:
+        return {1, true};
+    case NodeType::FUNC_DEF:
+        return {7, false};
+    case NodeType::CALL_EXPR:
+        return {4, false};
+    case NodeType::FOR_STMT:
+        return {3, false};
+    case NodeType::ASSIGNMENT_STMT:
+    case NodeType::ELIF_CLAUSE:
+    case NodeType::WHILE_STMT:
+    case NodeType::BINARY_EXPR:
+    case NodeType::SUBSCRIPT_EXPR:
+        return {2, false};
+    case NodeType::IMPORT_STMT:
+    case NodeType::IDENTIFIER:
+    case NodeType::LITERAL:
+    case NodeType::TERMINAL:
+    case NodeType::ERROR_NODE:
+        return {0, false};
+    default:
+        return {1, false};
+    }
+}
+
+} // namespace
+
+ParseResult AstFile::load() const {
+    ParseResult result;
+    if (!header || header->node_count == 0) return result;
+
+    AstArena& arena = result.arena;
+    const uint32_t count = header->node_count;
+    // Children have higher indices than their parent, so building from the
+    // last node back finds every child already built
+    vector<ASTNode*> built(count, nullptr);
+    vector<ASTNode*> kids;
+    vector<ASTNode*> list;
+
+    auto bad = [](uint32_t index, const char* what) {
+        return runtime_error("Corrupt AST file: node " + to_string(index) + " " + what);
+    };
+
+    for (uint32_t index = count; index-- > 0;) {
+        const AstFileNode& record = nodes[index];
+        if (record.type > static_cast<uint8_t>(NodeType::ERROR_NODE)) throw bad(index, "has an unknown type");
+        auto type = static_cast<NodeType>(record.type);
+
+        Arity arity = arityOf(type);
+        if (record.child_count < arity.count || (!arity.variable && record.child_count != arity.count)
+            || (type == NodeType::DICT_LITERAL && record.child_count % 2 != 0)) {
+            throw bad(index, "has the wrong number of children");
+        }
+        if (uint64_t(record.first_child) + record.child_count > header->child_count) {
+            throw bad(index, "has children outside the file");
+        }
+
+        kids.clear();
+        for (uint32_t i = 0; i < record.child_count; ++i) {
+            uint32_t child = children[record.first_child + i];
+            if (child == AST_FILE_NONE) {
+                kids.push_back(nullptr);
+            } else if (child <= index || child >= count || !built[child]) {
+                throw bad(index, "has an invalid child");
+            } else {
+                kids.push_back(built[child]);
+                built[child] = nullptr; // every node has exactly one parent
+            }
+        }
+
+        string_view text[2];
+        for (int i = 0; i < 2; ++i) {
+            if (uint64_t(record.text[i].offset) + record.text[i].length > header->string_bytes) {
+                throw bad(index, "has text outside the file");
+            }
+            text[i] = arena.copy(string_view(strings + record.text[i].offset, record.text[i].length));
+        }
+
+        // Child slots that the node classes hold as a specific type
+        auto kidOf = [&](size_t i, NodeType required) {
+            if (kids[i] && kids[i]->type != required) throw bad(index, "has a child of the wrong type");
+            return kids[i];
+        };
+        auto required = [&](size_t i) {
+            if (!kids[i]) throw bad(index, "is missing a child");
+            return kids[i];
+        };
+        auto opcode = [&]() {
+            if (record.op >= LEX_FIRST_DYNAMIC) throw bad(index, "has an invalid operator");
+            return static_cast<OpCode>(record.op);
+        };
+        const bool parentheses = record.flags & AST_FILE_PARENTHESES;
+        const int line = record.line_number;
+        const int column = record.column_number;
+
+        ASTNode* node = nullptr;
+        switch (type) {
+        case NodeType::PROGRAM: {
+            auto program = arena.make<ProgramNode>();
+            program->statements = arena.list(kids);
+            node = program;
+            break;
+        }
+        case NodeType::STATEMENT_LIST: {
+            auto statementList = arena.make<StatementListNode>();
+            statementList->statements = arena.list(kids);
+            node = statementList;
+            break;
+        }
+        case NodeType::BLOCK: {
+            auto block = arena.make<BlockNode>();
+            block->statements = kids[0];
+            node = block;
+            break;
+        }
+        case NodeType::STATEMENT:
+            node = arena.make<StatementNode>(kids[0]);
+            break;
+        case NodeType::ASSIGNMENT_STMT:
+            node = arena.make<AssignmentNode>(kids[0], kids[1], opcode(), line, column);
+            break;
+        case NodeType::IF_STMT: {
+            auto ifNode = arena.make<IfNode>(kids[0], kids[1], line, column, parentheses);
+            ifNode->else_block = kids[2];
+            vector<ElifNode*> elifs;
+            for (size_t i = 3; i < kids.size(); ++i) {
+                elifs.push_back(static_cast<ElifNode*>(required(i) ? kidOf(i, NodeType::ELIF_CLAUSE) : nullptr));
+            }
+            ifNode->elif_clauses = arena.list(elifs);
+            node = ifNode;
+            break;
+        }
+        case NodeType::ELIF_CLAUSE:
+            node = arena.make<ElifNode>(kids[0], kids[1], line, column, parentheses);
+            break;
+        case NodeType::ELSE_CLAUSE:
+            node = arena.make<ElseNode>(kids[0], line, column);
+            break;
+        case NodeType::ELSE_PART: {
+            vector<ElifNode*> elifs;
+            for (size_t i = 1; i < kids.size(); ++i) {
+                elifs.push_back(static_cast<ElifNode*>(required(i) ? kidOf(i, NodeType::ELIF_CLAUSE) : nullptr));
+            }
+            auto elseBlock = static_cast<ElseNode*>(kidOf(0, NodeType::ELSE_CLAUSE));
+            node = arena.make<ElsePartNode>(arena.list(elifs), elseBlock, line, column);
+            break;
+        }
+        case NodeType::WHILE_STMT: {
+            auto whileNode = arena.make<WhileNode>(kids[0], nullptr, line, column, parentheses);
+            whileNode->block = kids[1];
+            node = whileNode;
+            break;
+        }
+        case NodeType::FOR_STMT: {
+            auto forNode = arena.make<ForNode>(kids[0], kids[1], nullptr, line, column, parentheses);
+            forNode->block = kids[2];
+            node = forNode;
+            break;
+        }
+        case NodeType::FUNC_DEF: {
+            auto funcDef = arena.make<FunctionDefNode>(text[0], kids[0], kids[1], line, column);
+            funcDef->defKeyword = kids[2];
+            funcDef->nameNode = kids[3];
+            funcDef->openParen = kids[4];
+            funcDef->closeParen = kids[5];
+            funcDef->colon = kids[6];
+            node = funcDef;
+            break;
+        }
+        case NodeType::RETURN_STMT:
+            node = arena.make<ReturnNode>(kids[0], line, column);
+            break;
+        case NodeType::IMPORT_STMT:
+            node = arena.make<ImportNode>(text[0], text[1], line, column);
+            break;
+        case NodeType::BINARY_EXPR:
+            node = arena.make<BinaryExprNode>(opcode(), kids[0], kids[1], line, column);
+            break;
+        case NodeType::UNARY_EXPR:
+            node = arena.make<UnaryExprNode>(opcode(), kids[0], line, column);
+            break;
+        case NodeType::CALL_EXPR: {
+            auto call = arena.make<CallExprNode>(kids[0], kids[1], line, column);
+            call->openParen = kids[2];
+            call->closeParen = kids[3];
+            node = call;
+            break;
+        }
+        case NodeType::SUBSCRIPT_EXPR:
+            node = arena.make<SubscriptExprNode>(kids[0], kids[1], line, column);
+            break;
+        case NodeType::ATTR_REF:
+            node = arena.make<AttrRefNode>(kids[0], text[0], line, column);
+            break;
+        case NodeType::EXPRESSION:
+            node = arena.make<ExpressionNode>(required(0));
+            break;
+        case NodeType::GROUP_EXPR:
+            node = arena.make<GroupExprNode>(kids[0], line, column);
+            break;
+        case NodeType::ASSIGNMENT_WRAPPER:
+            node = arena.make<AssignStmtNode>(required(0));
+            break;
+        case NodeType::COMPARISON_WRAPPER:
+            node = arena.make<ComparisonExprNode>(required(0));
+            break;
+        case NodeType::CONDITION_NODE:
+            node = arena.make<ConditionNode>(kids[0], line, column);
+            break;
+        case NodeType::IDENTIFIER:
+            node = arena.make<IdentifierNode>(text[0], line, column);
+            break;
+        case NodeType::LITERAL:
+            node = arena.make<LiteralNode>(text[0], text[1], line, column);
+            break;
+        case NodeType::LIST_LITERAL: {
+            auto listNode = arena.make<ListNode>(line, column);
+            listNode->elements = arena.list(kids);
+            node = listNode;
+            break;
+        }
+        case NodeType::DICT_LITERAL: {
+            auto dict = arena.make<DictNode>(line, column);
+            vector<pair<ASTNode*, ASTNode*>> items;
+            for (size_t i = 0; i < kids.size(); i += 2) items.emplace_back(kids[i], kids[i + 1]);
+            dict->items = arena.list(items);
+            node = dict;
+            break;
+        }
+        case NodeType::PARAM_LIST: {
+            auto params = arena.make<ParamListNode>();
+            vector<ParameterNode*> parameters;
+            for (size_t i = 0; i < kids.size(); ++i) {
+                parameters.push_back(static_cast<ParameterNode*>(required(i) ? kidOf(i, NodeType::PARAMETER_NODE) : nullptr));
+            }
+            params->parameters = arena.list(parameters);
+            node = params;
+            break;
+        }
+        case NodeType::PARAMETER_NODE:
+            node = arena.make<ParameterNode>(text[0], kids[0], line, column);
+            break;
+        case NodeType::ARG_LIST: {
+            auto args = arena.make<ArgListNode>();
+            args->arguments = arena.list(kids);
+            node = args;
+            break;
+        }
+        case NodeType::TERMINAL:
+            node = arena.make<TerminalNode>(text[0], line, column);
+            break;
+        case NodeType::ERROR_NODE:
+            node = arena.make<ErrorNode>(text[0], line, column);
+            break;
+        }
+
+        // Some constructors take their position from a child instead
+        node->line_number = line;
+        node->column_number = column;
+        built[index] = node;
+    }
+
+    if (built[0]->type != NodeType::PROGRAM) {
+        throw runtime_error("Corrupt AST file: the root is not a program");
+    }
+    result.root = static_cast<ProgramNode*>(built[0]);
+    return result;
+}
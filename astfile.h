@@ -0,0 +1,160 @@
+//astfile.h
+
+#ifndef ASTFILE_H
+#define ASTFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "parser.h"
+using namespace std;
+
+// Binary AST file
+// ===============
+// A parsed tree saved so that other tools (or a later session) can use it
+// without lexing and parsing the source again. Everything is in host byte
+// order and 4-byte aligned, so a reader can use the file in place from a
+// memory mapping:
+//
+//   AstFileHeader
+//   AstFileNode[node_count]     nodes in pre-order; the root is node 0
+//   uint32_t[child_count]       child slots, node indices or AST_FILE_NONE
+//   char[string_bytes]          names and values, deduplicated
+//
+// A node's children are child slots [first_child, first_child + child_count)
+// and always have higher indices than the node itself. The slots of each
+// node type, in order:
+//
+//   PROGRAM, STATEMENT_LIST    statements...
+//   BLOCK                      statements
+//   STATEMENT                  statement
+//   ASSIGNMENT_STMT            target, value                    op
+//   IF_STMT                    condition, if_block, else_block, elif_clauses...
+//   ELIF_CLAUSE                condition, block
+//   ELSE_CLAUSE                block
+//   ELSE_PART                  else_block, elif_clauses...
+//   WHILE_STMT                 condition, block
+//   FOR_STMT                   target, iterable, block
+//   FUNC_DEF                   params, body, defKeyword, nameNode, openParen,
+//                              closeParen, colon                text: name
+//   RETURN_STMT                expression
+//   IMPORT_STMT                -                                text: module, alias
+//   BINARY_EXPR                left, right                      op
+//   UNARY_EXPR                 operand                          op
+//   CALL_EXPR                  function, arguments, openParen, closeParen
+//   SUBSCRIPT_EXPR             container, index
+//   ATTR_REF                   object                           text: attribute
+//   EXPRESSION, GROUP_EXPR,
+//   ASSIGNMENT_WRAPPER,
+//   COMPARISON_WRAPPER,
+//   CONDITION_NODE             the wrapped node
+//   IDENTIFIER                 -                                text: name
+//   LITERAL                    -                                text: value, type
+//   LIST_LITERAL               elements...
+//   DICT_LITERAL               first, second of each item...
+//   PARAM_LIST                 parameters...
+//   PARAMETER_NODE             default_value                    text: name
+//   ARG_LIST                   arguments...
+//   TERMINAL                   -                                text: value
+//   ERROR_NODE                 -                                text: message
+//
+// Bump AST_FILE_VERSION whenever this layout or NodeType changes; readers
+// reject files of any other version.
+
+constexpr uint32_t AST_FILE_MAGIC = 0x54534150; // "PAST" when little-endian
+constexpr uint32_t AST_FILE_VERSION = 1;
+constexpr uint32_t AST_FILE_NONE = 0xFFFFFFFF;  // empty child slot
+
+struct AstFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t child_count;
+    uint32_t string_bytes;
+    uint32_t reserved;
+};
+
+// Text of a node: `length` bytes at `offset` in the string table
+struct AstFileString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct AstFileNode {
+    uint8_t type;          // NodeType
+    uint8_t flags;         // AST_FILE_PARENTHESES
+    uint16_t op;           // OpCode of BINARY_EXPR, UNARY_EXPR, ASSIGNMENT_STMT
+    int32_t line_number;
+    int32_t column_number;
+    uint32_t first_child;
+    uint32_t child_count;
+    AstFileString text[2];
+};
+
+constexpr uint8_t AST_FILE_PARENTHESES = 1; // hasParentheses of if/elif/while/for
+
+static_assert(sizeof(AstFileHeader) == 24 && sizeof(AstFileNode) == 36,
+              "AST file records must not change size");
+
+// The whole file for the tree under `root`.
+string serializeAst(const ASTNode* root);
+
+// Writes serializeAst(root) to `path`; throws std::runtime_error if it
+// cannot be written.
+void saveAstFile(const ASTNode* root, const string& path);
+
+// A saved tree read in place. openFile() maps the file and checks only the
+// header, so it costs the same for any size of tree; nodes are decoded as
+// they are visited, and every accessor checks its indices against the
+// section sizes, so a damaged file yields empty nodes rather than reads out
+// of bounds. load() rebuilds ordinary AST nodes when a caller needs them.
+class AstFile {
+public:
+    class Node {
+    public:
+        Node() = default;
+
+        bool isNull() const { return record == nullptr; }
+        NodeType type() const { return static_cast<NodeType>(record->type); }
+        int lineNumber() const { return record->line_number; }
+        int columnNumber() const { return record->column_number; }
+        OpCode op() const { return static_cast<OpCode>(record->op); }
+        bool hasParentheses() const { return record->flags & AST_FILE_PARENTHESES; }
+        size_t childCount() const;
+        // A null Node for an empty slot
+        Node child(size_t i) const;
+        string_view text(size_t i = 0) const;
+
+    private:
+        friend class AstFile;
+        Node(const AstFile* file, uint32_t index);
+
+        const AstFile* file = nullptr;
+        const AstFileNode* record = nullptr;
+        uint32_t index = 0;
+    };
+
+    // Throws std::runtime_error if the file cannot be mapped, or is not an
+    // AST file of this version.
+    void openFile(const string& path);
+    // Reads a serializeAst() result kept in memory; `bytes` must outlive
+    // this object and be 4-byte aligned. Throws like openFile().
+    void open(string_view bytes);
+
+    size_t nodeCount() const { return header ? header->node_count : 0; }
+    Node root() const { return nodeCount() ? Node(this, 0) : Node(); }
+
+    // The tree as AST nodes in a fresh arena; throws std::runtime_error if
+    // the file is inconsistent.
+    ParseResult load() const;
+
+private:
+    unique_ptr<SourceBuffer> mapping;
+    const AstFileHeader* header = nullptr;
+    const AstFileNode* nodes = nullptr;
+    const uint32_t* children = nullptr;
+    const char* strings = nullptr;
+};
+
+#endif // ASTFILE_H
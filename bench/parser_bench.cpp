@@ -0,0 +1,296 @@
+//parser_bench.cpp
+
+// Parser benchmarks on generated input, so that runs are reproducible and
+// can be compared across commits:
+//
+//   parser_bench [section...]
+//
+// With no arguments every section runs. Each case reports the best of
+// several parses of the same token stream; lexing is not timed.
+//
+//   errors    error recovery: the same statement mix with 0-70% of the
+//             lines broken (unclosed brackets, missing operands, ...)
+//   expressions
+//             operator-dense expressions over every precedence level,
+//             and single-operand assignments (a = b, c = 1)
+//   nesting   ordinary code with the default nesting limit and without
+//             one, and brackets, calls and blocks nested below and far
+//             past Parser::DEFAULT_MAX_NESTING
+
+#include "lexer.h"
+#include "parser.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+constexpr int RUNS = 5;
+
+struct Timing {
+    double seconds;
+    size_t errors;
+};
+
+// Best of RUNS parses of `source`; `setup` configures each parser
+Timing timeParse(const string& source, const function<void(Parser&)>& setup = nullptr)
+{
+    Timing best{1e9, 0};
+    for (int run = 0; run < RUNS; ++run) {
+        // The parser replays the tokens of a batch-lexed Lexer
+        Lexer lexer;
+        lexer.tokenize(source);
+        Parser parser(lexer);
+        if (setup)
+            setup(parser);
+        auto start = chrono::steady_clock::now();
+        ParseResult result = parser.parse();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (seconds < best.seconds)
+            best = {seconds, parser.getErrors().size()};
+    }
+    return best;
+}
+
+void report(const char* name, const string& source, const Timing& timing)
+{
+    printf("  %-30s %8.2f ms %8.1f MB/s %8zu errors\n", name, timing.seconds * 1e3,
+           source.size() / timing.seconds / 1e6, timing.errors);
+}
+
+// --- errors ---
+
+string errorDenseSource(size_t lines, double broken_fraction)
+{
+    static const char* const valid[] = {
+        "a = b + c * 2", "print(a, b)", "lst = [1, 2, 3]", "d = {1: a, 2: b}", "y = obj.attr.method(x)",
+    };
+    static const char* const broken[] = {
+        "x = (1 + 2", "y = [1, 2", "def f(:", "if x > 1", "while (a", "foo(a,, b)", "z = {1: }",
+        "w = 3 * ", "k = d[1", "u = (a b)", "return )", "q = a..b", "print 'hi'", "v = --1", "import 5",
+    };
+    mt19937 rng(13);
+    bernoulli_distribution is_broken(broken_fraction);
+    string source;
+    for (size_t i = 0; i < lines; ++i) {
+        if (is_broken(rng))
+            source += broken[rng() % size(broken)];
+        else
+            source += valid[rng() % size(valid)];
+        source += '\n';
+    }
+    return source;
+}
+
+void benchErrors()
+{
+    puts("errors: 60000 lines");
+    for (int percent : {0, 10, 30, 70}) {
+        string source = errorDenseSource(60000, percent / 100.0);
+        string name = to_string(percent) + "% broken";
+        report(name.c_str(), source, timeParse(source));
+    }
+}
+
+// --- expressions ---
+
+// Random valid expressions, one grammar level per function, so that
+// every precedence level shows up (all operators but '//', which the
+// parser does not accept); `depth` limits nesting through parentheses
+class ExpressionGenerator {
+public:
+    ExpressionGenerator(string& out, mt19937& rng) : out(out), rng(rng) {}
+
+    void orExpr(int depth) { chain(depth, {" or "}, &ExpressionGenerator::andExpr); }
+
+private:
+    using Level = void (ExpressionGenerator::*)(int);
+
+    // operands of `next` joined by operators from `ops`; one level in
+    // three has a second operand, so lines stay a few dozen tokens long
+    void chain(int depth, initializer_list<const char*> ops, Level next)
+    {
+        (this->*next)(depth);
+        if (rng() % 3 == 0) {
+            out += ops.begin()[rng() % ops.size()];
+            (this->*next)(depth);
+        }
+    }
+    void andExpr(int depth) { chain(depth, {" and "}, &ExpressionGenerator::notExpr); }
+    void notExpr(int depth)
+    {
+        if (rng() % 4 == 0)
+            out += "not ";
+        comparison(depth);
+    }
+    void comparison(int depth)
+    {
+        static const char* const ops[] = {" == ", " != ", " < ", " > ", " <= ", " >= "};
+        arithmetic(depth);
+        if (rng() % 2) {
+            out += ops[rng() % size(ops)];
+            arithmetic(depth);
+        }
+    }
+    void arithmetic(int depth) { chain(depth, {" + ", " - "}, &ExpressionGenerator::term); }
+    void term(int depth) { chain(depth, {" * ", " / ", " % "}, &ExpressionGenerator::factor); }
+    void factor(int depth)
+    {
+        if (rng() % 5 == 0)
+            out += '-';
+        primary(depth);
+        if (rng() % 6 == 0) {
+            out += " ** ";
+            primary(depth);
+        }
+    }
+    void primary(int depth)
+    {
+        static const char* const operands[] = {"a", "b", "count", "x1", "2", "3.5", "'s'", "f(a)", "lst[i]", "obj.n"};
+        if (depth > 0 && rng() % 4 == 0) {
+            out += '(';
+            orExpr(depth - 1);
+            out += ')';
+        } else {
+            out += operands[rng() % size(operands)];
+        }
+    }
+
+    string& out;
+    mt19937& rng;
+};
+
+string expressionSource(size_t lines, int depth)
+{
+    static const char* const simple[] = {"b", "1", "count", "'text'", "x1", "3.5"};
+    mt19937 rng(14);
+    string source;
+    for (size_t i = 0; i < lines; ++i) {
+        source += "v = ";
+        if (depth == 0)
+            source += simple[rng() % size(simple)];
+        else
+            ExpressionGenerator(source, rng).orExpr(depth);
+        source += '\n';
+    }
+    return source;
+}
+
+void benchExpressions()
+{
+    puts("expressions:");
+    string simple = expressionSource(40000, 0);
+    report("single operand, 40000 lines", simple, timeParse(simple));
+    string dense = expressionSource(10000, 3);
+    report("operator-dense, 10000 lines", dense, timeParse(dense));
+}
+
+// --- nesting ---
+
+// Functions with branches, calls, lists and arithmetic, like most files
+string ordinarySource(size_t functions)
+{
+    string source;
+    for (size_t i = 0; i < functions; ++i) {
+        string n = to_string(i);
+        source += "def func_" + n + "(a, b=2):\n";
+        source += "    x_" + n + " = a + b * " + n + " - (a / 3.5) % 2\n";
+        source += "    if x_" + n + " > " + n + " and not a == b:\n";
+        source += "        lst = [1, 2, -3, a]\n";
+        source += "        d = lst[" + to_string(i % 3) + "] + lst[0]\n";
+        source += "    else:\n";
+        source += "        print(\"value\", x_" + n + ", obj.attr.method(a))\n";
+        source += "    return x_" + n + " ** 2\n";
+        source += "y_" + n + " = func_" + n + "(1, 2)\n";
+    }
+    return source;
+}
+
+// `lines` copies of `open` * depth + "a" + `close` * depth
+string bracketSource(size_t lines, int depth, const string& open, const string& close)
+{
+    string line = "v = ";
+    for (int i = 0; i < depth; ++i)
+        line += open;
+    line += 'a';
+    for (int i = 0; i < depth; ++i)
+        line += close;
+    line += '\n';
+    string source;
+    for (size_t i = 0; i < lines; ++i)
+        source += line;
+    return source;
+}
+
+// `copies` chains of `depth` nested if statements
+string blockSource(size_t copies, int depth)
+{
+    string source;
+    for (size_t c = 0; c < copies; ++c) {
+        for (int i = 0; i < depth; ++i)
+            source += string(4 * i, ' ') + "if a:\n";
+        source += string(4 * depth, ' ') + "x = 1\n";
+    }
+    return source;
+}
+
+void benchNesting()
+{
+    auto unlimited = [](Parser& parser) { parser.setMaxNesting(INT_MAX); };
+
+    puts("nesting: ordinary code, 45000 lines");
+    string ordinary = ordinarySource(5000);
+    report("limit 200", ordinary, timeParse(ordinary));
+    report("no limit", ordinary, timeParse(ordinary, unlimited));
+
+    // Below the limit every line parses. Far past it the statement fails
+    // at level 200 instead of recursing deeper, and recovery skips what
+    // follows its unclosed brackets, so one line or chain is enough.
+    for (int depth : {100, Parser::DEFAULT_MAX_NESTING - 1, 5000}) {
+        bool within = depth < Parser::DEFAULT_MAX_NESTING;
+        size_t lines = within ? 500 : 1;
+        printf("nesting: depth %d, %zu line%s\n", depth, lines, within ? "s" : "");
+        string parens = bracketSource(lines, depth, "(", ")");
+        report("parentheses", parens, timeParse(parens));
+        string lists = bracketSource(lines, depth, "[", "]");
+        report("lists", lists, timeParse(lists));
+        string calls = bracketSource(lines, depth, "f(", ")");
+        report("calls", calls, timeParse(calls));
+        if (within)
+            report("parentheses, no limit", parens, timeParse(parens, unlimited));
+        // Indentation grows with depth, so blocks stop at 1000 levels
+        string blocks = blockSource(within ? 20 : 1, min(depth, 1000));
+        report(within ? "nested if blocks, 20 chains" : "nested if blocks, 1000", blocks, timeParse(blocks));
+    }
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+const Section sections[] = {
+    {"errors", benchErrors},
+    {"expressions", benchExpressions},
+    {"nesting", benchNesting},
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    for (const Section& section : sections) {
+        bool wanted = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            wanted |= strcmp(argv[i], section.name) == 0;
+        if (wanted)
+            section.run();
+    }
+    return 0;
+}
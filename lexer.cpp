@@ -2,6 +2,8 @@
 
 #include "lexer.h"
 #include <algorithm> // For std::all_of
+#include <array>
+#include <atomic>
 #include <cctype>
 #include <fstream>
 #include <iomanip>
@@ -11,109 +13,726 @@
 #include <sstream>
 #include <stack>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility> // Required for std::move
 #include <vector>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// SIMD kernels for the structural index: SSE2 is part of every x86-64
+// target; AVX2 is compiled in per function and chosen at run time (or
+// used unconditionally when the whole build targets it, as MSVC requires)
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LEXER_HAVE_SSE2
+#endif
+#if defined(__GNUC__)
+#define LEXER_HAVE_AVX2
+#define LEXER_AVX2_TARGET __attribute__((target("avx2")))
+static bool cpuHasAVX2() { return __builtin_cpu_supports("avx2"); }
+#elif defined(__AVX2__)
+#define LEXER_HAVE_AVX2
+#define LEXER_AVX2_TARGET
+static bool cpuHasAVX2() { return true; }
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using namespace std;
 
+// --- Keyword / Operator Perfect Hashes ---
+// Keywords and multi-character operators are looked up in tables whose hash
+// seed is searched for at compile time so that every entry gets its own slot:
+// a lookup is one hash, one slot read and one compare, with no allocation.
+static constexpr array<string_view, 15> keyword_texts = {
+    "if", "else", "elif", "while", "for", "def", "return", "True", "False", "None",
+    "in", "import", "and", "or", "not",
+};
+static constexpr array<TokenType, 15> keyword_types = {
+    KEYWORD, KEYWORD, KEYWORD, KEYWORD, KEYWORD, KEYWORD, KEYWORD, DATA_TYPE, DATA_TYPE, DATA_TYPE,
+    KEYWORD, KEYWORD, KEYWORD, KEYWORD, KEYWORD,
+};
+
+static constexpr array<string_view, 20> operator_texts = {
+    "!=", "==", "<=", ">=",       // comparisons
+    "**", "//",                   // power & floor-div
+    "**=", "//=",                 // compound versions
+    "+=", "-=", "*=", "/=", "%=", // arithmetic assignment
+    "<<", ">>",                   // bit-shifts
+    "<<=", ">>=",                 // bit-shift assignment
+    "&=", "|=", "^=",             // bitwise assignment
+};
+
+static constexpr uint32_t seededHash(string_view text, uint32_t seed)
+{
+    // FNV-1a with the seed folded into the offset basis, plus a final mix so
+    // the low bits used for the slot index depend on every character
+    uint32_t hash = 2166136261u ^ seed;
+    for (char ch : text) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    return hash;
+}
+
+template<size_t SLOTS>
+struct PerfectHash {
+    uint32_t seed = 0;
+    array<uint8_t, SLOTS> slots{}; // entry index + 1; 0 marks an empty slot
+    size_t max_length = 0;
+    bool perfect = false;
+};
+
+template<size_t SLOTS, size_t N>
+static constexpr PerfectHash<SLOTS> buildPerfectHash(const array<string_view, N> &keys)
+{
+    PerfectHash<SLOTS> table{};
+    for (const auto &key : keys)
+        table.max_length = key.size() > table.max_length ? key.size() : table.max_length;
+    for (uint32_t seed = 0; seed < 10000; ++seed) {
+        array<uint8_t, SLOTS> slots{};
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; ++i) {
+            size_t slot = seededHash(keys[i], seed) % SLOTS;
+            if (slots[slot] != 0)
+                collision = true;
+            else
+                slots[slot] = static_cast<uint8_t>(i + 1);
+        }
+        if (!collision) {
+            table.seed = seed;
+            table.slots = slots;
+            table.perfect = true;
+            break;
+        }
+    }
+    return table;
+}
+
+static constexpr auto keyword_hash = buildPerfectHash<32>(keyword_texts);
+static constexpr auto operator_hash = buildPerfectHash<64>(operator_texts);
+static_assert(keyword_hash.perfect, "no collision-free seed for the keyword table");
+static_assert(operator_hash.perfect, "no collision-free seed for the operator table");
+
+// Characters that can start a multi-character operator
+static constexpr array<bool, 256> operator_starts = [] {
+    array<bool, 256> starts{};
+    for (const auto &op : operator_texts)
+        starts[static_cast<unsigned char>(op[0])] = true;
+    return starts;
+}();
+
+static bool lookupKeyword(string_view word, TokenType *type = nullptr)
+{
+    if (word.empty() || word.size() > keyword_hash.max_length)
+        return false;
+    uint8_t entry = keyword_hash.slots[seededHash(word, keyword_hash.seed) % keyword_hash.slots.size()];
+    if (entry == 0 || keyword_texts[entry - 1] != word)
+        return false;
+    if (type)
+        *type = keyword_types[entry - 1];
+    return true;
+}
+
+// Length of the longest multi-character operator starting at `pos`, or 0
+static size_t matchMultiCharOperator(string_view text, size_t pos)
+{
+    if (!operator_starts[static_cast<unsigned char>(text[pos])])
+        return 0;
+    for (size_t length = operator_hash.max_length; length >= 2; --length) {
+        if (pos + length > text.size())
+            continue;
+        string_view candidate = text.substr(pos, length);
+        uint8_t entry = operator_hash.slots[seededHash(candidate, operator_hash.seed) % operator_hash.slots.size()];
+        if (entry != 0 && operator_texts[entry - 1] == candidate)
+            return length;
+    }
+    return 0;
+}
+
 // Constructor implementation
 Lexer::Lexer()
-    : line_number(1)
-{
-    // Initialize keywords map
-    // keywords = {
-    //     {"if", KEYWORD}, {"else", KEYWORD}, {"elif", KEYWORD},
-    //     {"while", KEYWORD}, {"for", KEYWORD}, {"def", KEYWORD},
-    //     {"return", KEYWORD}, {"True", DATA_TYPE}, {"False", DATA_TYPE},
-    //     {"None", DATA_TYPE}, {"in", KEYWORD}, {"import", KEYWORD}
-    // };
-    keywords = {
-        {"if", KEYWORD},
-        {"else", KEYWORD},
-        {"elif", KEYWORD},
-        {"while", KEYWORD},
-        {"for", KEYWORD},
-        {"def", KEYWORD},
-        {"return", KEYWORD},
-        {"True", DATA_TYPE},
-        {"False", DATA_TYPE},
-        {"None", DATA_TYPE},
-        {"in", KEYWORD},
-        {"import", KEYWORD},
-        {"and", KEYWORD},
-        {"or", KEYWORD},
-        {"not", KEYWORD} // Add these boolean operators
-    };
+    : line_number(1), scan_mode(ScanMode::DFA), next_line_start(0), strip_cr(false),
+      in_multiline_comment(false), streaming(false), stream_finished(false), read_index(0),
+      line_limit(0), worker_threads(0), parallel_min_bytes(PARALLEL_MIN_BYTES), spill(nullptr),
+      deferred_lines(nullptr), cancel_token(nullptr), track_lines(false), symbols_stale(false),
+      token_edit{0, 0, 0}, tokens_edited(false), tokens_replaced(true), taken_tokens(0)
+{
+    // Keywords live in the compile-time keyword_texts/keyword_types table
 
     // Initialize indentation levels
-    indentation_levels = std::stack<int>();
+    indentation_levels.clear();
+}
+
+// --- Token Stream ---
+// Text of the fixed lexeme IDs, in LexemeId order
+static const char *const fixed_lexemes[LEX_FIRST_DYNAMIC] = {
+    "",
+    "if", "else", "elif", "while", "for", "def", "return",
+    "in", "import", "as", "and", "or", "not",
+    "True", "False", "None",
+    "=", "+", "-", "*", "/", "%",
+    "**", "//", "==", "!=", "<", ">", "<=", ">=",
+    "<<", ">>", "&", "|", "^", "~", ".",
+    "+=", "-=", "*=", "/=",
+    "%=", "**=", "//=", "&=",
+    "|=", "^=", "<<=", ">>=",
+    "(", ")", "[", "]", "{", "}",
+    ":", ",", ";",
+};
+
+const char *lexemeText(LexemeId id)
+{
+    return id < LEX_FIRST_DYNAMIC ? fixed_lexemes[id] : "";
+}
+
+TokenStream::TokenStream() : id_slots(256, LEX_UNKNOWN)
+{
+    id_text.reserve(LEX_FIRST_DYNAMIC);
+    for (uint32_t id = 0; id < LEX_FIRST_DYNAMIC; ++id) {
+        id_text.emplace_back(fixed_lexemes[id]);
+        size_t slot = findSlot(id_text.back());
+        if (id != LEX_UNKNOWN && id_slots[slot] == LEX_UNKNOWN)
+            id_slots[slot] = id;
+    }
+}
+
+// Slot holding the ID of `text`, or the free slot where it would go
+size_t TokenStream::findSlot(string_view text) const
+{
+    size_t mask = id_slots.size() - 1;
+    size_t slot = hash<string_view>()(text) & mask;
+    while (id_slots[slot] != LEX_UNKNOWN && id_text[id_slots[slot]] != text)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+uint32_t TokenStream::intern(string_view text)
+{
+    size_t slot = findSlot(text);
+    if (id_slots[slot] != LEX_UNKNOWN)
+        return id_slots[slot];
+    // `text` lives in the SourceBuffer (or a literal), so the view is stable
+    uint32_t id = static_cast<uint32_t>(id_text.size());
+    id_text.push_back(text);
+    id_slots[slot] = id;
+    if (id_text.size() * 2 > id_slots.size()) {
+        // Keep the table at most half full
+        id_slots.assign(id_slots.size() * 2, LEX_UNKNOWN);
+        for (uint32_t other = LEX_UNKNOWN + 1; other < id_text.size(); ++other) {
+            size_t other_slot = findSlot(id_text[other]);
+            if (id_slots[other_slot] == LEX_UNKNOWN)
+                id_slots[other_slot] = other;
+        }
+    }
+    return id;
+}
+
+uint32_t TokenStream::lookup(string_view text) const
+{
+    return id_slots[findSlot(text)];
+}
+
+void TokenStream::emplace_back(string_view lexeme, TokenType type, int line_number, int column_number)
+{
+    uint32_t offset = NO_OFFSET;
+    if (lexeme.data() >= source_text.data() && lexeme.data() < source_text.data() + source_text.size())
+        offset = static_cast<uint32_t>(lexeme.data() - source_text.data());
+
+    types.push_back(static_cast<uint8_t>(type));
+    ids.push_back(intern(lexeme));
+    offsets.push_back(offset);
+    lines.push_back(static_cast<uint32_t>(line_number));
+    if (column_number >= 0 && column_number < UINT16_MAX) {
+        columns.push_back(static_cast<uint16_t>(column_number));
+    } else {
+        columns.push_back(UINT16_MAX);
+        wide_columns[static_cast<uint32_t>(types.size() - 1)] = column_number;
+    }
+}
+
+int TokenStream::column(size_t i) const
+{
+    if (columns[i] != UINT16_MAX)
+        return columns[i];
+    return wide_columns.at(static_cast<uint32_t>(i));
+}
+
+// Appends tokens [begin, end) of `other`. Its dynamic lexeme IDs are
+// re-interned on first use and cached in `remap` (indexed by `other`'s IDs),
+// so IDs keep following order of first appearance in this stream.
+void TokenStream::appendRange(const TokenStream &other, size_t begin, size_t end, vector<uint32_t> &remap)
+{
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t id = other.ids[i];
+        if (id >= LEX_FIRST_DYNAMIC) {
+            if (remap[id] == LEX_UNKNOWN)
+                remap[id] = intern(other.id_text[id]);
+            id = remap[id];
+        }
+        types.push_back(other.types[i]);
+        ids.push_back(id);
+        offsets.push_back(other.offsets[i]);
+        lines.push_back(other.lines[i]);
+        columns.push_back(other.columns[i]);
+        if (other.columns[i] == UINT16_MAX)
+            wide_columns[static_cast<uint32_t>(types.size() - 1)] = other.wide_columns.at(static_cast<uint32_t>(i));
+    }
+}
+
+void TokenStream::reserve(size_t count)
+{
+    types.reserve(count);
+    ids.reserve(count);
+    offsets.reserve(count);
+    lines.reserve(count);
+    columns.reserve(count);
+}
+
+void TokenStream::clear()
+{
+    types.clear();
+    ids.clear();
+    offsets.clear();
+    lines.clear();
+    columns.clear();
+    wide_columns.clear();
+}
+
+TokenEdit TokenEdit::then(const TokenEdit& next) const
+{
+    // Everything between the two changed spans counts as changed too
+    size_t first = min(begin, next.begin);
+    size_t last = max(new_end, next.old_end);
+    return {first, old_end + (last - new_end), next.new_end + (last - next.old_end)};
+}
+
+string_view SourceEdit::relocate(string_view view, string_view old_text, string_view new_text) const
+{
+    if (view.data() < old_text.data() || view.data() > old_text.data() + old_text.size())
+        return view;
+    size_t begin = view.data() - old_text.data();
+    if (begin + view.size() <= offset)
+        return new_text.substr(begin, view.size());
+    if (begin >= offset + removed_length)
+        return new_text.substr(begin - removed_length + inserted_length, view.size());
+    return {};
+}
+
+void TokenStream::relocate(const SourceEdit &edit, string_view new_text, deque<string> &spill)
+{
+    for (uint32_t id = LEX_FIRST_DYNAMIC; id < id_text.size(); ++id) {
+        string_view old_view = id_text[id];
+        string_view new_view = edit.relocate(old_view, source_text, new_text);
+        if (new_view.data() == old_view.data())
+            continue; // not a view into the source
+        if (new_view.data() == nullptr) {
+            // First seen in replaced text; later tokens may still use the ID
+            spill.emplace_back(old_view);
+            new_view = spill.back();
+        }
+        id_text[id] = new_view; // id_slots hash the text, which is unchanged
+    }
+    source_text = new_text;
+}
+
+void TokenStream::splice(size_t begin, size_t end, const TokenStream &replacement, const SourceEdit &edit,
+                         int line_delta)
+{
+    // Tokens after the replaced range keep their text, which moved with the edit
+    int64_t shift = static_cast<int64_t>(edit.inserted_length) - static_cast<int64_t>(edit.removed_length);
+    for (size_t i = end; i < size(); ++i) {
+        if (offsets[i] != NO_OFFSET)
+            offsets[i] = static_cast<uint32_t>(offsets[i] + shift);
+        lines[i] = static_cast<uint32_t>(static_cast<int64_t>(lines[i]) + line_delta);
+    }
+
+    vector<uint32_t> remap(replacement.internedCount(), LEX_UNKNOWN);
+    vector<uint32_t> replacement_ids(replacement.ids);
+    for (uint32_t &id : replacement_ids) {
+        if (id >= LEX_FIRST_DYNAMIC) {
+            if (remap[id] == LEX_UNKNOWN)
+                remap[id] = intern(replacement.id_text[id]);
+            id = remap[id];
+        }
+    }
+    auto replace = [begin, end](auto &column, const auto &values) {
+        column.erase(column.begin() + begin, column.begin() + end);
+        column.insert(column.begin() + begin, values.begin(), values.end());
+    };
+    replace(types, replacement.types);
+    replace(ids, replacement_ids);
+    replace(offsets, replacement.offsets);
+    replace(lines, replacement.lines);
+    replace(columns, replacement.columns);
+
+    if (!wide_columns.empty() || !replacement.wide_columns.empty()) {
+        unordered_map<uint32_t, int> wide;
+        for (const auto &entry : wide_columns) {
+            if (entry.first < begin)
+                wide[entry.first] = entry.second;
+            else if (entry.first >= end)
+                wide[static_cast<uint32_t>(entry.first - end + begin + replacement.size())] = entry.second;
+        }
+        for (const auto &entry : replacement.wide_columns)
+            wide[static_cast<uint32_t>(begin + entry.first)] = entry.second;
+        wide_columns.swap(wide);
+    }
+}
+
+// --- Diagnostics ---
+string Diagnostics::summary(const Diagnostic &d)
+{
+    string lexeme(d.lexeme);
+    string other(d.other);
+    switch (d.code) {
+    case DiagnosticCode::TAB_INDENT:
+        return "Tabs are not allowed for indentation. Use spaces only.";
+    case DiagnosticCode::DEDENT_MISMATCH:
+        return "Unindent does not match any outer indentation level.";
+    case DiagnosticCode::INDENT_MISMATCH:
+        return "Inconsistent indentation level after dedent (final level mismatch).";
+    case DiagnosticCode::DEDENT_BELOW_BASE:
+        return "Unindent error (level mismatch with base 0).";
+    case DiagnosticCode::KEYWORD_AS_IDENTIFIER:
+        return "Reserved keyword '" + lexeme + "' cannot be used as an identifier";
+    case DiagnosticCode::INVALID_FLOAT:
+        return "Invalid float number: '" + lexeme + "'";
+    case DiagnosticCode::DIGIT_LED_IDENTIFIER:
+        return "Identifier cannot start with a digit: '" + lexeme + "'";
+    case DiagnosticCode::INVALID_IDENTIFIER_CHAR:
+        return "Invalid character in identifier: '" + lexeme + "'";
+    case DiagnosticCode::KEYWORD_AFTER_NUMBER:
+        return "Keyword '" + lexeme + "' cannot directly follow a numeric literal in this context.";
+    case DiagnosticCode::KEYWORD_IN_CONTEXT:
+        return "Reserved keyword '" + lexeme + "' cannot be used as an identifier or in this context.";
+    case DiagnosticCode::NUMBER_AFTER_NUMBER:
+        return "Numeric literal '" + lexeme
+               + "' cannot directly follow another numeric literal without an operator.";
+    case DiagnosticCode::NUMBER_AFTER_IDENTIFIER:
+        return "Numeric literal '" + lexeme + "' cannot directly follow an identifier ('" + other
+               + "') without an operator or separator.";
+    case DiagnosticCode::IDENTIFIER_AFTER_NUMBER:
+        return "Identifier '" + lexeme + "' cannot directly follow a numeric literal without an operator.";
+    case DiagnosticCode::IDENTIFIER_AFTER_IDENTIFIER:
+        return "Identifier '" + lexeme + "' cannot directly follow another identifier ('" + other
+               + "') without an operator or separator.";
+    case DiagnosticCode::UNKNOWN_TOKEN:
+        return "Unknown or invalid token '" + lexeme + "'";
+    }
+    return "Unknown lexical error";
+}
+
+string Diagnostics::message(const Diagnostic &d)
+{
+    string line = to_string(d.line_number);
+    switch (d.code) {
+    case DiagnosticCode::TAB_INDENT:
+        return "Lexical Error: Tabs are not allowed for indentation at Line " + line + ". Use spaces only.";
+    case DiagnosticCode::DEDENT_MISMATCH:
+    case DiagnosticCode::INDENT_MISMATCH:
+    case DiagnosticCode::DEDENT_BELOW_BASE:
+        return "Lexical Error at Line " + line + ": " + summary(d);
+    default:
+        return "Lexical Error at Line " + line + ", Column " + to_string(d.column_number) + ": " + summary(d);
+    }
+}
+
+void Diagnostics::print(ostream &out) const
+{
+    for (const Diagnostic &d : entries)
+        out << message(d) << "\n";
+}
+
+void Diagnostics::splice(size_t begin, size_t end, const Diagnostics &replacement, const SourceEdit &edit,
+                         string_view old_text, string_view new_text, int line_delta)
+{
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i >= begin && i < end)
+            continue;
+        entries[i].lexeme = edit.relocate(entries[i].lexeme, old_text, new_text);
+        entries[i].other = edit.relocate(entries[i].other, old_text, new_text);
+        if (i >= end)
+            entries[i].line_number += line_delta;
+    }
+    entries.erase(entries.begin() + begin, entries.begin() + end);
+    entries.insert(entries.begin() + begin, replacement.entries.begin(), replacement.entries.end());
 }
 
 // --- Helper Functions ---
-bool Lexer::isInteger(const string &str)
+bool Lexer::isInteger(string_view str)
 {
-    return regex_match(str, regex(R"(^[+-]?\d+$)"));
+    return regex_match(str.begin(), str.end(), regex(R"(^[+-]?\d+$)"));
 }
 
-bool Lexer::isFloat(const string &str)
+bool Lexer::isFloat(string_view str)
 {
-    return regex_match(str, regex(R"(^[+-]?(\d+\.\d*|\.\d+)$)"));
+    return regex_match(str.begin(), str.end(), regex(R"(^[+-]?(\d+\.\d*|\.\d+)$)"));
 }
 
-bool Lexer::isIdentifier(const string &str)
+bool Lexer::isIdentifier(string_view str)
 {
-    return regex_match(str, regex("^[a-zA-Z_][a-zA-Z0-9_]*$"));
+    return regex_match(str.begin(), str.end(), regex("^[a-zA-Z_][a-zA-Z0-9_]*$"));
 }
 
 // bool Lexer::isOperator(const string& str) {
 //     // Matches arithmetic, comparison, logical, assignment, exponentiation, attribute access
 //     return regex_match(str, regex(R"(^([+\-*/%]|\*\*|==|!=|<=|>=|<|>|=|and|or|not|\.)$)"));
 // }
-bool Lexer::isOperator(const string &str) {
+bool Lexer::isOperator(string_view str) {
     // match *all* the compound operators, then fall back to any single-char operator
     static const regex op_re(R"(^(\+=|-=|\*=|/=|%=|\*\*=|//=|&=|\|=|\^=|<<=|>>=|!=|==|<=|>=|<<|>>|//|\*\*|[+\-*/%<>=&\|\^~\.])$)");
-    return regex_match(str, op_re);
+    return regex_match(str.begin(), str.end(), op_re);
 }
 
-bool Lexer::isSymbol(const string &str)
+bool Lexer::isSymbol(string_view str)
 {
     // Matches parentheses, brackets, braces, colon, comma, semicolon
-    return regex_match(str, regex(R"([(){}\[\]:;,])"));
+    return regex_match(str.begin(), str.end(), regex(R"([(){}\[\]:;,])"));
+}
+
+// --- DFA Scanner Tables ---
+// Character classes and states of the word scanner. The DFA reproduces the
+// alternation order of the regex splitter in tokenizeWord: signed/unsigned
+// floats, integers, identifiers, compound operators, single-char operators
+// and symbols, then any other single character.
+enum DfaCharClass {
+    CC_OTHER, CC_DIGIT, CC_ALPHA, CC_DOT, CC_SIGN, CC_STAR, CC_SLASH, CC_LT, CC_GT,
+    CC_EQ, CC_BANG, CC_OPEQ, CC_TILDE, CC_SYMBOL, CC_SPACE, CC_COUNT
+};
+
+enum DfaState {
+    S_START, S_INT, S_INT_DOT, S_FRAC, S_SIGN, S_SIGN_INT, S_SIGN_DOT, S_DOT, S_IDENT,
+    S_STAR, S_STAR2, S_SLASH, S_SLASH2, S_LT, S_LT2, S_GT, S_GT2, S_EQ, S_BANG, S_OPEQ,
+    S_OP_DONE, S_SYMBOL, S_OTHER, S_SPACE, S_DEAD, S_COUNT
+};
+
+struct DfaTables {
+    unsigned char char_class[256];
+    unsigned char next[S_COUNT][CC_COUNT];
+    LexemeClass accept[S_COUNT];
+
+    DfaTables()
+    {
+        for (int c = 0; c < 256; ++c)
+            char_class[c] = CC_OTHER;
+        for (int c = '0'; c <= '9'; ++c)
+            char_class[c] = CC_DIGIT;
+        for (int c = 'a'; c <= 'z'; ++c)
+            char_class[c] = CC_ALPHA;
+        for (int c = 'A'; c <= 'Z'; ++c)
+            char_class[c] = CC_ALPHA;
+        char_class[(unsigned char) '_'] = CC_ALPHA;
+        char_class[(unsigned char) '.'] = CC_DOT;
+        char_class[(unsigned char) '+'] = CC_SIGN;
+        char_class[(unsigned char) '-'] = CC_SIGN;
+        char_class[(unsigned char) '*'] = CC_STAR;
+        char_class[(unsigned char) '/'] = CC_SLASH;
+        char_class[(unsigned char) '<'] = CC_LT;
+        char_class[(unsigned char) '>'] = CC_GT;
+        char_class[(unsigned char) '='] = CC_EQ;
+        char_class[(unsigned char) '!'] = CC_BANG;
+        for (char c : string("%&|^"))
+            char_class[(unsigned char) c] = CC_OPEQ;
+        char_class[(unsigned char) '~'] = CC_TILDE;
+        for (char c : string("(){}[]:;,"))
+            char_class[(unsigned char) c] = CC_SYMBOL;
+        for (char c : string(" \t\n\v\f\r"))
+            char_class[(unsigned char) c] = CC_SPACE;
+
+        for (auto &row : next)
+            for (auto &cell : row)
+                cell = S_DEAD;
+        next[S_START][CC_DIGIT] = S_INT;
+        next[S_START][CC_ALPHA] = S_IDENT;
+        next[S_START][CC_DOT] = S_DOT;
+        next[S_START][CC_SIGN] = S_SIGN;
+        next[S_START][CC_STAR] = S_STAR;
+        next[S_START][CC_SLASH] = S_SLASH;
+        next[S_START][CC_LT] = S_LT;
+        next[S_START][CC_GT] = S_GT;
+        next[S_START][CC_EQ] = S_EQ;
+        next[S_START][CC_BANG] = S_BANG;
+        next[S_START][CC_OPEQ] = S_OPEQ;
+        next[S_START][CC_TILDE] = S_OP_DONE;
+        next[S_START][CC_SYMBOL] = S_SYMBOL;
+        next[S_START][CC_SPACE] = S_SPACE;
+        next[S_START][CC_OTHER] = S_OTHER;
+
+        // Numbers: \d+(\.\d*)?, [+-]\d+\.\d*, [+-]?\.\d+
+        next[S_INT][CC_DIGIT] = S_INT;
+        next[S_INT][CC_DOT] = S_INT_DOT;
+        next[S_INT_DOT][CC_DIGIT] = S_FRAC;
+        next[S_FRAC][CC_DIGIT] = S_FRAC;
+        next[S_SIGN][CC_DIGIT] = S_SIGN_INT;
+        next[S_SIGN][CC_DOT] = S_SIGN_DOT;
+        next[S_SIGN_INT][CC_DIGIT] = S_SIGN_INT;
+        next[S_SIGN_INT][CC_DOT] = S_INT_DOT;
+        next[S_SIGN_DOT][CC_DIGIT] = S_FRAC;
+        next[S_DOT][CC_DIGIT] = S_FRAC;
+
+        // Identifiers
+        next[S_IDENT][CC_ALPHA] = S_IDENT;
+        next[S_IDENT][CC_DIGIT] = S_IDENT;
+
+        // Compound operators: **, **=, //, //=, <<, <<=, >>, >>=, and X= forms
+        next[S_SIGN][CC_EQ] = S_OP_DONE;
+        next[S_STAR][CC_STAR] = S_STAR2;
+        next[S_STAR][CC_EQ] = S_OP_DONE;
+        next[S_STAR2][CC_EQ] = S_OP_DONE;
+        next[S_SLASH][CC_SLASH] = S_SLASH2;
+        next[S_SLASH][CC_EQ] = S_OP_DONE;
+        next[S_SLASH2][CC_EQ] = S_OP_DONE;
+        next[S_LT][CC_LT] = S_LT2;
+        next[S_LT][CC_EQ] = S_OP_DONE;
+        next[S_LT2][CC_EQ] = S_OP_DONE;
+        next[S_GT][CC_GT] = S_GT2;
+        next[S_GT][CC_EQ] = S_OP_DONE;
+        next[S_GT2][CC_EQ] = S_OP_DONE;
+        next[S_EQ][CC_EQ] = S_OP_DONE;
+        next[S_BANG][CC_EQ] = S_OP_DONE;
+        next[S_OPEQ][CC_EQ] = S_OP_DONE;
+
+        for (auto &a : accept)
+            a = LexemeClass::NONE;
+        accept[S_INT] = accept[S_INT_DOT] = accept[S_FRAC] = LexemeClass::NUMBER;
+        accept[S_IDENT] = LexemeClass::WORD;
+        accept[S_SIGN] = accept[S_DOT] = accept[S_STAR] = accept[S_STAR2] = accept[S_SLASH]
+            = accept[S_SLASH2] = accept[S_LT] = accept[S_LT2] = accept[S_GT] = accept[S_GT2]
+            = accept[S_EQ] = accept[S_OPEQ] = accept[S_OP_DONE] = LexemeClass::OPERATOR;
+        accept[S_SYMBOL] = LexemeClass::SYMBOL;
+        accept[S_BANG] = accept[S_OTHER] = LexemeClass::INVALID; // lone '!' is not an operator
+        accept[S_SPACE] = LexemeClass::SKIP;
+    }
+};
+
+static const DfaTables &dfaTables()
+{
+    static const DfaTables tables;
+    return tables;
+}
+
+static inline int charClass(char ch)
+{
+    return dfaTables().char_class[(unsigned char) ch];
+}
+
+static inline bool isWordClass(int cc)
+{
+    return cc == CC_ALPHA || cc == CC_DIGIT;
+}
+
+// ^[+-]?\d*(\.\d+){2,}$
+static bool dfaIsMalformedFloat(string_view word)
+{
+    size_t i = 0, n = word.size();
+    if (i < n && (word[i] == '+' || word[i] == '-'))
+        i++;
+    while (i < n && charClass(word[i]) == CC_DIGIT)
+        i++;
+    int groups = 0;
+    while (i < n && word[i] == '.') {
+        size_t digits_start = ++i;
+        while (i < n && charClass(word[i]) == CC_DIGIT)
+            i++;
+        if (i == digits_start)
+            return false;
+        groups++;
+    }
+    return i == n && groups >= 2;
+}
+
+// ^\d+[a-zA-Z_][a-zA-Z0-9_]*$
+static bool dfaIsDigitLedIdentifier(string_view word)
+{
+    size_t i = 0, n = word.size();
+    while (i < n && charClass(word[i]) == CC_DIGIT)
+        i++;
+    if (i == 0 || i == n || charClass(word[i]) != CC_ALPHA)
+        return false;
+    while (i < n && isWordClass(charClass(word[i])))
+        i++;
+    return i == n;
+}
+
+// ^[a-zA-Z_][a-zA-Z0-9_]*[^a-zA-Z0-9_\s]+[a-zA-Z0-9_]*$
+static bool dfaHasInvalidIdentifierChar(string_view word)
+{
+    size_t i = 0, n = word.size();
+    if (n == 0 || charClass(word[0]) != CC_ALPHA)
+        return false;
+    while (i < n && isWordClass(charClass(word[i])))
+        i++;
+    size_t bad_start = i;
+    while (i < n && !isWordClass(charClass(word[i])) && charClass(word[i]) != CC_SPACE)
+        i++;
+    if (i == bad_start)
+        return false;
+    while (i < n && isWordClass(charClass(word[i])))
+        i++;
+    return i == n;
+}
+
+bool Lexer::isOperatorOrSymbolChar(char ch)
+{
+    if (scan_mode == ScanMode::REGEX)
+        return isSymbol(string(1, ch)) || isOperator(string(1, ch));
+    int cc = charClass(ch);
+    return cc != CC_OTHER && cc != CC_DIGIT && cc != CC_ALPHA && cc != CC_BANG && cc != CC_SPACE;
 }
 
 // --- Symbol Table Management ---
-void Lexer::addToSymbolTable(const string &name, const string &type)
+void Lexer::addToSymbolTable(string_view name, const string &type)
 {
     // Add identifiers (not keywords or '_') or numbers if not already present
-    if (keywords.find(name) == keywords.end() && symbol_presence.find(name) == symbol_presence.end()) {
+    if (!lookupKeyword(name) && symbol_presence.find(name) == symbol_presence.end()) {
         symbol_table.emplace_back(name, make_pair(type, line_number));
         symbol_presence[name] = true;
     }
 }
 
 // --- Indentation Handling ---
-void Lexer::handleIndentation(const string &line)
+void Lexer::handleIndentation(string_view line)
 {
-    int indent_level = 0;
-    int column = 1;
+    // Leading whitespace ends at the first non-blank character
+    size_t first_char_pos = firstNonBlank(line);
+    string_view leading = line.substr(0, first_char_pos);
+
     // Calculate indentation level based on leading spaces/tabs
-    for (char ch : line) {
-        if (ch == ' ')
-            indent_level++;
-        else if (ch == '\t') {
-            // Report error for tabs, but try to continue by assuming a width
-            cerr << "Lexical Error: Tabs are not allowed for indentation at Line " << line_number
-                 << ". Use spaces only.\n";
-            tokens.emplace_back("TabError", ERROR, line_number, column);
-            indent_level += 8; // Assume tab width (common but arbitrary)
-        } else
-            break; // Stop at first non-whitespace character
-        column++;
+    int indent_level = 0;
+    if (leading.find('\t') == string_view::npos) {
+        indent_level = static_cast<int>(leading.size());
+    } else {
+        int column = 1;
+        for (char ch : leading) {
+            if (ch == ' ')
+                indent_level++;
+            else {
+                // Report error for tabs, but try to continue by assuming a width
+                diagnostics.report(DiagnosticCode::TAB_INDENT, line_number, column);
+                tokens.emplace_back("TabError", ERROR, line_number, column);
+                indent_level += 8; // Assume tab width (common but arbitrary)
+            }
+            column++;
+        }
     }
 
     // Determine if the line is blank or only contains a comment after whitespace
-    size_t first_char_pos = line.find_first_not_of(" \t");
     bool is_blank_or_comment = (first_char_pos == string::npos
                                 || (first_char_pos < line.length() && line[first_char_pos] == '#'));
 
@@ -121,42 +740,39 @@ void Lexer::handleIndentation(const string &line)
     if (!is_blank_or_comment) {
         if (indentation_levels.empty()) {
             // Safety check, should be initialized with 0
-            indentation_levels.push(0);
+            indentation_levels.push_back(0);
         }
 
-        if (indent_level > indentation_levels.top()) {
+        if (indent_level > indentation_levels.back()) {
             // Increase indentation level
-            indentation_levels.push(indent_level);
+            indentation_levels.push_back(indent_level);
             tokens.emplace_back("INDENT", INDENT, line_number, 1);
-        } else if (indent_level < indentation_levels.top()) {
+        } else if (indent_level < indentation_levels.back()) {
             // Decrease indentation level (handle multiple dedents)
-            while (!indentation_levels.empty() && indent_level < indentation_levels.top()) {
-                indentation_levels.pop();
+            while (!indentation_levels.empty() && indent_level < indentation_levels.back()) {
+                indentation_levels.pop_back();
                 // Check for inconsistent dedent (level doesn't match any previous level)
-                if (indentation_levels.empty() || indent_level > indentation_levels.top()) {
-                    cerr << "Lexical Error at Line " << line_number
-                         << ": Unindent does not match any outer indentation level.\n";
+                if (indentation_levels.empty() || indent_level > indentation_levels.back()) {
+                    diagnostics.report(DiagnosticCode::DEDENT_MISMATCH, line_number, 1);
                     tokens.emplace_back("DedentError", ERROR, line_number, 1);
                     // Attempt recovery: Push the level found, even if incorrect, to avoid stack issues
-                    indentation_levels.push(indent_level);
+                    indentation_levels.push_back(indent_level);
                     break; // Stop dedenting after error
                 }
                 tokens.emplace_back("DEDENT", DEDENT, line_number, 1);
             }
             // After dedenting, ensure the final level matches exactly
-            if (!indentation_levels.empty() && indent_level != indentation_levels.top()) {
-                cerr << "Lexical Error at Line " << line_number
-                     << ": Inconsistent indentation level after dedent (final level mismatch).\n";
+            if (!indentation_levels.empty() && indent_level != indentation_levels.back()) {
+                diagnostics.report(DiagnosticCode::INDENT_MISMATCH, line_number, 1);
                 tokens.emplace_back("IndentError", ERROR, line_number, 1);
             } else if (indentation_levels.empty() && indent_level != 0) {
                 // Should be caught above, but as a safeguard:
-                cerr << "Lexical Error at Line " << line_number
-                     << ": Unindent error (level mismatch with base 0).\n";
+                diagnostics.report(DiagnosticCode::DEDENT_BELOW_BASE, line_number, 1);
                 tokens.emplace_back("DedentError", ERROR, line_number, 1);
-                indentation_levels.push(indent_level); // Recover by pushing level
+                indentation_levels.push_back(indent_level); // Recover by pushing level
             }
         }
-        // If indent_level == indentation_levels.top(), indentation is consistent, do nothing.
+        // If indent_level == indentation_levels.back(), indentation is consistent, do nothing.
     }
 }
 
@@ -171,11 +787,10 @@ void Lexer::analyzeBuffer()
             && buffer[i + 1].lexeme == "=") {
             // Mark current as ERROR and skip assignment
             current.type = ERROR;
-            cerr << "Lexical Error at Line " << current.line_number << ", Column "
-                 << current.column_number << ": Reserved keyword '" << current.lexeme
-                 << "' cannot be used as an identifier\n";
+            diagnostics.report(DiagnosticCode::KEYWORD_AS_IDENTIFIER, current.line_number,
+                               current.column_number, current.lexeme);
 
-            tokens.emplace_back(current);
+            tokens.push_back(current);
             continue; // Still emit '=' in next iteration
         }
 
@@ -184,38 +799,34 @@ void Lexer::analyzeBuffer()
             current.type = FUNCTION_IDENTIFIER;
         }
 
-        tokens.emplace_back(current);
+        tokens.push_back(current);
     }
 
     buffer.clear();
 }
 
+// Grows a lexeme view by the character at `i`; lexemes being accumulated are
+// always contiguous in the line, so no text is copied
+static inline void extendLexeme(string_view &lexeme, string_view line, size_t i)
+{
+    lexeme = lexeme.empty() ? line.substr(i, 1) : string_view(lexeme.data(), lexeme.size() + 1);
+}
+
 // --- Line Tokenization ---
-void Lexer::tokenizeLine(const string &line)
+void Lexer::tokenizeLine(string_view line)
 {
-    string current_token;
+    string_view current_token;
     bool in_string = false;
     char string_delim = '\0';
     bool in_number = false; // New flag to track number parsing
 
-    // List of multi-character operators
-    vector<string> multi_char_operators = {
-        "!=", "==", "<=", ">=",     // comparisons
-        "**", "//",                 // power & floor-div
-        "**=", "//=",               // compound versions
-        "+=", "-=", "*=", "/=", "%=",  // arithmetic assignment
-        "<<", ">>",                 // bit-shifts
-        "<<=", ">>=",               // bit-shift assignment
-        "&=", "|=", "^=",           // bitwise assignment
-    };
-
     // Find start of actual content (skip leading whitespace)
-    size_t first_char_pos = line.find_first_not_of(" \t");
+    size_t first_char_pos = firstNonBlank(line);
     if (first_char_pos == string::npos)
         return;
     int start_column = first_char_pos + 1;
 
-    string content_part = line.substr(first_char_pos);
+    string_view content_part = line.substr(first_char_pos);
     int current_token_start_col = start_column;
 
     for (size_t i = 0; i < content_part.size(); ++i) {
@@ -223,7 +834,7 @@ void Lexer::tokenizeLine(const string &line)
         int absolute_col = first_char_pos + i + 1;
 
         if (in_string) {
-            current_token += ch;
+            extendLexeme(current_token, content_part, i);
             // Check for end of string literal, handling basic escapes
             if (ch == string_delim) {
                 bool escaped = false;
@@ -240,27 +851,21 @@ void Lexer::tokenizeLine(const string &line)
                 if (!escaped) {
                     // End of string found
                     buffer.emplace_back(current_token, STRING, line_number, current_token_start_col);
-                    current_token.clear();
+                    current_token = {};
                     in_string = false;
                     current_token_start_col = absolute_col + 1; // Next token starts after quote
                 }
             }
         } else {
-            // Check for multi-character operators
-            bool is_multi_char_op = false;
-            for (const string &op : multi_char_operators) {
-                if (content_part.substr(i, op.size()) == op) {
-                    if (!current_token.empty()) {
-                        tokenizeWord(current_token, current_token_start_col);
-                        current_token.clear();
-                    }
-                    buffer.emplace_back(op, OPERATOR, line_number, absolute_col);
-                    i += op.size() - 1; // Skip the length of the operator
-                    is_multi_char_op = true;
-                    break;
+            // Check for multi-character operators (longest match)
+            size_t op_length = matchMultiCharOperator(content_part, i);
+            if (op_length > 0) {
+                if (!current_token.empty()) {
+                    tokenizeWord(current_token, current_token_start_col);
+                    current_token = {};
                 }
-            }
-            if (is_multi_char_op) {
+                buffer.emplace_back(content_part.substr(i, op_length), OPERATOR, line_number, absolute_col);
+                i += op_length - 1; // Skip the length of the operator
                 continue;
             }
 
@@ -268,48 +873,48 @@ void Lexer::tokenizeLine(const string &line)
                 // Tokenize any accumulated word before the string starts
                 if (!current_token.empty()) {
                     tokenizeWord(current_token, current_token_start_col);
-                    current_token.clear();
+                    current_token = {};
                 }
                 // Start the string token
                 in_string = true;
                 string_delim = ch;
-                current_token += ch;
+                extendLexeme(current_token, content_part, i);
                 current_token_start_col = absolute_col; // String starts at this quote
             } else if (isdigit(ch)
                        || (ch == '.' && !current_token.empty() && isdigit(current_token.back()))) {
                 // Handle numbers (including decimal points)
                 if (current_token.empty() && !isdigit(ch)) {
                     // Handle standalone decimal point or other symbols
-                    tokenizeWord(string(1, ch), absolute_col);
+                    tokenizeWord(content_part.substr(i, 1), absolute_col);
                 } else {
                     if (current_token.empty()) {
                         current_token_start_col = absolute_col;
                     }
-                    current_token += ch;
+                    extendLexeme(current_token, content_part, i);
                 }
             } else if (isspace(ch)) {
                 if (!current_token.empty()) {
                     tokenizeWord(current_token, current_token_start_col);
-                    current_token.clear();
+                    current_token = {};
                 }
                 current_token_start_col = absolute_col + 1;
-            } else if (isSymbol(string(1, ch)) || isOperator(string(1, ch))) {
+            } else if (isOperatorOrSymbolChar(ch)) {
                 // Don't split if we're in the middle of a number with decimal point
                 if (!current_token.empty() && (ch == '.' && isdigit(current_token.back()))) {
-                    current_token += ch;
+                    extendLexeme(current_token, content_part, i);
                 } else {
                     if (!current_token.empty()) {
                         tokenizeWord(current_token, current_token_start_col);
-                        current_token.clear();
+                        current_token = {};
                     }
-                    tokenizeWord(string(1, ch), absolute_col);
+                    tokenizeWord(content_part.substr(i, 1), absolute_col);
                     current_token_start_col = absolute_col + 1;
                 }
             } else {
                 if (current_token.empty()) {
                     current_token_start_col = absolute_col;
                 }
-                current_token += ch;
+                extendLexeme(current_token, content_part, i);
             }
         }
     }
@@ -320,7 +925,7 @@ void Lexer::tokenizeLine(const string &line)
     }
 }
 
-bool Lexer::isIdentifierPosition(const string &token)
+bool Lexer::isIdentifierPosition(string_view token)
 {
     // Check current buffer for contextual clues
     if (!buffer.empty()) {
@@ -335,28 +940,30 @@ bool Lexer::isIdentifierPosition(const string &token)
     return false;
 }
 
-void Lexer::tokenizeWord(const string &word, int start_column)
+void Lexer::tokenizeWord(string_view word, int start_column)
 {
+    bool use_dfa = (scan_mode == ScanMode::DFA);
+
     // === Check for invalid floats ===
-    if (regex_match(word, regex(R"(^[+-]?\d*(\.\d+){2,}$)"))) {
+    if (use_dfa ? dfaIsMalformedFloat(word)
+                : regex_match(word.begin(), word.end(), regex(R"(^[+-]?\d*(\.\d+){2,}$)"))) {
         buffer.emplace_back(word, ERROR, line_number, start_column);
-        cerr << "Lexical Error at Line " << line_number << ", Column " << start_column
-             << ": Invalid float number: '" << word << "'\n";
+        diagnostics.report(DiagnosticCode::INVALID_FLOAT, line_number, start_column, word);
         return;
     }
     // === Check if the token starts with digits followed by letters (e.g. 123abc) ===
-    if (regex_match(word, regex(R"(^\d+[a-zA-Z_][a-zA-Z0-9_]*$)"))) {
+    if (use_dfa ? dfaIsDigitLedIdentifier(word)
+                : regex_match(word.begin(), word.end(), regex(R"(^\d+[a-zA-Z_][a-zA-Z0-9_]*$)"))) {
         buffer.emplace_back(word, ERROR, line_number, start_column);
-        cerr << "Lexical Error at Line " << line_number << ", Column " << start_column
-             << ": Identifier cannot start with a digit: '" << word << "'\n";
+        diagnostics.report(DiagnosticCode::DIGIT_LED_IDENTIFIER, line_number, start_column, word);
         return;
     }
 
     // === Check for invalid characters in identifiers (e.g. @, #, etc.) ===
-    if (regex_match(word, regex(R"(^[a-zA-Z_][a-zA-Z0-9_]*[^a-zA-Z0-9_\s]+[a-zA-Z0-9_]*$)"))) {
+    if (use_dfa ? dfaHasInvalidIdentifierChar(word)
+                : regex_match(word.begin(), word.end(), regex(R"(^[a-zA-Z_][a-zA-Z0-9_]*[^a-zA-Z0-9_\s]+[a-zA-Z0-9_]*$)"))) {
         buffer.emplace_back(word, ERROR, line_number, start_column);
-        cerr << "Lexical Error at Line " << line_number << ", Column " << start_column
-             << ": Invalid character in identifier: '" << word << "'\n";
+        diagnostics.report(DiagnosticCode::INVALID_IDENTIFIER_CHAR, line_number, start_column, word);
         return;
     }
 
@@ -368,144 +975,176 @@ void Lexer::tokenizeWord(const string &word, int start_column)
     //     return;
     // }
 
+    if (use_dfa) {
+        scanWordDFA(word, start_column);
+        return;
+    }
+
     static const std::regex splitter(
         R"(([-+]?\d*\.\d+|[-+]?\d+\.\d*|\d+|[A-Za-z_][A-Za-z0-9_]*|\+=|-=|\*=|/=|%=|\*\*=|//=|&=|\|=|\^=|<<=|>>=|!=|==|<=|>=|<<|>>|//|\*\*|and|or|not|[+\-*/%<>=&|\^~\.\(\)\{\}\[\]:;,])|.)");
 
-    auto words_begin = sregex_iterator(word.begin(), word.end(), splitter);
-    auto words_end = sregex_iterator();
+    auto words_begin = cregex_iterator(word.data(), word.data() + word.size(), splitter);
+    auto words_end = cregex_iterator();
 
-    for (sregex_iterator it = words_begin; it != words_end; ++it) {
-        smatch match = *it;
-        string token = match.str(0);
+    for (cregex_iterator it = words_begin; it != words_end; ++it) {
+        const cmatch &match = *it;
+        string_view token = word.substr(match.position(0), match.length(0));
         int token_start_col = start_column + match.position(0);
 
         if (token.empty() || all_of(token.begin(), token.end(), ::isspace)) {
             continue;
         }
 
-        bool preceded_by_numeric_in_buffer = !buffer.empty() && buffer.back().type == NUMERIC;
-        // *** NEW: Check if the last token in the line's buffer was an IDENTIFIER ***
-        bool preceded_by_identifier_in_buffer = !buffer.empty() && buffer.back().type == IDENTIFIER;
+        LexemeClass lexeme_class;
+        if (lookupKeyword(token))
+            lexeme_class = LexemeClass::WORD;
+        else if (isOperator(token))
+            lexeme_class = LexemeClass::OPERATOR;
+        else if (isSymbol(token))
+            lexeme_class = LexemeClass::SYMBOL;
+        else if (isFloat(token) || isInteger(token))
+            lexeme_class = LexemeClass::NUMBER;
+        else if (isIdentifier(token))
+            lexeme_class = LexemeClass::WORD;
+        else
+            lexeme_class = LexemeClass::INVALID;
 
+        addWordToken(token, token_start_col, lexeme_class);
+    }
+}
 
-        // === Reserved Keyword ===
-        if (keywords.count(token)) {
-            if (preceded_by_numeric_in_buffer) {
-                bool is_allowed_after_numeric =
-                    (token == "and" || token == "or" || token == "not" ||
-                     token == "if" || token == "else" || token == "in");
-                if (!is_allowed_after_numeric) {
-                    buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                    cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                         << ": Keyword '" << token << "' cannot directly follow a numeric literal in this context.\n";
-                    continue;
-                }
+// --- DFA Word Scanner ---
+// Splits a word in a single forward pass using maximal munch over the DFA
+// tables; produces the same lexemes as the regex splitter above.
+void Lexer::scanWordDFA(string_view word, int start_column)
+{
+    const DfaTables &dfa = dfaTables();
+    size_t pos = 0;
+    size_t n = word.size();
+
+    while (pos < n) {
+        int state = S_START;
+        size_t length = 0;
+        LexemeClass lexeme_class = LexemeClass::NONE;
+
+        for (size_t i = pos; i < n; ++i) {
+            state = dfa.next[state][dfa.char_class[(unsigned char) word[i]]];
+            if (state == S_DEAD)
+                break;
+            if (dfa.accept[state] != LexemeClass::NONE) {
+                length = i - pos + 1;
+                lexeme_class = dfa.accept[state];
+            }
+        }
+
+        // Every character is accepted on its own from S_START
+        if (lexeme_class != LexemeClass::SKIP)
+            addWordToken(word.substr(pos, length), start_column + pos, lexeme_class);
+        pos += length;
+    }
+}
+
+// --- Word Token Classification ---
+void Lexer::addWordToken(string_view token, int token_start_col, LexemeClass lexeme_class)
+{
+    bool preceded_by_numeric_in_buffer = !buffer.empty() && buffer.back().type == NUMERIC;
+    // *** NEW: Check if the last token in the line's buffer was an IDENTIFIER ***
+    bool preceded_by_identifier_in_buffer = !buffer.empty() && buffer.back().type == IDENTIFIER;
+
+    // === Reserved Keyword ===
+    TokenType keyword_type;
+    if (lexeme_class == LexemeClass::WORD && lookupKeyword(token, &keyword_type)) {
+        if (preceded_by_numeric_in_buffer) {
+            bool is_allowed_after_numeric =
+                (token == "and" || token == "or" || token == "not" ||
+                 token == "if" || token == "else" || token == "in");
+            if (!is_allowed_after_numeric) {
+                buffer.emplace_back(token, ERROR, line_number, token_start_col);
+                diagnostics.report(DiagnosticCode::KEYWORD_AFTER_NUMBER, line_number, token_start_col, token);
+                return;
             }
+        }
 
 
-            bool is_assignment_context = false;
-            bool is_boolean_operator = (token == "and" || token == "or" || token == "not");
-            bool is_data_type = (keywords.at(token) == DATA_TYPE);
+        bool is_assignment_context = false;
+        bool is_boolean_operator = (token == "and" || token == "or" || token == "not");
+        bool is_data_type = (keyword_type == DATA_TYPE);
 
-            if (!buffer.empty()) {
-                string prev_lexeme_in_buffer = buffer.back().lexeme;
-                TokenType prev_type_in_buffer = buffer.back().type;
-                if ( (prev_type_in_buffer == OPERATOR && prev_lexeme_in_buffer == "=") ||
-                    (prev_type_in_buffer == OPERATOR && prev_lexeme_in_buffer == ".") ||
-                    prev_type_in_buffer == LPAREN ) {
-                    if (!is_boolean_operator && !is_data_type) {
+        if (!buffer.empty()) {
+            string_view prev_lexeme_in_buffer = buffer.back().lexeme;
+            TokenType prev_type_in_buffer = buffer.back().type;
+            if ( (prev_type_in_buffer == OPERATOR && prev_lexeme_in_buffer == "=") ||
+                (prev_type_in_buffer == OPERATOR && prev_lexeme_in_buffer == ".") ||
+                prev_type_in_buffer == LPAREN ) {
+                if (!is_boolean_operator && !is_data_type) {
+                    is_assignment_context = true;
+                // } else if (prev_lexeme_in_buffer == "=" && is_boolean_operator) {
+                //     is_assignment_context = true;
+                } else if ( (prev_lexeme_in_buffer == "." || prev_type_in_buffer == LPAREN) && is_data_type) {
+                    if (prev_lexeme_in_buffer == "."){
                         is_assignment_context = true;
-                    // } else if (prev_lexeme_in_buffer == "=" && is_boolean_operator) {
-                    //     is_assignment_context = true;
-                    } else if ( (prev_lexeme_in_buffer == "." || prev_type_in_buffer == LPAREN) && is_data_type) {
-                        if (prev_lexeme_in_buffer == "."){
-                            is_assignment_context = true;
-                        }
                     }
                 }
             }
+        }
 
-            if (is_assignment_context) {
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Reserved keyword '" << token << "' cannot be used as an identifier or in this context.\n";
-            } else {
-                buffer.emplace_back(token, keywords.at(token), line_number, token_start_col);
-            }
+        if (is_assignment_context) {
+            buffer.emplace_back(token, ERROR, line_number, token_start_col);
+            diagnostics.report(DiagnosticCode::KEYWORD_IN_CONTEXT, line_number, token_start_col, token);
+        } else {
+            buffer.emplace_back(token, keyword_type, line_number, token_start_col);
         }
-        // === Operator ===
-        else if (isOperator(token)) {
-            buffer.emplace_back(token, OPERATOR, line_number, token_start_col);
-        }
-        // === Symbols ===
-        else if (token == "(") buffer.emplace_back(token, LPAREN, line_number, token_start_col);
-        else if (token == ")") buffer.emplace_back(token, RPAREN, line_number, token_start_col);
-        else if (token == "[") buffer.emplace_back(token, LBRACKET, line_number, token_start_col);
-        else if (token == "]") buffer.emplace_back(token, RBRACKET, line_number, token_start_col);
-        else if (token == "{") buffer.emplace_back(token, LBRACE, line_number, token_start_col);
-        else if (token == "}") buffer.emplace_back(token, RBRACE, line_number, token_start_col);
-        else if (token == ":" || token == "," || token == ";") {
-            buffer.emplace_back(token, SYMBOL, line_number, token_start_col);
-        }
-        // === Float ===
-        else if (isFloat(token)) {
-            if (preceded_by_numeric_in_buffer) {
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Numeric literal '" << token << "' cannot directly follow another numeric literal without an operator.\n";
-            } else if (preceded_by_identifier_in_buffer) { // e.g. `myVar 3.14`
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Numeric literal '" << token << "' cannot directly follow an identifier ('"
-                     << buffer.back().lexeme << "') without an operator or separator.\n";
-            }
-            else {
-                buffer.emplace_back(token, NUMERIC, line_number, token_start_col);
-                // addToSymbolTable(token, "Numeric");
-            }
+    }
+    // === Operator ===
+    else if (lexeme_class == LexemeClass::OPERATOR) {
+        buffer.emplace_back(token, OPERATOR, line_number, token_start_col);
+    }
+    // === Symbols ===
+    else if (token == "(") buffer.emplace_back(token, LPAREN, line_number, token_start_col);
+    else if (token == ")") buffer.emplace_back(token, RPAREN, line_number, token_start_col);
+    else if (token == "[") buffer.emplace_back(token, LBRACKET, line_number, token_start_col);
+    else if (token == "]") buffer.emplace_back(token, RBRACKET, line_number, token_start_col);
+    else if (token == "{") buffer.emplace_back(token, LBRACE, line_number, token_start_col);
+    else if (token == "}") buffer.emplace_back(token, RBRACE, line_number, token_start_col);
+    else if (token == ":" || token == "," || token == ";") {
+        buffer.emplace_back(token, SYMBOL, line_number, token_start_col);
+    }
+    // === Float / Integer ===
+    else if (lexeme_class == LexemeClass::NUMBER) {
+        if (preceded_by_numeric_in_buffer) {
+            buffer.emplace_back(token, ERROR, line_number, token_start_col);
+            diagnostics.report(DiagnosticCode::NUMBER_AFTER_NUMBER, line_number, token_start_col, token);
+        } else if (preceded_by_identifier_in_buffer) { // e.g. `myVar 3.14`
+            buffer.emplace_back(token, ERROR, line_number, token_start_col);
+            diagnostics.report(DiagnosticCode::NUMBER_AFTER_IDENTIFIER, line_number, token_start_col, token,
+                               buffer.back().lexeme);
         }
-        // === Integer ===
-        else if (isInteger(token)) {
-            if (preceded_by_numeric_in_buffer) {
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Numeric literal '" << token << "' cannot directly follow another numeric literal without an operator.\n";
-            } else if (preceded_by_identifier_in_buffer) { // e.g. `myVar 123`
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Numeric literal '" << token << "' cannot directly follow an identifier ('"
-                     << buffer.back().lexeme << "') without an operator or separator.\n";
-            }
-            else {
-                buffer.emplace_back(token, NUMERIC, line_number, token_start_col);
-                // addToSymbolTable(token, "Numeric");
-            }
+        else {
+            buffer.emplace_back(token, NUMERIC, line_number, token_start_col);
+            // addToSymbolTable(token, "Numeric");
         }
-        // === Valid Identifier ===
-        else if (isIdentifier(token)) {
-            if (preceded_by_numeric_in_buffer) {
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Identifier '" << token << "' cannot directly follow a numeric literal without an operator.\n";
-            }
-            // *** THIS IS THE KEY CHANGE FOR "hello world = 1" ***
-            else if (preceded_by_identifier_in_buffer) {
-                buffer.emplace_back(token, ERROR, line_number, token_start_col);
-                cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                     << ": Identifier '" << token << "' cannot directly follow another identifier ('"
-                     << buffer.back().lexeme << "') without an operator or separator.\n";
-            }
-            else {
-                buffer.emplace_back(token, IDENTIFIER, line_number, token_start_col);
-                addToSymbolTable(token, "Identifier");
-            }
+    }
+    // === Valid Identifier ===
+    else if (lexeme_class == LexemeClass::WORD) {
+        if (preceded_by_numeric_in_buffer) {
+            buffer.emplace_back(token, ERROR, line_number, token_start_col);
+            diagnostics.report(DiagnosticCode::IDENTIFIER_AFTER_NUMBER, line_number, token_start_col, token);
         }
-        // === Catch-all: unknown/illegal token ===
-        else {
+        // *** THIS IS THE KEY CHANGE FOR "hello world = 1" ***
+        else if (preceded_by_identifier_in_buffer) {
             buffer.emplace_back(token, ERROR, line_number, token_start_col);
-            cerr << "Lexical Error at Line " << line_number << ", Column " << token_start_col
-                 << ": Unknown or invalid token '" << token << "'\n";
+            diagnostics.report(DiagnosticCode::IDENTIFIER_AFTER_IDENTIFIER, line_number, token_start_col, token,
+                               buffer.back().lexeme);
         }
+        else {
+            buffer.emplace_back(token, IDENTIFIER, line_number, token_start_col);
+            addToSymbolTable(token, "Identifier");
+        }
+    }
+    // === Catch-all: unknown/illegal token ===
+    else {
+        buffer.emplace_back(token, ERROR, line_number, token_start_col);
+        diagnostics.report(DiagnosticCode::UNKNOWN_TOKEN, line_number, token_start_col, token);
     }
 }
 
@@ -557,10 +1196,10 @@ string Lexer::getTokenTypeName(TokenType type)
 }
 
 // --- Map for Operator Descriptions ---
-const map<string, string> &Lexer::getOperatorDescriptions()
+const map<string, string, less<>> &Lexer::getOperatorDescriptions()
 {
-    // Static map initialized once
-    static const map<string, string> descriptions = {
+    // Static map initialized once (transparent comparator so string_view lexemes can look it up)
+    static const map<string, string, less<>> descriptions = {
         {"=", "Assignment"},
         {"+", "Addition"},
         {"-", "Subtraction"},
@@ -597,81 +1236,886 @@ const map<string, string> &Lexer::getOperatorDescriptions()
     return descriptions;
 }
 
+// --- Structural Index ---
+namespace {
+
+struct BlockMasks {
+    uint64_t newline, single_quote, double_quote, hash, blank;
+};
+
+using BlockScanner = void (*)(const char *block, BlockMasks &masks);
+
+// Also scans the final partial block, so `length` may be below 64
+void scanBlockScalar(const char *block, size_t length, BlockMasks &masks)
+{
+    masks = {};
+    for (size_t i = 0; i < length; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+        case '\n': masks.newline |= bit; break;
+        case '\'': masks.single_quote |= bit; break;
+        case '"': masks.double_quote |= bit; break;
+        case '#': masks.hash |= bit; break;
+        case ' ':
+        case '\t': masks.blank |= bit; break;
+        default: break;
+        }
+    }
+}
+
+#ifdef LEXER_HAVE_SSE2
+void scanBlockSSE2(const char *block, BlockMasks &masks)
+{
+    const __m128i newline = _mm_set1_epi8('\n'), single_quote = _mm_set1_epi8('\'');
+    const __m128i double_quote = _mm_set1_epi8('"'), hash = _mm_set1_epi8('#');
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    auto mask = [](__m128i eq, int shift) {
+        return uint64_t(uint16_t(_mm_movemask_epi8(eq))) << shift;
+    };
+    masks = {};
+    for (int i = 0; i < 64; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        masks.newline |= mask(_mm_cmpeq_epi8(v, newline), i);
+        masks.single_quote |= mask(_mm_cmpeq_epi8(v, single_quote), i);
+        masks.double_quote |= mask(_mm_cmpeq_epi8(v, double_quote), i);
+        masks.hash |= mask(_mm_cmpeq_epi8(v, hash), i);
+        masks.blank |= mask(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)), i);
+    }
+}
+#endif
+
+#ifdef LEXER_HAVE_AVX2
+LEXER_AVX2_TARGET void scanBlockAVX2(const char *block, BlockMasks &masks)
+{
+    const __m256i newline = _mm256_set1_epi8('\n'), single_quote = _mm256_set1_epi8('\'');
+    const __m256i double_quote = _mm256_set1_epi8('"'), hash = _mm256_set1_epi8('#');
+    const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+    masks = {};
+    for (int i = 0; i < 64; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+        masks.newline |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)))) << i;
+        masks.single_quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, single_quote)))) << i;
+        masks.double_quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, double_quote)))) << i;
+        masks.hash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, hash)))) << i;
+        __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab));
+        masks.blank |= uint64_t(uint32_t(_mm256_movemask_epi8(blank))) << i;
+    }
+}
+#endif
+
+// Widest kernel this CPU runs, picked once
+BlockScanner selectBlockScanner()
+{
+#ifdef LEXER_HAVE_AVX2
+    if (cpuHasAVX2())
+        return scanBlockAVX2;
+#endif
+#ifdef LEXER_HAVE_SSE2
+    return scanBlockSSE2;
+#else
+    return [](const char *block, BlockMasks &masks) { scanBlockScalar(block, 64, masks); };
+#endif
+}
+
+inline int lowestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int highestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(word);
+#endif
+}
+
+// First position in [from, end) whose bit is set (or clear, if `invert`)
+size_t scanForward(const vector<uint64_t> &bits, size_t from, size_t end, bool invert)
+{
+    if (from >= end)
+        return StructuralIndex::npos;
+    const uint64_t flip = invert ? ~uint64_t(0) : 0;
+    size_t w = from / 64;
+    size_t last_w = (end - 1) / 64;
+    uint64_t word = (bits[w] ^ flip) & (~uint64_t(0) << (from % 64));
+    while (!word) {
+        if (++w > last_w)
+            return StructuralIndex::npos;
+        word = bits[w] ^ flip;
+    }
+    size_t pos = w * 64 + lowestBit(word);
+    return pos < end ? pos : StructuralIndex::npos;
+}
+
+// Last position in [from, end) whose bit is clear
+size_t scanBackwardClear(const vector<uint64_t> &bits, size_t from, size_t end)
+{
+    if (from >= end)
+        return StructuralIndex::npos;
+    size_t w = (end - 1) / 64;
+    size_t first_w = from / 64;
+    size_t top = (end - 1) % 64;
+    uint64_t word = ~bits[w];
+    if (top < 63)
+        word &= (uint64_t(2) << top) - 1;
+    while (!word) {
+        if (w == first_w)
+            return StructuralIndex::npos;
+        word = ~bits[--w];
+    }
+    size_t pos = w * 64 + highestBit(word);
+    return pos >= from ? pos : StructuralIndex::npos;
+}
+
+} // namespace
+
+void StructuralIndex::build(string_view text)
+{
+    static const BlockScanner scan_block = selectBlockScanner();
+
+    size_t blocks = (text.size() + 63) / 64;
+    for (auto *bits : {&newline_bits, &single_quote_bits, &double_quote_bits, &hash_bits, &blank_bits})
+        bits->assign(blocks + 1, 0);
+
+    BlockMasks masks;
+    for (size_t b = 0; b < blocks; ++b) {
+        size_t length = min<size_t>(64, text.size() - b * 64);
+        if (length == 64)
+            scan_block(text.data() + b * 64, masks);
+        else
+            scanBlockScalar(text.data() + b * 64, length, masks);
+        newline_bits[b] = masks.newline;
+        single_quote_bits[b] = masks.single_quote;
+        double_quote_bits[b] = masks.double_quote;
+        hash_bits[b] = masks.hash;
+        blank_bits[b] = masks.blank;
+    }
+}
+
+size_t StructuralIndex::findNewline(size_t from, size_t end) const
+{
+    return scanForward(newline_bits, from, end, false);
+}
+
+size_t StructuralIndex::findHash(size_t from, size_t end) const
+{
+    return scanForward(hash_bits, from, end, false);
+}
+
+size_t StructuralIndex::findFirstNonBlank(size_t from, size_t end) const
+{
+    return scanForward(blank_bits, from, end, true);
+}
+
+size_t StructuralIndex::findLastNonBlank(size_t from, size_t end) const
+{
+    return scanBackwardClear(blank_bits, from, end);
+}
+
+size_t StructuralIndex::findTripleQuote(char quote, size_t from, size_t end) const
+{
+    if (end < 3 || from > end - 3)
+        return npos;
+    const vector<uint64_t> &bits = quote == '\'' ? single_quote_bits : double_quote_bits;
+    size_t last_start = end - 3;
+    uint64_t mask = ~uint64_t(0) << (from % 64);
+    for (size_t w = from / 64; w <= last_start / 64; ++w, mask = ~uint64_t(0)) {
+        // A set bit marks a quote followed by two more, possibly in the next word
+        uint64_t cur = bits[w], next = bits[w + 1];
+        uint64_t runs = cur & ((cur >> 1) | (next << 63)) & ((cur >> 2) | (next << 62)) & mask;
+        if (runs) {
+            size_t pos = w * 64 + lowestBit(runs);
+            return pos <= last_start ? pos : npos;
+        }
+    }
+    return npos;
+}
+
+// --- Source Buffer ---
+SourceBuffer::~SourceBuffer()
+{
+    if (mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapped);
+#else
+        munmap(const_cast<char *>(mapped), mapped_size);
+#endif
+    }
+}
+
+void SourceBuffer::mapFile(const string &path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw runtime_error("Could not open file: " + path);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw runtime_error("Could not read file size: " + path);
+    }
+    if (size.QuadPart > 0) {
+        // The view stays valid after both handles are closed
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping)
+            CloseHandle(mapping);
+        if (!view) {
+            CloseHandle(file);
+            throw runtime_error("Could not map file: " + path);
+        }
+        mapped = static_cast<const char *>(view);
+        mapped_size = static_cast<size_t>(size.QuadPart);
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("Could not open file: " + path);
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw runtime_error("Could not read file size: " + path);
+    }
+    if (info.st_size > 0) {
+        // The mapping stays valid after the descriptor is closed
+        void *view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Could not map file: " + path);
+        }
+        madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+        mapped = static_cast<const char *>(view);
+        mapped_size = static_cast<size_t>(info.st_size);
+    }
+    close(fd);
+#endif
+    text = string_view(mapped, mapped_size);
+}
+
 // --- Main Tokenization Process ---
 void Lexer::tokenize(const string &source_code)
 {
-    istringstream stream(source_code);
-    string line;
-    indentation_levels.push(0);        // Start at base indentation level 0
-    bool in_multiline_comment = false; // Track if inside a multi-line comment
-    string comment_delim = "\0";       // Track the delimiter for multi-line comments
-
-    while (getline(stream, line)) {
-        string original_line = line; // Keep for indentation calculation
-
-        // Handle multi-line comments
-        if (in_multiline_comment) {
-            size_t end_pos = line.find(comment_delim + string(comment_delim) + comment_delim);
-            if (end_pos != string::npos) {
-                in_multiline_comment = false;    // End of multi-line comment
-                line = line.substr(end_pos + 3); // Skip the comment
-            } else {
-                continue; // Skip the entire line if still inside the comment
+    // The only copy of the source text; every lexeme is a view into it
+    source = make_shared<SourceBuffer>();
+    source->owned = source_code;
+    source->text = source->owned;
+    streaming = false;
+    tokenizeSource(false);
+}
+
+void Lexer::tokenizeFile(const string &path)
+{
+    // Scan the file in place; throws runtime_error if it cannot be mapped
+    source = make_shared<SourceBuffer>();
+    source->mapFile(path);
+
+    // Match what the editor shows for the same file: no UTF-8 BOM, and
+    // CRLF line endings read as LF (the '\r' is dropped per line below)
+    if (source->text.substr(0, 3) == "\xEF\xBB\xBF")
+        source->text.remove_prefix(3);
+    streaming = false;
+    tokenizeSource(true);
+}
+
+void Lexer::tokenizeSource(bool strip_cr)
+{
+    startSource(strip_cr);
+    unsigned threads = worker_threads ? worker_threads : max(1u, thread::hardware_concurrency());
+    if (threads > 1 && !track_lines && source->text.size() >= parallel_min_bytes) {
+        tokenizeParallel(threads);
+    } else {
+        while (lexNextLine()) {
+            if (cancel_token) {
+                cancel_token->throwIfCancelled();
+                cancel_token->report(next_line_start, line_limit);
             }
         }
+    }
+    finishSource();
+}
 
-        // Handle single-line comments and detect start of multi-line comments
-        size_t comment_pos = line.find('#');
-        size_t triple_single_pos = line.find("'''");
-        size_t triple_double_pos = line.find("\"\"\"");
+void Lexer::startSource(bool strip_cr)
+{
+    resetSource();
+    tokens_replaced = true;
+    tokens.setSource(source->text);
+    // Streamed input is lexed a line at a time to keep memory bounded, so
+    // only batch lexing pays for the index up front
+    if (!streaming)
+        source->index.build(source->text);
+    spill = &source->spill;
+    this->strip_cr = strip_cr;
+    next_line_start = 0;
+    line_limit = source->text.size();
+    read_index = 0;
+    stream_finished = false;
 
-        if (triple_single_pos != string::npos || triple_double_pos != string::npos) {
-            size_t start_pos = (triple_single_pos != string::npos) ? triple_single_pos
-                                                                   : triple_double_pos;
-            comment_delim = (triple_single_pos != string::npos) ? '\'' : '"';
-            size_t end_pos = line.find(comment_delim + string(comment_delim) + comment_delim,
-                                       start_pos + 3);
+    indentation_levels.push_back(0); // Start at base indentation level 0
+    in_multiline_comment = false;
+    comment_delim = {};
+}
 
-            if (end_pos != string::npos) {
-                // Multi-line comment starts and ends on the same line
-                line = line.substr(0, start_pos) + line.substr(end_pos + 3);
-            } else {
-                // Multi-line comment starts but doesn't end
-                in_multiline_comment = true;
-                line = line.substr(0, start_pos);
-            }
-        } else if (comment_pos != string::npos) {
-            // Handle single-line comments
-            line = line.substr(0, comment_pos);
+// Drops what a previous run left behind, so a Lexer can be reused
+void Lexer::resetSource()
+{
+    tokens = TokenStream();
+    diagnostics.clear();
+    buffer.clear();
+    symbol_table.clear();
+    symbol_presence.clear();
+    symbols_stale = false;
+    indentation_levels.clear();
+    line_number = 1;
+    line_records.clear();
+    indent_pool.clear();
+}
+
+// Offset of `view` in the indexed source text, or npos if the source has no
+// index or the view lives elsewhere (spill storage, string literals)
+size_t Lexer::indexedOffset(string_view view) const
+{
+    string_view text = source->text;
+    if (!source->index.built() || view.data() < text.data()
+        || view.data() + view.size() > text.data() + text.size())
+        return string::npos;
+    return view.data() - text.data();
+}
+
+// Line searches: answered from the structural index when `line` is a view
+// into the indexed source, by the equivalent string_view search otherwise.
+// Results are relative to `line`.
+size_t Lexer::findHashInLine(string_view line) const
+{
+    size_t base = indexedOffset(line);
+    if (base == string::npos)
+        return line.find('#');
+    size_t pos = source->index.findHash(base, base + line.size());
+    return pos == string::npos ? pos : pos - base;
+}
+
+size_t Lexer::findTripleQuoteInLine(string_view line, char quote, size_t from) const
+{
+    size_t base = indexedOffset(line);
+    if (base == string::npos)
+        return line.find(quote == '\'' ? "'''" : "\"\"\"", from);
+    size_t pos = source->index.findTripleQuote(quote, base + min(from, line.size()), base + line.size());
+    return pos == string::npos ? pos : pos - base;
+}
+
+size_t Lexer::firstNonBlank(string_view line) const
+{
+    size_t base = indexedOffset(line);
+    if (base == string::npos)
+        return line.find_first_not_of(" \t");
+    size_t pos = source->index.findFirstNonBlank(base, base + line.size());
+    return pos == string::npos ? pos : pos - base;
+}
+
+size_t Lexer::lastNonBlank(string_view line) const
+{
+    size_t base = indexedOffset(line);
+    if (base == string::npos)
+        return line.find_last_not_of(" \t");
+    size_t pos = source->index.findLastNonBlank(base, base + line.size());
+    return pos == string::npos ? pos : pos - base;
+}
+
+// Returns the next physical line (without its '\n') and advances past it
+string_view Lexer::nextPhysicalLine()
+{
+    // Split on '\n' like getline: a trailing newline does not start an extra line
+    string_view text = source->text.substr(0, line_limit);
+    size_t line_end = source->index.built() ? source->index.findNewline(next_line_start, text.size())
+                                            : text.find('\n', next_line_start);
+    if (line_end == string_view::npos)
+        line_end = text.size();
+    string_view line = text.substr(next_line_start, line_end - next_line_start);
+    next_line_start = line_end + 1;
+    if (strip_cr && !line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+// Cuts comments out of `line` and tracks the triple-quote state; returns
+// false if the whole line is inside a multi-line comment
+bool Lexer::stripComments(string_view &line)
+{
+    // Handle multi-line comments
+    if (in_multiline_comment) {
+        size_t end_pos = findTripleQuoteInLine(line, comment_delim[0]);
+        if (end_pos != string::npos) {
+            in_multiline_comment = false;    // End of multi-line comment
+            line = line.substr(end_pos + 3); // Skip the comment
+        } else {
+            return false; // Skip the entire line if still inside the comment
         }
+    }
 
-        // Trim trailing whitespace
-        size_t last_char = line.find_last_not_of(" \t");
-        if (string::npos == last_char)
-            line.clear(); // Line is effectively empty
-        else
-            line = line.substr(0, last_char + 1);
+    // Handle single-line comments and detect start of multi-line comments
+    size_t comment_pos = findHashInLine(line);
+    size_t triple_single_pos = findTripleQuoteInLine(line, '\'');
+    size_t triple_double_pos = findTripleQuoteInLine(line, '"');
+
+    if (triple_single_pos != string::npos || triple_double_pos != string::npos) {
+        size_t start_pos = (triple_single_pos != string::npos) ? triple_single_pos
+                                                               : triple_double_pos;
+        comment_delim = (triple_single_pos != string::npos) ? "'''" : "\"\"\"";
+        size_t end_pos = findTripleQuoteInLine(line, comment_delim[0], start_pos + 3);
+
+        if (end_pos != string::npos) {
+            // Multi-line comment starts and ends on the same line; the joined
+            // remainder is not contiguous in the source, so it gets spill storage
+            spill->push_back(string(line.substr(0, start_pos)) + string(line.substr(end_pos + 3)));
+            line = spill->back();
+        } else {
+            // Multi-line comment starts but doesn't end
+            in_multiline_comment = true;
+            line = line.substr(0, start_pos);
+        }
+    } else if (comment_pos != string::npos) {
+        // Handle single-line comments
+        line = line.substr(0, comment_pos);
+    }
+    return true;
+}
+
+// Lexes the next source line into `tokens`; returns false at end of input
+bool Lexer::lexNextLine()
+{
+    if (next_line_start >= line_limit)
+        return false;
+    if (track_lines)
+        recordLineStart(next_line_start);
+    string_view line = nextPhysicalLine();
+    string_view original_line = line; // Keep for indentation calculation
+
+    if (!stripComments(line))
+        return true; // Line is inside a multi-line comment
+
+    // Trim trailing whitespace
+    size_t last_char = lastNonBlank(line);
+    if (string::npos == last_char)
+        line = {}; // Line is effectively empty
+    else
+        line = line.substr(0, last_char + 1);
 
-        // Handle indentation
+    // Handle indentation (parallel workers leave it to the merge pass)
+    if (deferred_lines)
+        deferred_lines->push_back({original_line, line_number, 0, 0});
+    else
         handleIndentation(original_line);
 
-        // Tokenize line content
-        tokenizeLine(line);
+    // Tokenize line content
+    tokenizeLine(line);
 
-        // Analyze buffer
-        analyzeBuffer();
+    // Analyze buffer
+    analyzeBuffer();
 
-        line_number++; // Move to next line number
+    if (deferred_lines) {
+        deferred_lines->back().token_end = tokens.size();
+        deferred_lines->back().diagnostic_end = diagnostics.size();
     }
 
+    line_number++; // Move to next line number
+    return true;
+}
+
+// --- Parallel Lexing ---
+// Lines only depend on each other through the triple-quote comment state,
+// the line counter (which does not advance inside a comment) and the
+// indentation stack. A sequential pre-scan tracks the first two and cuts the
+// source at line starts outside any comment; workers lex the chunks into
+// their own token streams, symbol tables and diagnostics; the merge pass then
+// replays handleIndentation line by line and stitches the results together
+// in source order, so the output matches the serial lexer exactly.
+void Lexer::tokenizeParallel(unsigned thread_count)
+{
+    struct Chunk {
+        size_t begin;
+        int first_line;
+    };
+
+    // Pre-scan: comment state and line numbers only
+    string_view text = source->text;
+    size_t target = max(text.size() / (thread_count * 4), PARALLEL_MIN_CHUNK);
+    vector<Chunk> chunks{{0, line_number}};
+    deque<string> scan_spill;
+    spill = &scan_spill;
+    int scan_line = line_number;
+    while (next_line_start < line_limit) {
+        if (next_line_start - chunks.back().begin >= target && !in_multiline_comment)
+            chunks.push_back({next_line_start, scan_line});
+        string_view line = nextPhysicalLine();
+        if (stripComments(line))
+            scan_line++;
+    }
+    spill = &source->spill;
+
+    // Lex the chunks; chunk_spill is sized up front so spilled lexemes never move
+    source->chunk_spill.resize(chunks.size());
+    vector<Lexer> workers(chunks.size());
+    vector<vector<LexedLine>> lines(chunks.size());
+    atomic<size_t> next_chunk{0};
+    atomic<size_t> lexed_bytes{0};
+    auto work = [&]() {
+        for (size_t c = next_chunk++; c < chunks.size(); c = next_chunk++) {
+            Lexer &worker = workers[c];
+            worker.scan_mode = scan_mode;
+            worker.source = source;
+            worker.tokens.setSource(text);
+            worker.spill = &source->chunk_spill[c];
+            worker.deferred_lines = &lines[c];
+            worker.strip_cr = strip_cr;
+            worker.line_number = chunks[c].first_line;
+            worker.next_line_start = chunks[c].begin;
+            worker.line_limit = c + 1 < chunks.size() ? chunks[c + 1].begin : text.size();
+            while (worker.lexNextLine()) {
+                if (cancel_token && cancel_token->isCancelled())
+                    return; // thrown below, once the other workers are joined
+            }
+            if (cancel_token)
+                cancel_token->report(lexed_bytes += worker.line_limit - chunks[c].begin, text.size());
+        }
+    };
+    vector<thread> pool;
+    for (size_t t = 1; t < min<size_t>(thread_count, chunks.size()); ++t)
+        pool.emplace_back(work);
+    work();
+    for (auto &t : pool)
+        t.join();
+    if (cancel_token)
+        cancel_token->throwIfCancelled();
+
+    // Merge in source order
+    size_t total_tokens = 0;
+    for (const auto &worker : workers)
+        total_tokens += worker.tokens.size();
+    tokens.reserve(total_tokens + indentation_levels.size() + 1);
+
+    vector<uint32_t> remap;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const Lexer &worker = workers[c];
+        size_t token_pos = 0;
+        size_t diagnostic_pos = 0;
+        remap.assign(worker.tokens.internedCount(), LEX_UNKNOWN);
+
+        for (const LexedLine &lexed : lines[c]) {
+            line_number = lexed.line_number;
+            handleIndentation(lexed.original_line);
+            diagnostics.append(worker.diagnostics, diagnostic_pos, lexed.diagnostic_end);
+            tokens.appendRange(worker.tokens, token_pos, lexed.token_end, remap);
+            token_pos = lexed.token_end;
+            diagnostic_pos = lexed.diagnostic_end;
+        }
+
+        // First occurrences per chunk, in order, give the serial symbol table
+        for (const auto &entry : worker.symbol_table) {
+            string_view name = worker.symbol_presence.find(entry.first)->first;
+            if (symbol_presence.find(name) == symbol_presence.end()) {
+                symbol_table.push_back(entry);
+                symbol_presence[name] = true;
+            }
+        }
+        line_number = worker.line_number;
+    }
+}
+
+void Lexer::finishSource()
+{
+    if (track_lines)
+        recordLineStart(source->text.size());
+
     // Post-processing for dedents and EOF
-    while (!indentation_levels.empty() && indentation_levels.top() > 0) {
-        indentation_levels.pop();
+    while (!indentation_levels.empty() && indentation_levels.back() > 0) {
+        indentation_levels.pop_back();
         tokens.emplace_back("DEDENT", DEDENT, line_number, 1);
     }
     tokens.emplace_back("EOF", END_OF_FILE, line_number, 1);
 }
 
+// --- Incremental Re-lexing ---
+static bool sameIndentation(const vector<int> &levels, const LineRecord &record, const vector<int> &pool)
+{
+    return record.indent_depth == levels.size()
+           && equal(levels.begin(), levels.end(), pool.begin() + record.indent_begin);
+}
+
+void Lexer::recordLineStart(size_t offset)
+{
+    LineRecord record{offset, tokens.size(), diagnostics.size(), line_number,
+                      in_multiline_comment ? comment_delim[0] : '\0', 0,
+                      static_cast<uint32_t>(indentation_levels.size())};
+    // Most lines share the previous line's indentation stack
+    if (!line_records.empty() && sameIndentation(indentation_levels, line_records.back(), indent_pool)) {
+        record.indent_begin = line_records.back().indent_begin;
+    } else {
+        record.indent_begin = static_cast<uint32_t>(indent_pool.size());
+        indent_pool.insert(indent_pool.end(), indentation_levels.begin(), indentation_levels.end());
+    }
+    line_records.push_back(record);
+}
+
+// True if the lexer is in the state `record` saw at the start of its line
+bool Lexer::matchesLineState(const LineRecord &record, const vector<int> &pool) const
+{
+    char quote = in_multiline_comment ? comment_delim[0] : '\0';
+    return record.comment_quote == quote && sameIndentation(indentation_levels, record, pool);
+}
+
+void Lexer::rebuildSymbolTable()
+{
+    // Identifiers are the only entries, in order of first appearance
+    symbols_stale = false;
+    symbol_table.clear();
+    symbol_presence.clear();
+    vector<bool> seen(tokens.internedCount(), false);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        TokenType type = tokens.type(i);
+        if ((type == IDENTIFIER || type == FUNCTION_IDENTIFIER) && !seen[tokens.id(i)]) {
+            seen[tokens.id(i)] = true;
+            symbol_table.emplace_back(string(tokens.lexeme(i)), make_pair(string("Identifier"), tokens.line(i)));
+            symbol_presence[tokens.lexeme(i)] = true;
+        }
+    }
+}
+
+void Lexer::detachSource()
+{
+    if (!source || !source->mapped)
+        return;
+
+    // The same bytes in a buffer of their own: an empty edit maps every view
+    // to the same offset in the copy
+    auto owned = make_shared<SourceBuffer>();
+    owned->owned.assign(source->text);
+    owned->text = owned->owned;
+    owned->spill.swap(source->spill);
+    owned->chunk_spill.swap(source->chunk_spill);
+    owned->index = move(source->index);
+
+    const SourceEdit unchanged{0, 0, 0};
+    tokens.relocate(unchanged, owned->text, owned->spill);
+    diagnostics.splice(0, 0, Diagnostics(), unchanged, source->text, owned->text, 0);
+    for (Token &token : buffer)
+        token.lexeme = unchanged.relocate(token.lexeme, source->text, owned->text);
+    unordered_map<string_view, bool> presence; // keyed by views into the text
+    presence.reserve(symbol_presence.size());
+    for (const auto &entry : symbol_presence)
+        presence.emplace(unchanged.relocate(entry.first, source->text, owned->text), entry.second);
+    symbol_presence.swap(presence);
+
+    source = owned;
+}
+
+void Lexer::applyEdit(size_t offset, size_t removed_length, string_view inserted)
+{
+    string_view old_text = source->text;
+    offset = min(offset, old_text.size());
+    removed_length = min(removed_length, old_text.size() - offset);
+    SourceEdit edit{offset, removed_length, inserted.size()};
+
+    // The edited text gets a buffer of its own, so the old one stays
+    // readable until every view has been moved over
+    auto edited = make_shared<SourceBuffer>();
+    edited->owned.reserve(old_text.size() - removed_length + inserted.size());
+    edited->owned.append(old_text.substr(0, offset));
+    edited->owned.append(inserted);
+    edited->owned.append(old_text.substr(offset + removed_length));
+    edited->text = edited->owned;
+
+    // Without line records, or while a getSource() handle still shares the
+    // spill storage, lex the edited text from scratch
+    if (!track_lines || streaming || line_records.size() < 2 || source.use_count() > 1) {
+        source = edited;
+        tokenizeSource(strip_cr);
+        return;
+    }
+    edited->spill.swap(source->spill);
+    edited->chunk_spill.swap(source->chunk_spill);
+
+    // Restart at the last line beginning at or before the edit
+    auto line_end = line_records.end() - 1; // the last record marks the end of input
+    size_t first = upper_bound(line_records.begin(), line_end, offset,
+                               [](size_t pos, const LineRecord &record) { return pos < record.offset; })
+                   - line_records.begin() - 1;
+    const LineRecord start = line_records[first];
+
+    Lexer worker;
+    worker.scan_mode = scan_mode;
+    worker.source = edited;
+    worker.tokens.setSource(edited->text);
+    worker.spill = &edited->spill;
+    worker.strip_cr = strip_cr;
+    worker.track_lines = true;
+    worker.line_number = start.line_number;
+    worker.next_line_start = start.offset;
+    worker.line_limit = edited->text.size();
+    worker.indentation_levels.assign(indent_pool.begin() + start.indent_begin,
+                                     indent_pool.begin() + start.indent_begin + start.indent_depth);
+    worker.in_multiline_comment = start.comment_quote != '\0';
+    worker.comment_delim = start.comment_quote == '\'' ? "'''" : start.comment_quote == '"' ? "\"\"\"" : "";
+
+    // Re-lex until a line past the edit starts in the state the old stream
+    // had there; from then on the old tokens are still right
+    size_t damage_end = offset + inserted.size();
+    ptrdiff_t shift = static_cast<ptrdiff_t>(inserted.size()) - static_cast<ptrdiff_t>(removed_length);
+    size_t resync = line_records.size();
+    while (worker.lexNextLine()) {
+        size_t pos = worker.next_line_start;
+        if (cancel_token) {
+            cancel_token->throwIfCancelled();
+            cancel_token->report(pos, edited->text.size());
+        }
+        if (pos < damage_end || pos >= edited->text.size())
+            continue;
+        size_t old_pos = pos - shift;
+        auto match = lower_bound(line_records.begin() + first, line_end, old_pos,
+                                 [](const LineRecord &record, size_t value) { return record.offset < value; });
+        if (match != line_end && match->offset == old_pos && worker.matchesLineState(*match, indent_pool)) {
+            resync = match - line_records.begin();
+            break;
+        }
+    }
+    bool at_end = resync == line_records.size();
+    if (at_end)
+        worker.finishSource();
+
+    size_t token_end = at_end ? tokens.size() : line_records[resync].token_begin;
+    size_t diagnostic_end = at_end ? diagnostics.size() : line_records[resync].diagnostic_begin;
+    int line_delta = at_end ? 0 : worker.line_number - line_records[resync].line_number;
+
+    TokenEdit token_change{start.token_begin, token_end, start.token_begin + worker.tokens.size()};
+    token_edit = tokens_edited ? token_edit.then(token_change) : token_change;
+    tokens_edited = true;
+    tokens.relocate(edit, edited->text, edited->spill);
+    tokens.splice(start.token_begin, token_end, worker.tokens, edit, line_delta);
+    diagnostics.splice(start.diagnostic_begin, diagnostic_end, worker.diagnostics, edit, old_text, edited->text,
+                       line_delta);
+
+    // Line records: shift the ones after the re-lexed lines, then swap in the new ones
+    ptrdiff_t token_shift = static_cast<ptrdiff_t>(worker.tokens.size()) - (token_end - start.token_begin);
+    ptrdiff_t diagnostic_shift = static_cast<ptrdiff_t>(worker.diagnostics.size())
+                                 - (diagnostic_end - start.diagnostic_begin);
+    for (size_t r = resync; r < line_records.size(); ++r) {
+        line_records[r].offset += shift;
+        line_records[r].token_begin += token_shift;
+        line_records[r].diagnostic_begin += diagnostic_shift;
+        line_records[r].line_number += line_delta;
+    }
+    for (LineRecord &record : worker.line_records) {
+        record.token_begin += start.token_begin;
+        record.diagnostic_begin += start.diagnostic_begin;
+        uint32_t worker_begin = record.indent_begin;
+        record.indent_begin = static_cast<uint32_t>(indent_pool.size());
+        indent_pool.insert(indent_pool.end(), worker.indent_pool.begin() + worker_begin,
+                           worker.indent_pool.begin() + worker_begin + record.indent_depth);
+    }
+    line_records.erase(line_records.begin() + first, line_records.begin() + resync);
+    line_records.insert(line_records.begin() + first, worker.line_records.begin(), worker.line_records.end());
+
+    // The pool only grows; repack it once most of it is unreferenced
+    if (indent_pool.size() > 4 * line_records.size() + 1024) {
+        vector<int> pool;
+        const LineRecord *previous = nullptr;
+        for (LineRecord &record : line_records) {
+            vector<int> levels(indent_pool.begin() + record.indent_begin,
+                               indent_pool.begin() + record.indent_begin + record.indent_depth);
+            if (previous && sameIndentation(levels, *previous, pool)) {
+                record.indent_begin = previous->indent_begin;
+            } else {
+                record.indent_begin = static_cast<uint32_t>(pool.size());
+                pool.insert(pool.end(), levels.begin(), levels.end());
+            }
+            previous = &record;
+        }
+        indent_pool.swap(pool);
+    }
+
+    if (at_end) {
+        line_number = worker.line_number;
+        indentation_levels = worker.indentation_levels;
+    } else {
+        line_number += line_delta;
+    }
+    source = edited;
+    read_index = 0;
+    symbols_stale = true; // rebuilt by getSymbolTable()
+}
+
+// --- Streaming Mode ---
+void Lexer::beginStream(const string &source_code)
+{
+    source = make_shared<SourceBuffer>();
+    source->owned = source_code;
+    source->text = source->owned;
+    streaming = true;
+    startSource(false);
+}
+
+void Lexer::beginStreamFile(const string &path)
+{
+    source = make_shared<SourceBuffer>();
+    source->mapFile(path);
+    if (source->text.substr(0, 3) == "\xEF\xBB\xBF")
+        source->text.remove_prefix(3);
+    streaming = true;
+    startSource(true);
+}
+
+TokenEdit Lexer::takeTokenEdit()
+{
+    TokenEdit edit = tokens_replaced ? TokenEdit{0, taken_tokens, tokens.size()}
+                     : tokens_edited ? token_edit
+                                     : TokenEdit{tokens.size(), tokens.size(), tokens.size()};
+    tokens_replaced = false;
+    tokens_edited = false;
+    taken_tokens = tokens.size();
+    return edit;
+}
+
+Token Lexer::nextToken()
+{
+    // In streaming mode `tokens` only holds the current window: once it has
+    // been read, it is cleared (keeping its capacity) and refilled from the
+    // next source line, so memory stays bounded by the longest line
+    while (streaming && read_index >= tokens.size() && !stream_finished) {
+        tokens.clear();
+        read_index = 0;
+        if (!lexNextLine()) {
+            finishSource();
+            stream_finished = true;
+        }
+    }
+
+    if (read_index >= tokens.size())
+        return Token("EOF", END_OF_FILE, line_number, 1);
+    Token token = tokens[read_index];
+    if (token.type != END_OF_FILE)
+        read_index++; // EOF is returned for every call past the end
+    return token;
+}
+
+Token TokenCursor::nextToken()
+{
+    last = min(next, tokens.size() - 1);
+    Token token = tokens[last];
+    if (token.type != END_OF_FILE)
+        next = last + 1;
+    return token;
+}
+
 // --- Output Functions ---
 void Lexer::printTokens()
 {
@@ -684,7 +2128,7 @@ void Lexer::printTokens()
     const auto &op_descriptions = getOperatorDescriptions(); // Get the description map
 
     for (const auto &token : tokens) {
-        string printable_lexeme = token.lexeme;
+        string printable_lexeme = token.text();
         // Basic escaping for common whitespace chars in output
         if (printable_lexeme == "\n")
             printable_lexeme = "\\n";
@@ -699,7 +2143,7 @@ void Lexer::printTokens()
                 type_string = "OPERATOR (" + it->second + ")"; // e.g., OPERATOR (Addition)
             } else {
                 // Fallback if operator lexeme isn't in map (shouldn't happen with current regex)
-                type_string = "OPERATOR (Unknown: " + token.lexeme + ")";
+                type_string = "OPERATOR (Unknown: " + token.text() + ")";
             }
         } else {
             // For all other types, use the standard name
@@ -716,6 +2160,8 @@ void Lexer::printTokens()
 
 void Lexer::printSymbolTable()
 {
+    if (symbols_stale)
+        rebuildSymbolTable();
     cout << "\n--- Symbol Table --- \n";
     cout << left << setw(25) << "Name" << left << setw(20) << "Type" << left << setw(20)
          << "Declared at Line" << "\n";
@@ -728,3 +2174,8 @@ void Lexer::printSymbolTable()
     }
     cout << string(65, '-') << "\n";
 }
+
+void Lexer::printDiagnostics()
+{
+    diagnostics.print(cerr);
+}
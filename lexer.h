@@ -4,7 +4,11 @@
 #include <iostream>
 #include <fstream>
 #include <regex>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <deque>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <cctype>
@@ -14,6 +18,8 @@
 #include <utility>
 #include <map>
 #include <algorithm>
+#include <atomic>
+#include <stdexcept>
 
 // =====================
 // Token Types
@@ -24,57 +30,503 @@ enum TokenType {
     SYMBOL, STATEMENT, INDENT, DEDENT, ERROR, END_OF_FILE
 };
 
+// =====================
+// Scanner Modes
+// =====================
+// DFA is the table-driven scanner used by default. REGEX is the original
+// std::regex classifier, kept so the two token streams can be diffed.
+enum class ScanMode { DFA, REGEX };
+
+// Lexeme classes reported by the word scanners (NONE/SKIP are DFA-internal)
+enum class LexemeClass { NONE, SKIP, WORD, NUMBER, OPERATOR, SYMBOL, INVALID };
+
+// =====================
+// Structural Index
+// =====================
+// One bit per source byte for each character the line splitter and comment
+// stripper look for, built in a single vectorised pass (AVX2 or SSE2 where
+// available, scalar otherwise). The find* methods take absolute offsets into
+// the indexed text, search [from, end) and return npos when nothing matches.
+class StructuralIndex {
+public:
+    static constexpr size_t npos = std::string_view::npos;
+
+    void build(std::string_view text);
+    bool built() const { return !newline_bits.empty(); }
+
+    size_t findNewline(size_t from, size_t end) const;
+    size_t findHash(size_t from, size_t end) const;
+    size_t findTripleQuote(char quote, size_t from, size_t end) const; // ''' or """
+    size_t findFirstNonBlank(size_t from, size_t end) const;           // blank is ' ' or '\t'
+    size_t findLastNonBlank(size_t from, size_t end) const;
+
+private:
+    // One word per 64 source bytes plus a trailing zero word
+    std::vector<uint64_t> newline_bits;
+    std::vector<uint64_t> single_quote_bits;
+    std::vector<uint64_t> double_quote_bits;
+    std::vector<uint64_t> hash_bits;
+    std::vector<uint64_t> blank_bits;
+};
+
+// =====================
+// Source Buffer
+// =====================
+// Single immutable copy of the source text. Token lexemes are views into
+// `text`, which is backed either by `owned` (tokenize) or by a read-only
+// memory mapping of the file (tokenizeFile). The few lexemes that are not
+// contiguous in the source (lines with an inline ''' ... ''' comment cut
+// out) are stored in `spill`.
+struct SourceBuffer {
+    std::string_view text;
+    std::string owned;
+    std::deque<std::string> spill;
+    std::vector<std::deque<std::string>> chunk_spill; // per-chunk spill of the parallel lexer
+    StructuralIndex index;                            // not built for streamed input
+    const char* mapped = nullptr;
+    size_t mapped_size = 0;
+
+    SourceBuffer() = default;
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    ~SourceBuffer();
+
+    void mapFile(const std::string& path); // throws std::runtime_error
+};
+
+// =====================
+// Lexeme IDs
+// =====================
+// Every distinct lexeme in a TokenStream is interned to a small integer.
+// Keywords, operators and symbols have fixed IDs so the parser can compare
+// against them directly; identifiers and literals get IDs from
+// LEX_FIRST_DYNAMIC upwards in order of first appearance.
+enum LexemeId : uint32_t {
+    LEX_UNKNOWN = 0, // lexeme not interned (e.g. tokens still in the line buffer)
+
+    // Keywords and data types
+    LEX_IF, LEX_ELSE, LEX_ELIF, LEX_WHILE, LEX_FOR, LEX_DEF, LEX_RETURN,
+    LEX_IN, LEX_IMPORT, LEX_AS, LEX_AND, LEX_OR, LEX_NOT,
+    LEX_TRUE, LEX_FALSE, LEX_NONE,
+
+    // Operators
+    LEX_ASSIGN, LEX_PLUS, LEX_MINUS, LEX_STAR, LEX_SLASH, LEX_PERCENT,
+    LEX_POWER, LEX_FLOOR_DIV, LEX_EQ, LEX_NE, LEX_LT, LEX_GT, LEX_LE, LEX_GE,
+    LEX_LSHIFT, LEX_RSHIFT, LEX_AMP, LEX_PIPE, LEX_CARET, LEX_TILDE, LEX_DOT,
+    LEX_PLUS_ASSIGN, LEX_MINUS_ASSIGN, LEX_STAR_ASSIGN, LEX_SLASH_ASSIGN,
+    LEX_PERCENT_ASSIGN, LEX_POWER_ASSIGN, LEX_FLOOR_DIV_ASSIGN, LEX_AMP_ASSIGN,
+    LEX_PIPE_ASSIGN, LEX_CARET_ASSIGN, LEX_LSHIFT_ASSIGN, LEX_RSHIFT_ASSIGN,
+
+    // Symbols
+    LEX_LPAREN, LEX_RPAREN, LEX_LBRACKET, LEX_RBRACKET, LEX_LBRACE, LEX_RBRACE,
+    LEX_COLON, LEX_COMMA, LEX_SEMICOLON,
+
+    LEX_FIRST_DYNAMIC
+};
+
+// Operators travel from the lexer through tokens and AST nodes as their
+// fixed lexeme ID; only display code needs their text.
+using OpCode = LexemeId;
+
+// Text of a fixed lexeme ID, e.g. "+=" for LEX_PLUS_ASSIGN
+const char *lexemeText(LexemeId id);
+
 // =====================
 // Token Structure
 // =====================
+// `lexeme` points into the lexer's SourceBuffer (or at a string literal for
+// synthetic tokens such as INDENT/EOF); it stays valid while the Lexer that
+// produced it, or a handle from getSource(), is alive. Tokens read back from
+// a TokenStream also carry their interned lexeme ID.
 struct Token {
-    std::string lexeme;
+    std::string_view lexeme;
     TokenType type;
     int line_number;
     int column_number;
+    uint32_t id;
+
+    Token(std::string_view lexeme, TokenType type, int line_number, int column_number,
+          uint32_t id = LEX_UNKNOWN)
+        : lexeme(lexeme), type(type), line_number(line_number), column_number(column_number), id(id) {}
+
+    std::string text() const { return std::string(lexeme); }
+};
+
+// =====================
+// Source Edits
+// =====================
+// `removed_length` bytes at `offset` replaced by `inserted_length` bytes.
+// relocate() maps a view into the text before the edit to the same bytes of
+// the text after it; views outside `old_text` come back unchanged and views
+// overlapping the replaced bytes, which no longer exist, come back empty.
+struct SourceEdit {
+    size_t offset;
+    size_t removed_length;
+    size_t inserted_length;
+
+    std::string_view relocate(std::string_view view, std::string_view old_text, std::string_view new_text) const;
+};
+
+// Where two versions of a token stream differ: tokens [begin, old_end) of
+// the older one became tokens [begin, new_end) of the newer one. The tokens
+// after them are the same, moved by whole lines at most (which an edit that
+// replaces no tokens at all may still do).
+struct TokenEdit {
+    size_t begin;
+    size_t old_end;
+    size_t new_end;
+
+    // One edit covering this one followed by `next`
+    TokenEdit then(const TokenEdit& next) const;
+};
+
+// =====================
+// Token Stream
+// =====================
+// Struct-of-arrays token store: one byte of type, the interned lexeme ID,
+// the source offset, line and column per token (15 bytes instead of a full
+// Token). Columns that do not fit in 16 bits are kept in `wide_columns`.
+// operator[] and iteration materialise Token values on the fly. The interner
+// hashes IDs by their text, so relocate() can re-point a view without
+// touching the hash table.
+class TokenStream {
+public:
+    static constexpr uint32_t NO_OFFSET = UINT32_MAX; // synthetic or spilled lexemes
+
+    TokenStream();
+
+    void setSource(std::string_view text) { source_text = text; }
+    void emplace_back(std::string_view lexeme, TokenType type, int line_number, int column_number);
+    void push_back(const Token& token)
+    {
+        emplace_back(token.lexeme, token.type, token.line_number, token.column_number);
+    }
+    void appendRange(const TokenStream& other, size_t begin, size_t end, std::vector<uint32_t>& remap);
+    // Incremental re-lexing: move interned lexemes over to the edited text
+    // (lexemes that only existed in replaced bytes are copied to `spill`),
+    // then replace tokens [begin, end) and shift the ones after them
+    void relocate(const SourceEdit& edit, std::string_view new_text, std::deque<std::string>& spill);
+    void splice(size_t begin, size_t end, const TokenStream& replacement, const SourceEdit& edit, int line_delta);
+    void reserve(size_t count);
+    void clear();
+
+    size_t size() const { return types.size(); }
+    bool empty() const { return types.empty(); }
+
+    TokenType type(size_t i) const { return static_cast<TokenType>(types[i]); }
+    uint32_t id(size_t i) const { return ids[i]; }
+    uint32_t offset(size_t i) const { return offsets[i]; }
+    int line(size_t i) const { return static_cast<int>(lines[i]); }
+    int column(size_t i) const;
+    std::string_view lexeme(size_t i) const { return id_text[ids[i]]; }
+    Token operator[](size_t i) const { return Token(lexeme(i), type(i), line(i), column(i), id(i)); }
+    Token back() const { return (*this)[size() - 1]; }
 
-    Token(std::string lexeme, TokenType type, int line_number, int column_number)
-        : lexeme(std::move(lexeme)), type(type), line_number(line_number), column_number(column_number) {}
+    // Interning: lookup() returns LEX_UNKNOWN for text never seen
+    uint32_t intern(std::string_view text);
+    uint32_t lookup(std::string_view text) const;
+    std::string_view idText(uint32_t id) const { return id_text[id]; }
+    size_t internedCount() const { return id_text.size(); }
+
+    class const_iterator {
+    public:
+        const_iterator(const TokenStream* stream, size_t index) : stream(stream), index(index) {}
+        Token operator*() const { return (*stream)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+
+    private:
+        const TokenStream* stream;
+        size_t index;
+    };
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lines;
+    std::vector<uint16_t> columns;
+    std::unordered_map<uint32_t, int> wide_columns;
+
+    size_t findSlot(std::string_view text) const;
+
+    std::vector<std::string_view> id_text;
+    std::vector<uint32_t> id_slots; // open addressing, LEX_UNKNOWN marks a free slot
+    std::string_view source_text;
+};
+
+// =====================
+// Token Source
+// =====================
+// Pull interface the parser reads from. Once the input is exhausted every
+// further call returns an END_OF_FILE token.
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+    virtual Token nextToken() = 0;
+};
+
+// Replays a TokenStream from any index, e.g. to parse part of it again.
+// The stream must end with its END_OF_FILE token.
+class TokenCursor : public TokenSource {
+public:
+    TokenCursor(const TokenStream& tokens, size_t position = 0) : tokens(tokens), next(position) {}
+    Token nextToken() override;
+    size_t current() const { return last; } // index of the token returned last
+
+private:
+    const TokenStream& tokens;
+    size_t next;
+    size_t last = 0;
+};
+
+// =====================
+// Diagnostics
+// =====================
+// Lexical errors are recorded as a code, a position and the lexemes the
+// message quotes; the text is only formatted when someone asks for it.
+enum class DiagnosticCode : uint8_t {
+    // Indentation (reported per line)
+    TAB_INDENT, DEDENT_MISMATCH, INDENT_MISMATCH, DEDENT_BELOW_BASE,
+    // Word level (reported with a column)
+    KEYWORD_AS_IDENTIFIER, INVALID_FLOAT, DIGIT_LED_IDENTIFIER, INVALID_IDENTIFIER_CHAR,
+    KEYWORD_AFTER_NUMBER, KEYWORD_IN_CONTEXT, NUMBER_AFTER_NUMBER, NUMBER_AFTER_IDENTIFIER,
+    IDENTIFIER_AFTER_NUMBER, IDENTIFIER_AFTER_IDENTIFIER, UNKNOWN_TOKEN
+};
+
+// `lexeme`/`other` point into the lexer's SourceBuffer, like Token::lexeme
+struct Diagnostic {
+    DiagnosticCode code;
+    uint32_t line_number;
+    uint32_t column_number;
+    std::string_view lexeme;
+    std::string_view other;
+};
+
+class Diagnostics {
+public:
+    void report(DiagnosticCode code, int line_number, int column_number,
+                std::string_view lexeme = {}, std::string_view other = {})
+    {
+        entries.push_back({code, static_cast<uint32_t>(line_number), static_cast<uint32_t>(column_number),
+                           lexeme, other});
+    }
+    void append(const Diagnostics& other, size_t begin, size_t end)
+    {
+        entries.insert(entries.end(), other.entries.begin() + begin, other.entries.begin() + end);
+    }
+    // Incremental re-lexing counterpart of TokenStream::relocate/splice
+    void splice(size_t begin, size_t end, const Diagnostics& replacement, const SourceEdit& edit,
+                std::string_view old_text, std::string_view new_text, int line_delta);
+    void clear() { entries.clear(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    const Diagnostic& operator[](size_t i) const { return entries[i]; }
+    std::vector<Diagnostic>::const_iterator begin() const { return entries.begin(); }
+    std::vector<Diagnostic>::const_iterator end() const { return entries.end(); }
+
+    // "Lexical Error at Line 3, Column 5: Invalid float number: '1.2.3'"
+    static std::string message(const Diagnostic& diagnostic);
+    // The part after the position, e.g. "Invalid float number: '1.2.3'"
+    static std::string summary(const Diagnostic& diagnostic);
+    void print(std::ostream& out) const; // one message per line
+
+private:
+    std::vector<Diagnostic> entries;
+};
+
+// A line lexed by a parallel worker, waiting for its indentation to be
+// handled by the merge pass. Ends are offsets into the worker's token
+// stream and diagnostics.
+struct LexedLine {
+    std::string_view original_line;
+    int line_number;
+    size_t token_end;
+    size_t diagnostic_end;
+};
+
+// Lexer state at the start of a physical line, recorded by line-tracking
+// lexers so that an edit can restart lexing at the line it touches. The
+// indentation stack is indent_pool[indent_begin, indent_begin + indent_depth).
+struct LineRecord {
+    size_t offset; // start of the line in the source text
+    size_t token_begin;
+    size_t diagnostic_begin;
+    int line_number;
+    char comment_quote; // '\'' or '"' inside a multi-line comment, else 0
+    uint32_t indent_begin;
+    uint32_t indent_depth;
+};
+
+// =====================
+// Cancellation
+// =====================
+// Shared between a lexer or parser run on a worker thread and the thread
+// that started it. The lexer checks it once per source line and the
+// incremental parser once per top-level statement: cancel() makes the run
+// throw AnalysisCancelled at its next check, and progress() tells how far
+// the current run has got. A cancelled run leaves the lexer or parser half
+// updated; lex everything again (and reset() the parser) before reusing it.
+class AnalysisCancelled : public std::runtime_error {
+public:
+    AnalysisCancelled() : std::runtime_error("analysis cancelled") {}
+};
+
+class CancelToken {
+public:
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+    void throwIfCancelled() const
+    {
+        if (isCancelled())
+            throw AnalysisCancelled();
+    }
+
+    // Permille of the current run done; report() keeps the largest value,
+    // since parallel workers finish their parts out of order
+    int progress() const { return permille.load(std::memory_order_relaxed); }
+    void report(size_t done, size_t total)
+    {
+        int value = total ? static_cast<int>(std::min(done, total) * 1000 / total) : 1000;
+        int seen = permille.load(std::memory_order_relaxed);
+        while (value > seen && !permille.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+    void restartProgress() { permille.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> permille{0};
 };
 
 // =====================
 // Lexer Class
 // =====================
-class Lexer {
+// tokenize()/tokenizeFile() lex the whole input into `tokens` (on several
+// threads for inputs of at least parallel_min_bytes); nextToken() then
+// replays it. beginStream()/beginStreamFile() instead lex lazily, one
+// line per refill, as nextToken() is called. With line tracking on,
+// applyEdit() updates a batch result by re-lexing only the lines an edit
+// touches, up to where the lexer state matches the old stream again.
+class Lexer : public TokenSource {
 public:
     Lexer(); // Constructor
 
     // Public methods
     void tokenize(const std::string& source_code);
-    std::vector<Token> getTokens() const { return tokens; }
-    std::vector<std::pair<std::string, std::pair<std::string, int>>> getSymbolTable() const { return symbol_table; }
+    void tokenizeFile(const std::string& path);
+    void beginStream(const std::string& source_code);
+    void beginStreamFile(const std::string& path);
+    void applyEdit(size_t offset, size_t removed_length, std::string_view inserted);
+    // Copies a memory-mapped source into memory of its own and unmaps the
+    // file, for a lexer kept while the file may be rewritten; a no-op for
+    // owned text. Tokens and diagnostics stay valid.
+    void detachSource();
+    // How `tokens` changed since the previous call (all of it after a full
+    // tokenize), for incremental parsing
+    TokenEdit takeTokenEdit();
+    Token nextToken() override;
+    const TokenStream& getTokens() const { return tokens; }
+    const Diagnostics& getDiagnostics() const { return diagnostics; }
+    std::shared_ptr<const SourceBuffer> getSource() const { return source; }
+    std::vector<std::pair<std::string, std::pair<std::string, int>>> getSymbolTable()
+    {
+        if (symbols_stale)
+            rebuildSymbolTable();
+        return symbol_table;
+    }
     std::string getTokenTypeName(TokenType type);
-    const std::map<std::string, std::string>& getOperatorDescriptions();
+    const std::map<std::string, std::string, std::less<>>& getOperatorDescriptions();
 
     void printTokens();
     void printSymbolTable();
+    void printDiagnostics();
+    void setScanMode(ScanMode mode) { scan_mode = mode; }
+    void setLineTracking(bool enabled) { track_lines = enabled; } // lexes serially while on
+    void setCancelToken(CancelToken* token) { cancel_token = token; } // nullptr: never cancelled
+    // threads == 0 picks std::thread::hardware_concurrency(); 1 forces the serial path
+    void setParallelism(unsigned threads, size_t min_bytes = PARALLEL_MIN_BYTES)
+    {
+        worker_threads = threads;
+        parallel_min_bytes = min_bytes;
+    }
 
-    std::unordered_map<std::string, TokenType> keywords;
-    std::vector<Token> tokens;
+    static constexpr size_t PARALLEL_MIN_BYTES = 1 << 20;
+    static constexpr size_t PARALLEL_MIN_CHUNK = 64 << 10;
+
+    std::shared_ptr<SourceBuffer> source;
+    TokenStream tokens;
+    Diagnostics diagnostics;
     std::vector<Token> buffer;
     std::vector<std::pair<std::string, std::pair<std::string, int>>> symbol_table;
-    std::unordered_map<std::string, bool> symbol_presence;
-    std::stack<int> indentation_levels;
+    std::unordered_map<std::string_view, bool> symbol_presence;
+    std::vector<int> indentation_levels; // innermost level at back()
     int line_number;
+    ScanMode scan_mode;
+
+    // Line-splitting state shared by batch and streaming modes
+    size_t next_line_start;
+    bool strip_cr;
+    bool in_multiline_comment;
+    std::string_view comment_delim;
+    bool streaming;
+    bool stream_finished;
+    size_t read_index; // next token nextToken() returns
+    size_t line_limit; // end of the input this lexer splits lines from
+
+    // Parallel lexing
+    unsigned worker_threads;
+    size_t parallel_min_bytes;
+    std::deque<std::string>* spill;          // where non-contiguous lexemes are stored
+    std::vector<LexedLine>* deferred_lines;  // set on workers: defer indentation
+    CancelToken* cancel_token;
+
+    // Incremental re-lexing (line_records ends with an end-of-input record)
+    bool track_lines;
+    std::vector<LineRecord> line_records;
+    std::vector<int> indent_pool;
+    bool symbols_stale; // symbol_table not yet updated after applyEdit()
+    TokenEdit token_edit; // applyEdit() changes since the last takeTokenEdit()
+    bool tokens_edited;   // token_edit is set
+    bool tokens_replaced; // lexed from scratch since then
+    size_t taken_tokens;  // tokens.size() at the last takeTokenEdit()
 
     // Helper methods
-    bool isInteger(const std::string& str);
-    bool isFloat(const std::string& str);
-    bool isIdentifier(const std::string& str);
-    bool isOperator(const std::string& str);
-    bool isSymbol(const std::string& str);
-    bool isIdentifierPosition(const std::string& token);
-
-    void addToSymbolTable(const std::string& name, const std::string& type);
-    void handleIndentation(const std::string& line);
+    bool isInteger(std::string_view str);
+    bool isFloat(std::string_view str);
+    bool isIdentifier(std::string_view str);
+    bool isOperator(std::string_view str);
+    bool isSymbol(std::string_view str);
+    bool isIdentifierPosition(std::string_view token);
+    bool isOperatorOrSymbolChar(char ch);
+
+    void addToSymbolTable(std::string_view name, const std::string& type);
+    void handleIndentation(std::string_view line);
     void analyzeBuffer();
-    void tokenizeLine(const std::string& line);
-    void tokenizeWord(const std::string& word, int start_column);
+    void tokenizeSource(bool strip_cr);
+    void startSource(bool strip_cr);
+    bool lexNextLine();
+    std::string_view nextPhysicalLine();
+    bool stripComments(std::string_view& line);
+    size_t indexedOffset(std::string_view view) const;
+    size_t findHashInLine(std::string_view line) const;
+    size_t findTripleQuoteInLine(std::string_view line, char quote, size_t from = 0) const;
+    size_t firstNonBlank(std::string_view line) const;
+    size_t lastNonBlank(std::string_view line) const;
+    void tokenizeParallel(unsigned thread_count);
+    void finishSource();
+    void resetSource();
+    void recordLineStart(size_t offset);
+    bool matchesLineState(const LineRecord& record, const std::vector<int>& pool) const;
+    void rebuildSymbolTable();
+    void tokenizeLine(std::string_view line);
+    void tokenizeWord(std::string_view word, int start_column);
+    void scanWordDFA(std::string_view word, int start_column);
+    void addWordToken(std::string_view token, int token_start_col, LexemeClass lexeme_class);
 };
 
 #endif // LEXER_H
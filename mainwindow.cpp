@@ -4,6 +4,8 @@
 
 using namespace std;
 
+static const int maxHighlightedErrors = 1000; // marked in the editor; the error table lists all
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
@@ -53,10 +55,30 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Connect error table double-click
     connect(ui->errorTableView, &QTableView::doubleClicked, this, &MainWindow::onErrorTableDoubleClicked);
+
+    // Lexer and parser run on a worker thread; its results come back queued
+    connect(this, &MainWindow::analysisFinished, this, &MainWindow::onAnalysisFinished, Qt::QueuedConnection);
+
+    // Progress of the run in the status bar, shown once it takes a while
+    analysisProgress = new QProgressBar(this);
+    analysisProgress->setRange(0, 1000);
+    analysisProgress->setMaximumWidth(200);
+    analysisProgress->hide();
+    statusBar()->addPermanentWidget(analysisProgress);
+    analysisProgressTimer = new QTimer(this);
+    analysisProgressTimer->setInterval(100);
+    connect(analysisProgressTimer, &QTimer::timeout, this, [this]() {
+        if (!analysis)
+            return;
+        analysisProgress->setFormat(analysis->parsing ? "Parsing %p%" : "Lexing %p%");
+        analysisProgress->setValue(analysis->token.progress());
+        analysisProgress->show();
+    });
 }
 
 MainWindow::~MainWindow()
 {
+    stopAnalysis(); // the worker uses editorLexer and editorParser
     delete ui;
     delete tokenTableModel;
     delete symbolTableModel;
@@ -67,19 +89,16 @@ MainWindow::~MainWindow()
 void MainWindow::setupTableModels()
 {
     // Token table setup
-    tokenTableModel = new QStandardItemModel(this);
-    tokenTableModel->setHorizontalHeaderLabels({"Lexeme", "Type", "Line", "Column"});
+    tokenTableModel = new AnalysisTableModel({"Lexeme", "Type", "Line", "Column"}, this);
     ui->tokenTableView->setModel(tokenTableModel);
     ui->tokenTableView->verticalHeader()->setVisible(false);
 
     // Symbol table setup
-    symbolTableModel = new QStandardItemModel(this);
-    symbolTableModel->setHorizontalHeaderLabels({"Name", "Type", "Declared at Line"});
+    symbolTableModel = new AnalysisTableModel({"Name", "Type", "Declared at Line"}, this);
     ui->symbolTableView->setModel(symbolTableModel);
 
     // Error table setup
-    errorTableModel = new QStandardItemModel(this);
-    errorTableModel->setHorizontalHeaderLabels({"Error Type", "Message", "Line", "Column"});
+    errorTableModel = new AnalysisTableModel({"Error Type", "Message", "Line", "Column"}, this);
     ui->errorTableView->setModel(errorTableModel);
     ui->errorTableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
     ui->errorTableView->setSelectionBehavior(QAbstractItemView::SelectRows);
@@ -108,7 +127,14 @@ void MainWindow::on_actionOpen_triggered()
 
     QTextStream in(&file);
     ui->sourceEditor->setPlainText(in.readAll());
+    ui->sourceEditor->document()->setModified(false);
     currentFilePath = filePath;
+    currentFileModified = QFileInfo(filePath).lastModified();
+    stopAnalysis();
+    tokenTableModel->clear(); // they read the lexer dropped here
+    errorTableModel->clear();
+    editorLexer.reset(); // lex the new file from disk on the next run
+    editorParser.reset();
     file.close();
 
     setWindowTitle("Python Compiler - " + QFileInfo(filePath).fileName());
@@ -138,6 +164,15 @@ void MainWindow::on_actionSave_As_triggered()
 
 bool MainWindow::saveFile(const QString &filePath)
 {
+    // Writing may truncate a file the worker is lexing in place; the
+    // lexer starts over from the editor text on the next run
+    stopAnalysis();
+    tokenTableModel->clear();
+    symbolTableModel->clear();
+    errorTableModel->clear();
+    editorLexer.reset();
+    editorParser.reset();
+
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QMessageBox::critical(this, "Error", "Could not save file: " + file.errorString());
@@ -147,11 +182,66 @@ bool MainWindow::saveFile(const QString &filePath)
     QTextStream out(&file);
     out << ui->sourceEditor->toPlainText();
     file.close();
+    ui->sourceEditor->document()->setModified(false);
+    currentFileModified = QFileInfo(filePath).lastModified();
 
     showStatusMessage(QString("File saved: " + filePath), false);
     return true;
 }
 
+string MainWindow::unchangedEditorFile() const
+{
+    if (!currentFilePath.isEmpty() && !ui->sourceEditor->document()->isModified()
+        && QFileInfo(currentFilePath).lastModified() == currentFileModified)
+        return QFile::encodeName(currentFilePath).toStdString();
+    return string();
+}
+
+void MainWindow::tokenizeEditorSource(Lexer &lexer, const QString &sourceCode, const string &filePath)
+{
+    // If the editor still holds exactly what is on disk, scan the file in place
+    // instead of copying the editor text into a std::string first
+    if (!filePath.empty()) {
+        try {
+            lexer.tokenizeFile(filePath);
+            return;
+        } catch (const AnalysisCancelled&) {
+            throw;
+        } catch (const exception& e) {
+            // Mapping failed before any token was produced; lex the editor text instead
+            qDebug() << "Memory-mapped lexing unavailable:" << e.what();
+        }
+    }
+    lexer.tokenize(sourceCode.toStdString());
+}
+
+Lexer &MainWindow::relexEditorSource(const QString &sourceCode, const string &filePath, CancelToken *token)
+{
+    if (!editorLexer) {
+        editorLexer = make_unique<Lexer>();
+        editorLexer->setLineTracking(true);
+        editorLexer->setCancelToken(token);
+        tokenizeEditorSource(*editorLexer, sourceCode, filePath);
+        // Kept across runs, while Save or another program may rewrite the
+        // file in place: the lexer and the tables must not read the mapping
+        editorLexer->detachSource();
+        return *editorLexer;
+    }
+
+    editorLexer->setCancelToken(token);
+
+    // Hand the lexer the span between what is unchanged at both ends
+    string text = sourceCode.toStdString();
+    string_view before = editorLexer->getSource()->text;
+    size_t limit = min(before.size(), text.size());
+    size_t prefix = mismatch(before.begin(), before.begin() + limit, text.begin()).first - before.begin();
+    size_t suffix = mismatch(before.rbegin(), before.rbegin() + (limit - prefix), text.rbegin()).first
+                    - before.rbegin();
+    editorLexer->applyEdit(prefix, before.size() - prefix - suffix,
+                           string_view(text).substr(prefix, text.size() - prefix - suffix));
+    return *editorLexer;
+}
+
 void MainWindow::on_actionExit_triggered()
 {
     QApplication::quit();
@@ -159,12 +249,41 @@ void MainWindow::on_actionExit_triggered()
 
 void MainWindow::on_actionRun_Lexer_triggered()
 {
+    startAnalysis(false);
+}
+
+void MainWindow::on_actionRun_Parser_triggered()
+{
+    startAnalysis(true);
+}
+
+void MainWindow::on_actionCancel_Analysis_triggered()
+{
+    if (analysis)
+        analysis->token.cancel(); // reported back through analysisFinished()
+}
+
+void MainWindow::startAnalysis(bool parse)
+{
+    stopAnalysis(); // a new press replaces the run still going
+
     // Clear previous outputs
-    tokenTableModel->removeRows(0, tokenTableModel->rowCount());
-    symbolTableModel->removeRows(0, symbolTableModel->rowCount());
-    errorTableModel->removeRows(0, errorTableModel->rowCount());
+    tokenTableModel->clear();
+    symbolTableModel->clear();
+    errorTableModel->clear();
     parseTreeScene->clear(); // Clear any previous parse trees
-    parseTreeWidget->setParseTree(nullptr); // Clear the custom parse tree widget
+    // The widget lets go of the previous tree first: the reparse may update
+    // the statements they share
+    parseTreeWidget->setParseTree(nullptr);
+
+    // The file changed on disk since it was loaded or saved: the editor no
+    // longer holds what is there, and the kept lexer starts over
+    if (!currentFilePath.isEmpty() && !ui->sourceEditor->document()->isModified()
+        && QFileInfo(currentFilePath).lastModified() != currentFileModified) {
+        ui->sourceEditor->document()->setModified(true);
+        editorLexer.reset();
+        editorParser.reset();
+    }
 
     QString sourceCode = ui->sourceEditor->toPlainText();
     if (sourceCode.isEmpty()) {
@@ -172,157 +291,210 @@ void MainWindow::on_actionRun_Lexer_triggered()
         return;
     }
 
-    // Create and run the lexer
-    Lexer lexer;
-    try {
-        lexer.tokenize(sourceCode.toStdString());
-        updateTokenTable(lexer.getTokens());
-        updateSymbolTable(lexer.getSymbolTable());
-        updateErrorTable(lexer.getTokens());
-        highlightErrors(lexer.getTokens()); // Add error highlighting
-
-        // Count errors for status message
-        int errorCount = 0;
-        for (const auto& token : lexer.getTokens()) {
-            if (token.type == ERROR) errorCount++;
-        }
+    analysis = make_unique<AnalysisRun>();
+    analysis->id = ++analysisRuns;
+    analysis->parse = parse;
+    analysis->sourceCode = sourceCode;
+    analysis->filePath = unchangedEditorFile();
 
-        if (errorCount > 0) {
-            showStatusMessage(QString("Lexer completed with " + QString::number(errorCount) + " errors"), true);
-            ui->outputTabs->setCurrentIndex(2); // Switch to errors tab
-        } else {
-            showStatusMessage("Lexer completed successfully", false);
-            ui->outputTabs->setCurrentIndex(0); // Switch to tokens tab
+    AnalysisRun *run = analysis.get();
+    QThread *thread = QThread::create([this, run]() {
+        runAnalysis(*run);
+        emit analysisFinished(run->id);
+    });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    analysisThread = thread;
+    thread->start();
+
+    ui->actionCancel_Analysis->setEnabled(true);
+    analysisProgress->setValue(0);
+    analysisProgressTimer->start();
+}
+
+void MainWindow::runAnalysis(AnalysisRun &run)
+{
+    try {
+        Lexer &lexer = relexEditorSource(run.sourceCode, run.filePath, &run.token);
+
+        // Lexical errors must be fixed before the parser runs
+        if (run.parse && lexer.getDiagnostics().empty()) {
+            run.token.restartProgress();
+            run.parsing = true;
+            editorParser.setCancelToken(&run.token);
+            run.tree = make_shared<const ParseResult>(editorParser.parse(lexer.getTokens(), lexer.takeTokenEdit()));
         }
+    } catch (const AnalysisCancelled&) {
+        run.cancelled = true;
     } catch (const exception& e) {
-        QMessageBox::critical(this, "Lexer Error", "An exception occurred during lexical analysis: " + QString(e.what()));
-        showStatusMessage("Lexer failed with an exception", true);
+        run.error = QString(e.what());
     }
+    if (editorLexer)
+        editorLexer->setCancelToken(nullptr);
+    editorParser.setCancelToken(nullptr);
 }
 
-void MainWindow::updateTokenTable(const vector<Token> &tokens)
+// Waits for the worker to be done with the current run and hands the run
+// over. Lexer or parser state that the run left half updated is dropped,
+// so the next run starts over.
+unique_ptr<MainWindow::AnalysisRun> MainWindow::takeAnalysis()
 {
-    // Configure the token table with the results
-    tokenTableModel->setRowCount(0); // Clear previous data
-
-    // Map for operator descriptions
-    const map<string, string>& opDescriptions = Lexer().getOperatorDescriptions();
-
-    for (const auto& token : tokens) {
-        QList<QStandardItem*> row;
+    if (analysisThread)
+        analysisThread->wait();
+    analysisThread = nullptr;
+    analysisProgressTimer->stop();
+    analysisProgress->hide();
+    ui->actionCancel_Analysis->setEnabled(false);
+
+    if (analysis->cancelled || !analysis->error.isEmpty()) {
+        if (!analysis->parsing)
+            editorLexer.reset();
+        editorParser.reset();
+    }
+    return move(analysis);
+}
 
-        // Format the lexeme for display
-        QString lexeme = QString::fromStdString(token.lexeme);
-        if (lexeme == "\n") lexeme = "\\n";
-        if (lexeme == "\t") lexeme = "\\t";
+// Cancels the run in progress and drops its results; the worker stops
+// within a source line or statement
+void MainWindow::stopAnalysis()
+{
+    if (!analysis)
+        return;
+    analysis->token.cancel();
+    takeAnalysis();
+}
 
-        // Add lexeme
-        row.append(new QStandardItem(lexeme));
+void MainWindow::onAnalysisFinished(int run)
+{
+    // A run that stopAnalysis() dropped may still report back
+    if (!analysis || analysis->id != run)
+        return;
+    unique_ptr<AnalysisRun> finished = takeAnalysis();
 
-        // Add token type with description for operators
-        QString typeStr = QString::fromStdString(Lexer().getTokenTypeName(token.type));
-        if (token.type == OPERATOR) {
-            auto it = opDescriptions.find(token.lexeme);
-            if (it != opDescriptions.end()) {
-                typeStr += " (" + QString::fromStdString(it->second) + ")";
-            }
+    if (finished->cancelled) {
+        showStatusMessage(finished->parsing ? "Parser cancelled" : "Lexer cancelled", true);
+        return;
+    }
+    if (!finished->error.isEmpty()) {
+        if (finished->parsing) {
+            QMessageBox::critical(this, "Parser Error", "An exception occurred during parsing: " + finished->error);
+            showStatusMessage("Parser failed with an exception", true);
+        } else {
+            QMessageBox::critical(this, "Lexer Error",
+                                  "An exception occurred during lexical analysis: " + finished->error);
+            showStatusMessage("Lexer failed with an exception", true);
         }
-        row.append(new QStandardItem(typeStr));
-
-        // Add line and column
-        row.append(new QStandardItem(QString::number(token.line_number)));
-        row.append(new QStandardItem(QString::number(token.column_number)));
-
-        // Add the row
-        tokenTableModel->appendRow(row);
+        return;
     }
 
-    // Resize columns to content
-    ui->tokenTableView->resizeColumnsToContents();
+    showLexerResults();
+    if (!finished->parse)
+        return;
+    if (!finished->parsing) {
+        showStatusMessage("Cannot parse: Lexical errors must be fixed first", true);
+        return;
+    }
+    showParserResults(move(finished->tree));
 }
 
-void MainWindow::updateSymbolTable(const vector<pair<string, pair<string, int>>> &symbolTable)
+void MainWindow::showLexerResults()
 {
-    symbolTableModel->setRowCount(0); // Clear previous data
-
-    for (const auto& symbol : symbolTable) {
-        QList<QStandardItem*> row;
+    Lexer &lexer = *editorLexer;
+    lexer.detachSource(); // already done by relexEditorSource; the tables read the text lazily
+    updateTokenTable(lexer);
+    updateSymbolTable(lexer.getSymbolTable());
+    updateErrorTable(lexer.getDiagnostics());
+    highlightErrors(lexer.getTokens()); // Add error highlighting
+
+    // Count errors for status message
+    int errorCount = static_cast<int>(lexer.getDiagnostics().size());
+
+    if (errorCount > 0) {
+        showStatusMessage(QString("Lexer completed with " + QString::number(errorCount) + " errors"), true);
+        ui->outputTabs->setCurrentIndex(2); // Switch to errors tab
+    } else {
+        showStatusMessage("Lexer completed successfully", false);
+        ui->outputTabs->setCurrentIndex(0); // Switch to tokens tab
+    }
+}
 
-        // Add symbol name
-        row.append(new QStandardItem(QString::fromStdString(symbol.first)));
+void MainWindow::updateTokenTable(Lexer &lexer)
+{
+    // Rows are formatted only as they scroll into view, straight from the
+    // lexer's token stream
+    const TokenStream &tokens = lexer.getTokens();
 
-        // Add symbol type
-        row.append(new QStandardItem(QString::fromStdString(symbol.second.first)));
+    // Map for operator descriptions
+    const map<string, string, less<>>& opDescriptions = lexer.getOperatorDescriptions();
+
+    tokenTableModel->show(static_cast<int>(tokens.size()), [&tokens, &lexer, &opDescriptions](int row, int column) {
+        switch (column) {
+        case 0: {
+            // Format the lexeme for display
+            string_view lexeme = tokens.lexeme(row);
+            if (lexeme == "\n") return QString("\\n");
+            if (lexeme == "\t") return QString("\\t");
+            return QString::fromUtf8(lexeme.data(), static_cast<int>(lexeme.size()));
+        }
+        case 1: {
+            // Token type with description for operators
+            TokenType type = tokens.type(row);
+            QString typeStr = QString::fromStdString(lexer.getTokenTypeName(type));
+            if (type == OPERATOR) {
+                auto it = opDescriptions.find(tokens.lexeme(row));
+                if (it != opDescriptions.end()) {
+                    typeStr += " (" + QString::fromStdString(it->second) + ")";
+                }
+            }
+            return typeStr;
+        }
+        case 2:
+            return QString::number(tokens.line(row));
+        default:
+            return QString::number(tokens.column(row));
+        }
+    });
 
-        // Add declaration line
-        row.append(new QStandardItem(QString::number(symbol.second.second)));
+    // Resize columns to content
+    ui->tokenTableView->resizeColumnsToContents();
+}
 
-        symbolTableModel->appendRow(row);
-    }
+void MainWindow::updateSymbolTable(vector<pair<string, pair<string, int>>> symbolTable)
+{
+    auto symbols = make_shared<const vector<pair<string, pair<string, int>>>>(move(symbolTable));
+
+    symbolTableModel->show(static_cast<int>(symbols->size()), [symbols](int row, int column) {
+        const auto& symbol = (*symbols)[row];
+        switch (column) {
+        case 0:
+            return QString::fromStdString(symbol.first); // Symbol name
+        case 1:
+            return QString::fromStdString(symbol.second.first); // Symbol type
+        default:
+            return QString::number(symbol.second.second); // Declaration line
+        }
+    });
 
     // Resize columns to content
     ui->symbolTableView->resizeColumnsToContents();
 }
 
 
-void MainWindow::updateErrorTable(const vector<Token> &tokens)
+void MainWindow::updateErrorTable(const Diagnostics &diagnostics)
 {
-    errorTableModel->setRowCount(0); // Clear previous data
-
-    for (const auto& token : tokens) {
-        if (token.type == ERROR) {
-            QList<QStandardItem*> row;
-
-            // Add error type
-            row.append(new QStandardItem("Lexical Error"));
-
-            // Generate detailed error message based on lexeme and context
-            QString errorMsg;
-            QString lexeme = QString::fromStdString(token.lexeme);
-
-            // Check for specific error patterns
-            if (lexeme.contains("TabError")) {
-                errorMsg = "Tabs are not allowed for indentation. Use spaces only.";
-            }
-            else if (lexeme.contains("DedentError")) {
-                errorMsg = "Unindent does not match any outer indentation level.";
-            }
-            else if (lexeme.contains("IndentError")) {
-                errorMsg = "Inconsistent indentation level.";
-            }
-            // Check for numeric identifier (identifier starting with digit)
-            else if (QRegularExpression("^\\d+[a-zA-Z_][a-zA-Z0-9_]*$").match(lexeme).hasMatch()) {
-                errorMsg = QString("Identifier cannot start with a digit: '%1'").arg(lexeme);
-            }
-            // Check for keyword misused as identifier
-            else if (lexeme == "if" || lexeme == "else" || lexeme == "elif" ||
-                     lexeme == "while" || lexeme == "for" || lexeme == "def" ||
-                     lexeme == "return" || lexeme == "True" || lexeme == "False" ||
-                     lexeme == "None" || lexeme == "in" || lexeme == "import") {
-                errorMsg = QString("Reserved keyword '%1' cannot be used as an identifier").arg(lexeme);
-            }
-            // Check for invalid characters in identifiers
-            else if (QRegularExpression("[a-zA-Z_][a-zA-Z0-9_]*[@#$%^&*!~`]+[a-zA-Z0-9_]*").match(lexeme).hasMatch()) {
-                errorMsg = QString("Invalid character in identifier: '%1'").arg(lexeme);
-            }
-            // Check for multiple decimal points
-            else if (QRegularExpression("^[+-]?\\d*(\\.\\d+){2,}$").match(lexeme).hasMatch()) {
-                errorMsg = QString("Invalid float number: '%1'").arg(lexeme);
-            }
-            // Default error message
-            else {
-                errorMsg = QString("Unknown or invalid token '%1'").arg(lexeme);
-            }
-
-            row.append(new QStandardItem(errorMsg));
-
-            // Add line and column
-            row.append(new QStandardItem(QString::number(token.line_number)));
-            row.append(new QStandardItem(QString::number(token.column_number)));
-
-            errorTableModel->appendRow(row);
+    errorTableModel->show(static_cast<int>(diagnostics.size()), [&diagnostics](int row, int column) {
+        const Diagnostic& diagnostic = diagnostics[row];
+        switch (column) {
+        case 0:
+            return QString("Lexical Error");
+        case 1:
+            // The lexer records what went wrong; the message is formatted only here
+            return QString::fromStdString(Diagnostics::summary(diagnostic));
+        case 2:
+            return QString::number(diagnostic.line_number);
+        default:
+            return QString::number(diagnostic.column_number);
         }
-    }
+    });
 
     // If errors were found, switch to the errors tab
     if (errorTableModel->rowCount() > 0) {
@@ -333,105 +505,61 @@ void MainWindow::updateErrorTable(const vector<Token> &tokens)
     ui->errorTableView->resizeColumnsToContents();
 }
 
-void MainWindow::on_actionRun_Parser_triggered()
+void MainWindow::showParserResults(shared_ptr<const ParseResult> tree)
 {
-    // First run the lexer to ensure we have tokens
-    on_actionRun_Lexer_triggered();
-
-    // Check if lexer found errors
-    int lexerErrorCount = 0;
-    for (int i = 0; i < errorTableModel->rowCount(); i++) {
-        if (errorTableModel->item(i, 0)->text() == "Lexical Error") {
-            lexerErrorCount++;
-        }
-    }
-
-    // If lexer found errors, don't run the parser
-    if (lexerErrorCount > 0) {
-        showStatusMessage("Cannot parse: Lexical errors must be fixed first", true);
-        return;
-    }
-
-    // Clear parse tree and parser errors
-    parseTreeScene->clear();
-    parseTreeWidget->setParseTree(nullptr);
-
-    // Create the lexer and parser
-    Lexer lexer;
-    QString sourceCode = ui->sourceEditor->toPlainText();
-    lexer.tokenize(sourceCode.toStdString());
-
-    Parser parser(lexer);
-
-    try {
-        // Run the parser
-        shared_ptr<ProgramNode> ast = parser.parse();
-
-        // Handle parser errors
-        if (parser.hasError()) {
-            updateParserErrorTable(parser.getErrors());
-            showStatusMessage("Parser completed with errors", true);
-            ui->outputTabs->setCurrentIndex(2); // Switch to errors tab
-        } else {
-            showStatusMessage("Parser completed successfully", false);
-            // Visualize the parse tree
-            visualizeParseTree(ast);
-            ui->outputTabs->setCurrentIndex(3); // Switch to parse tree tab
-
-            // Make sure the tree is centered properly after resizing
-            QTimer::singleShot(100, this, [this]() {
-                if (parseTreeWidget) {
-                    parseTreeWidget->update();
-                }
-            });
-        }
-    } catch (const exception& e) {
-        QMessageBox::critical(this, "Parser Error", "An exception occurred during parsing: " + QString(e.what()));
-        showStatusMessage("Parser failed with an exception", true);
+    // Handle parser errors
+    if (editorParser.hasError()) {
+        updateParserErrorTable(editorParser.getErrors());
+        showStatusMessage("Parser completed with errors", true);
+        ui->outputTabs->setCurrentIndex(2); // Switch to errors tab
+    } else {
+        showStatusMessage("Parser completed successfully", false);
+        // Visualize the parse tree
+        visualizeParseTree(move(tree));
+        ui->outputTabs->setCurrentIndex(3); // Switch to parse tree tab
+
+        // Make sure the tree is centered properly after resizing
+        QTimer::singleShot(100, this, [this]() {
+            if (parseTreeWidget) {
+                parseTreeWidget->update();
+            }
+        });
     }
 }
 
-void MainWindow::updateParserErrorTable(const vector<string> &errors)
+void MainWindow::updateParserErrorTable(vector<string> errors)
 {
-    // Add parser errors to the error table
-    for (const auto& error : errors) {
-        QList<QStandardItem*> row;
-
-        // Add error type
-        row.append(new QStandardItem("Syntax Error"));
-
-        // Extract line and column from error message if available
-        QString errorMsg = QString::fromStdString(error);
-        int line = 0;
-        int column = 0;
-
-        QRegularExpression lineColRegex("line (\\d+), column (\\d+)");
-        QRegularExpressionMatch match = lineColRegex.match(errorMsg);
-
-        if (match.hasMatch()) {
-            line = match.captured(1).toInt();
-            column = match.captured(2).toInt();
+    // Replaces the lexer errors, of which there are none once the parser has run
+    auto messages = make_shared<const vector<string>>(move(errors));
+
+    errorTableModel->show(static_cast<int>(messages->size()), [messages](int row, int column) {
+        QString errorMsg = QString::fromStdString((*messages)[row]);
+        switch (column) {
+        case 0:
+            return QString("Syntax Error");
+        case 1:
+            return errorMsg;
+        default: {
+            // Extract line and column from error message if available
+            static const QRegularExpression lineColRegex("line (\\d+), column (\\d+)");
+            QRegularExpressionMatch match = lineColRegex.match(errorMsg);
+            int value = match.hasMatch() ? match.captured(column == 2 ? 1 : 2).toInt() : 0;
+            return value > 0 ? QString::number(value) : QString();
         }
-
-        // Add message, line, column
-        row.append(new QStandardItem(errorMsg));
-        row.append(new QStandardItem(line > 0 ? QString::number(line) : ""));
-        row.append(new QStandardItem(column > 0 ? QString::number(column) : ""));
-
-        errorTableModel->appendRow(row);
-    }
+        }
+    });
 
     // Resize columns to content
     ui->errorTableView->resizeColumnsToContents();
 }
 
 // New implementation of visualizeParseTree that uses the custom widget
-void MainWindow::visualizeParseTree(shared_ptr<ASTNode> root) {
-    if (!root) {
+void MainWindow::visualizeParseTree(shared_ptr<const ParseResult> tree) {
+    if (!tree || !tree->root) {
         return;
     }
     // Use our custom widget to display the tree
-    parseTreeWidget->setParseTree(root);
+    parseTreeWidget->setParseTree(move(tree));
 
 }
 
@@ -484,8 +612,8 @@ void MainWindow::onErrorTableDoubleClicked(const QModelIndex &index)
     // Give focus to the editor
     ui->sourceEditor->setFocus();
 
-    // Highlight the current line with light gray
-    QList<QTextEdit::ExtraSelection> extraSelections;
+    // Highlight the current line with light gray, keeping the error marks
+    QList<QTextEdit::ExtraSelection> extraSelections = errorSelections;
     QTextEdit::ExtraSelection selection;
 
     // Light gray color for line highlighting
@@ -505,67 +633,61 @@ void MainWindow::onErrorTableDoubleClicked(const QModelIndex &index)
     showStatusMessage(QString("Line %1, Column %2: %3").arg(lineNumber).arg(columnNumber).arg(errorMessage), true, 10000);
 }
 
-void MainWindow::highlightErrors(const vector<Token> &tokens)
+void MainWindow::highlightErrors(const TokenStream &tokens)
 {
-    // Get the document from the text editor
+    // Marked as extra selections: formatting the text itself would touch
+    // the whole document and mark it modified
     QTextDocument* document = ui->sourceEditor->document();
 
-    // Create a text cursor for manipulating the document
-    QTextCursor cursor(document);
-
     // Create a format for highlighting errors
     QTextCharFormat errorFormat;
     errorFormat.setBackground(Qt::red);
     errorFormat.setForeground(Qt::white);
 
-    // Clear existing highlighting by resetting the document's format
-    cursor.select(QTextCursor::Document);
-    QTextCharFormat defaultFormat;
-    cursor.setCharFormat(defaultFormat);
-
-    // Apply highlighting for each error
-    for (const auto& token : tokens) {
-        if (token.type == ERROR) {
-            // Go to the line and column of the error
-            int line = token.line_number - 1; // 0-based line index
-            int column = token.column_number - 1; // 0-based column index
-
-            // Find the block (line) where the error is
-            QTextBlock block = document->findBlockByLineNumber(line);
-            if (!block.isValid()) continue;
-
-            // Create a cursor at the position of the error
-            cursor = QTextCursor(block);
-            cursor.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor, column);
-
-            // Select the error token
-            cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, token.lexeme.length());
-
-            // Apply the error format
-            cursor.setCharFormat(errorFormat);
-        }
+    // Apply highlighting for each error; the error table lists the ones past the cap
+    errorSelections.clear();
+    for (size_t i = 0; i < tokens.size() && errorSelections.size() < maxHighlightedErrors; ++i) {
+        if (tokens.type(i) != ERROR)
+            continue;
+
+        // Go to the line and column of the error
+        int line = tokens.line(i) - 1; // 0-based line index
+        int column = tokens.column(i) - 1; // 0-based column index
+
+        // Find the block (line) where the error is
+        QTextBlock block = document->findBlockByLineNumber(line);
+        if (!block.isValid()) continue;
+
+        // Create a cursor at the position of the error
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(block);
+        selection.cursor.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor, column);
+
+        // Select the error token
+        selection.cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor,
+                                      static_cast<int>(tokens.lexeme(i).length()));
+        selection.format = errorFormat;
+        errorSelections.append(selection);
     }
+    ui->sourceEditor->setExtraSelections(errorSelections);
 }
 
 void MainWindow::on_actionClear_Output_triggered()
 {
+    stopAnalysis();
+
     // Clear all tables
-    tokenTableModel->removeRows(0, tokenTableModel->rowCount());
-    symbolTableModel->removeRows(0, symbolTableModel->rowCount());
-    errorTableModel->removeRows(0, errorTableModel->rowCount());
+    tokenTableModel->clear();
+    symbolTableModel->clear();
+    errorTableModel->clear();
 
     // Clear parse tree visualizations
     parseTreeScene->clear();
     parseTreeWidget->setParseTree(nullptr);
 
-    // Clear any error highlighting in the source editor
-    QTextCursor cursor(ui->sourceEditor->document());
-    cursor.select(QTextCursor::Document);
-    QTextCharFormat defaultFormat;
-    cursor.setCharFormat(defaultFormat);
-
-    // Clear any extra selections (like the current line highlight)
-    ui->sourceEditor->setExtraSelections(QList<QTextEdit::ExtraSelection>());
+    // Clear the error marks and the current line highlight in the source editor
+    errorSelections.clear();
+    ui->sourceEditor->setExtraSelections(errorSelections);
 
     showStatusMessage("Output cleared", false, 2000);
 }
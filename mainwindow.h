@@ -4,22 +4,30 @@
 #include <QMainWindow>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QStandardItemModel>
 #include <QTextStream>
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QString>
 #include <QDebug>
 #include <QTextBlock>
 #include <QTextDocument>
 #include <QTextCursor>
+#include <QTextEdit>
 #include <QRegularExpression>
 #include <QGraphicsScene>
 #include <QGraphicsEllipseItem>
 #include <QGraphicsTextItem>
 #include <QGraphicsLineItem>
+#include <QPointer>
+#include <QProgressBar>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
 #include "lexer.h"
 #include "parser.h"
 #include "ParseTreeWidget.h"
+#include "AnalysisTableModel.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -33,6 +41,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+signals:
+    // Emitted on the worker thread when analysis run `run` has ended
+    void analysisFinished(int run);
+
 private slots:
     // File menu actions
     void on_actionOpen_triggered();
@@ -43,6 +55,7 @@ private slots:
     // Compiler menu actions
     void on_actionRun_Lexer_triggered();
     void on_actionRun_Parser_triggered(); // Add parser action
+    void on_actionCancel_Analysis_triggered();
     void on_actionClear_Output_triggered();
 
     // Help menu action
@@ -50,14 +63,24 @@ private slots:
 
     void showStatusMessage(const QString& message, bool isError = false, int messageTimeout = 0, int styleTimeout = 5000);
 
+    // Shows the results of a run once its worker has finished
+    void onAnalysisFinished(int run);
+
 private:
     Ui::MainWindow *ui;
     QString currentFilePath;
+    QDateTime currentFileModified; // on-disk timestamp when the file was loaded/saved
 
-    // Models for table views
-    QStandardItemModel *tokenTableModel;
-    QStandardItemModel *symbolTableModel;
-    QStandardItemModel *errorTableModel;
+    // Models for table views. The token table and the lexer errors are read
+    // from editorLexer in place, so they are cleared before it changes, and
+    // its text is never a mapping of a file that Save or another program
+    // can rewrite underneath them.
+    AnalysisTableModel *tokenTableModel;
+    AnalysisTableModel *symbolTableModel;
+    AnalysisTableModel *errorTableModel;
+
+    // Lexical errors marked in the editor
+    QList<QTextEdit::ExtraSelection> errorSelections;
 
     // For parse tree visualization
     QGraphicsScene *parseTreeScene;
@@ -72,24 +95,72 @@ private:
     void setupTableModels();
 
     // Update the token table with lexer output
-    void updateTokenTable(const std::vector<Token> &tokens);
+    void updateTokenTable(Lexer &lexer);
 
     // Update the symbol table with lexer output
-    void updateSymbolTable(const std::vector<std::pair<std::string, std::pair<std::string, int>>> &symbolTable);
+    void updateSymbolTable(std::vector<std::pair<std::string, std::pair<std::string, int>>> symbolTable);
 
     // Update the error table with lexer/parser errors
-    void updateErrorTable(const std::vector<Token> &tokens);
-    void updateParserErrorTable(const std::vector<std::string> &errors);
+    void updateErrorTable(const Diagnostics &diagnostics);
+    void updateParserErrorTable(std::vector<std::string> errors);
 
     // Helper functions for error highlighting in source code
-    void highlightErrors(const std::vector<Token> &tokens);
+    void highlightErrors(const TokenStream &tokens);
     void onErrorTableDoubleClicked(const QModelIndex &index);
 
     // Parse tree visualization method
-    void visualizeParseTree(std::shared_ptr<ASTNode> root);
+    void visualizeParseTree(std::shared_ptr<const ParseResult> tree);
 
     // Save file function used by both save actions
     bool saveFile(const QString &filePath);
 
+    // The file the editor was loaded from, if it still holds exactly what
+    // is on disk (so it can be lexed in place); empty otherwise
+    std::string unchangedEditorFile() const;
+
+    // Run the lexer on the editor contents, or memory-map `filePath` when it
+    // is not empty. The whole token stream is kept: the token table and the
+    // incremental reparse both need it.
+    void tokenizeEditorSource(Lexer &lexer, const QString &sourceCode, const std::string &filePath);
+
+    // Lexer kept between Run Lexer presses: the first run lexes the whole
+    // editor text, later runs re-lex only the span that changed since.
+    // `token` stays set on the lexer until the caller clears it.
+    std::unique_ptr<Lexer> editorLexer;
+    Lexer &relexEditorSource(const QString &sourceCode, const std::string &filePath, CancelToken *token);
+
+    // Parses editorLexer's tokens; Run Parser reparses only the top-level
+    // statements that the edits since the previous run touched
+    IncrementalParser editorParser;
+
+    // One Run Lexer / Run Parser press. Its worker thread owns editorLexer
+    // and editorParser until analysisFinished() arrives; the GUI thread
+    // only reads `token` and `parsing` in the meantime.
+    struct AnalysisRun {
+        int id = 0;
+        bool parse = false;              // run the parser after the lexer
+        QString sourceCode;
+        std::string filePath;            // see unchangedEditorFile()
+        CancelToken token;
+        std::atomic<bool> parsing{false}; // the lexer is done
+        bool cancelled = false;
+        QString error;                   // what() of an exception, if one ended the run
+        std::shared_ptr<const ParseResult> tree;
+    };
+    std::unique_ptr<AnalysisRun> analysis; // the run in progress, if any
+    QPointer<QThread> analysisThread;
+    int analysisRuns = 0;
+    QProgressBar *analysisProgress;
+    QTimer *analysisProgressTimer;
+
+    void startAnalysis(bool parse);
+    void runAnalysis(AnalysisRun &run); // on the worker thread
+    std::unique_ptr<AnalysisRun> takeAnalysis();
+    void stopAnalysis();
+
+    // Fill the output tabs from editorLexer / a parse of its tokens
+    void showLexerResults();
+    void showParserResults(std::shared_ptr<const ParseResult> tree);
+
 };
 #endif // MAINWINDOW_H
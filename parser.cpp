@@ -4,404 +4,523 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <cstring>
+#include <utility>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <charconv>
 using namespace std;
 
-// Helper function to create indentation for pretty printing
-string getIndentation(int indent) {
-    return string(indent * 2, ' ');
+AstArena& AstArena::operator=(AstArena&& other) noexcept {
+    blocks = move(other.blocks);
+    cursor = exchange(other.cursor, nullptr);
+    limit = exchange(other.limit, nullptr);
+    other.blocks.clear();
+    return *this;
 }
 
-// AST Node toString implementations
-string ProgramNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Program" << endl;
-    for (const auto& stmt : statements) {
-        ss << stmt->toString(indent + 1);
+void* AstArena::allocate(size_t size, size_t align) {
+    uintptr_t at = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+    if (cursor && at + size <= reinterpret_cast<uintptr_t>(limit)) {
+        cursor = reinterpret_cast<char*>(at + size);
+        return reinterpret_cast<void*>(at);
     }
-    return ss.str();
-}
 
-string StatementListNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "StatementList" << endl;
-    for (const auto& stmt : statements) {
-        ss << stmt->toString(indent + 1);
+    // Oversized requests get a block of their own; the current block stays
+    // open for the small allocations that follow.
+    if (size > BLOCK_SIZE / 4) {
+        blocks.emplace_back(new char[size]);
+        return blocks.back().get();
     }
-    return ss.str();
-}
 
-string BlockNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Block" << endl;
-    ss << statements->toString(indent + 1);
-    return ss.str();
+    blocks.emplace_back(new char[BLOCK_SIZE]);
+    cursor = blocks.back().get() + size;
+    limit = blocks.back().get() + BLOCK_SIZE;
+    return blocks.back().get();
 }
 
-string AssignmentNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Assignment (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Target:" << endl;
-    ss << target->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Value:" << endl;
-    ss << value->toString(indent + 2);
-    return ss.str();
+string_view AstArena::copy(string_view text) {
+    if (text.empty()) return {};
+    char* chars = static_cast<char*>(allocate(text.size(), 1));
+    memcpy(chars, text.data(), text.size());
+    return string_view(chars, text.size());
 }
 
-string IfNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "If Statement (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Condition:" << endl;
-    ss << condition->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Then:" << endl;
-    ss << if_block->toString(indent + 2);
-
-    if (!elif_clauses.empty()) {
-        ss << getIndentation(indent + 1) << "Elif Clauses:" << endl;
-        for (const auto& elif : elif_clauses) {
-            ss << elif->toString(indent + 2);
-        }
-    }
-
-    if (else_block) {
-        ss << getIndentation(indent + 1) << "Else:" << endl;
-        ss << else_block->toString(indent + 2);
-    }
-
-    return ss.str();
+void AstArena::clear() {
+    blocks.clear();
+    cursor = nullptr;
+    limit = nullptr;
 }
 
-string ElifNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Elif Clause (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Condition:" << endl;
-    ss << condition->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Then:" << endl;
-    ss << block->toString(indent + 2);
-    return ss.str();
+// AST printing
+string ASTNode::toString(int indent) const {
+    string out;
+    ASTPrinter(out).print(this, indent);
+    return out;
 }
 
-string ElseNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Else Clause (line " << line_number << ")" << endl;
-    ss << block->toString(indent + 1);
-    return ss.str();
-}
-
-string WhileNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "While Statement (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Condition:" << endl;
-    ss << condition->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Body:" << endl;
-    ss << block->toString(indent + 2);
-    return ss.str();
+void ASTPrinter::print(const ASTNode* root, int indent) {
+    child(root, indent);
+    while (!pending.empty()) {
+        Item item = pending.back();
+        pending.pop_back();
+        if (item.node) {
+            visit(item.node, item.indent);
+        } else {
+            startLine(item.indent);
+            out += item.text;
+            out += item.detail;
+            out += '\n';
+        }
+        if (sink && out.size() >= FLUSH_BYTES) flush();
+    }
+    flush();
+}
+
+void ASTPrinter::flush() {
+    if (!sink) return;
+    sink->write(out.data(), static_cast<streamsize>(out.size()));
+    out.clear();
+}
+
+void ASTPrinter::child(const ASTNode* node, int indent) {
+    if (node) pending.push_back({node, indent, {}, {}});
+}
+
+void ASTPrinter::label(int indent, string_view text, string_view detail) {
+    pending.push_back({nullptr, indent, text, detail});
+}
+
+void ASTPrinter::startLine(int indent) {
+    out.append(size_t(indent) * 2, ' ');
+}
+
+void ASTPrinter::appendNumber(int value) {
+    char digits[16];
+    out.append(digits, to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+// Writes the node's own line, then queues what goes below it. Children and
+// labels are queued in output order and reversed at the end, since
+// `pending` is popped from the back.
+void ASTPrinter::visit(const ASTNode* node, int indent) {
+    const size_t first = pending.size();
+    startLine(indent);
+
+    switch (node->type) {
+    case NodeType::PROGRAM:
+        out += "Program\n";
+        for (ASTNode* statement : static_cast<const ProgramNode*>(node)->statements) child(statement, indent + 1);
+        break;
+    case NodeType::STATEMENT_LIST:
+        out += "StatementList\n";
+        for (ASTNode* statement : static_cast<const StatementListNode*>(node)->statements) child(statement, indent + 1);
+        break;
+    case NodeType::STATEMENT:
+        out += "Statement\n";
+        child(static_cast<const StatementNode*>(node)->statement, indent + 1);
+        break;
+    case NodeType::BLOCK:
+        out += "Block\n";
+        child(static_cast<const BlockNode*>(node)->statements, indent + 1);
+        break;
+    case NodeType::ASSIGNMENT_STMT: {
+        auto assign = static_cast<const AssignmentNode*>(node);
+        out += "Assignment (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Target:");
+        child(assign->target, indent + 2);
+        label(indent + 1, "Value:");
+        child(assign->value, indent + 2);
+        break;
+    }
+    case NodeType::IF_STMT: {
+        auto ifNode = static_cast<const IfNode*>(node);
+        out += "If Statement (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Condition:");
+        child(ifNode->condition, indent + 2);
+        label(indent + 1, "Then:");
+        child(ifNode->if_block, indent + 2);
+        if (!ifNode->elif_clauses.empty()) {
+            label(indent + 1, "Elif Clauses:");
+            for (ElifNode* elif : ifNode->elif_clauses) child(elif, indent + 2);
+        }
+        if (ifNode->else_block) {
+            label(indent + 1, "Else:");
+            child(ifNode->else_block, indent + 2);
+        }
+        break;
+    }
+    case NodeType::ELIF_CLAUSE: {
+        auto elif = static_cast<const ElifNode*>(node);
+        out += "Elif Clause (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Condition:");
+        child(elif->condition, indent + 2);
+        label(indent + 1, "Then:");
+        child(elif->block, indent + 2);
+        break;
+    }
+    case NodeType::ELSE_CLAUSE:
+        out += "Else Clause (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        child(static_cast<const ElseNode*>(node)->block, indent + 1);
+        break;
+    case NodeType::ELSE_PART: {
+        auto elsePart = static_cast<const ElsePartNode*>(node);
+        out += "ElsePart\n";
+        for (ElifNode* elif : elsePart->elif_clauses) child(elif, indent + 1);
+        child(elsePart->else_block, indent + 1);
+        break;
+    }
+    case NodeType::WHILE_STMT: {
+        auto whileNode = static_cast<const WhileNode*>(node);
+        out += "While Statement (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Condition:");
+        child(whileNode->condition, indent + 2);
+        label(indent + 1, "Body:");
+        child(whileNode->block, indent + 2);
+        break;
+    }
+    case NodeType::FOR_STMT: {
+        auto forNode = static_cast<const ForNode*>(node);
+        out += "For Statement (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Target:");
+        child(forNode->target, indent + 2);
+        label(indent + 1, "Iterable:");
+        child(forNode->iterable, indent + 2);
+        label(indent + 1, "Body:");
+        child(forNode->block, indent + 2);
+        break;
+    }
+    case NodeType::FUNC_DEF: {
+        auto funcDef = static_cast<const FunctionDefNode*>(node);
+        out += "Function Definition: ";
+        out += funcDef->name;
+        out += " (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Parameters:");
+        child(funcDef->params, indent + 2);
+        label(indent + 1, "Body:");
+        child(funcDef->body, indent + 2);
+        break;
+    }
+    case NodeType::RETURN_STMT: {
+        auto returnNode = static_cast<const ReturnNode*>(node);
+        out += "Return Statement (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        if (returnNode->expression) {
+            child(returnNode->expression, indent + 1);
+        } else {
+            label(indent + 1, "None");
+        }
+        break;
+    }
+    case NodeType::IMPORT_STMT: {
+        auto import = static_cast<const ImportNode*>(node);
+        out += "Import Statement (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Module: ", import->module);
+        if (!import->alias.empty()) {
+            label(indent + 1, "As: ", import->alias);
+        }
+        break;
+    }
+    case NodeType::BINARY_EXPR: {
+        auto binary = static_cast<const BinaryExprNode*>(node);
+        out += "Binary Expression: ";
+        out += lexemeText(binary->op);
+        out += " (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Left:");
+        child(binary->left, indent + 2);
+        label(indent + 1, "Right:");
+        child(binary->right, indent + 2);
+        break;
+    }
+    case NodeType::UNARY_EXPR: {
+        auto unary = static_cast<const UnaryExprNode*>(node);
+        out += "Unary Expression: ";
+        out += lexemeText(unary->op);
+        out += " (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Operand:");
+        child(unary->operand, indent + 2);
+        break;
+    }
+    case NodeType::CALL_EXPR: {
+        auto call = static_cast<const CallExprNode*>(node);
+        out += "Function Call (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Function:");
+        child(call->function, indent + 2);
+        label(indent + 1, "Arguments:");
+        child(call->arguments, indent + 2);
+        break;
+    }
+    case NodeType::SUBSCRIPT_EXPR: {
+        auto subscript = static_cast<const SubscriptExprNode*>(node);
+        out += "Subscript Expression (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Container:");
+        child(subscript->container, indent + 2);
+        label(indent + 1, "Index:");
+        child(subscript->index, indent + 2);
+        break;
+    }
+    case NodeType::ATTR_REF: {
+        auto attr = static_cast<const AttrRefNode*>(node);
+        out += "Attribute Reference (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        label(indent + 1, "Object:");
+        child(attr->object, indent + 2);
+        label(indent + 1, "Attribute: ", attr->attribute);
+        break;
+    }
+    case NodeType::EXPRESSION:
+        out += "Expression\n";
+        child(static_cast<const ExpressionNode*>(node)->expression, indent + 1);
+        break;
+    case NodeType::GROUP_EXPR:
+        out += "GroupExpr (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        child(static_cast<const GroupExprNode*>(node)->expression, indent + 1);
+        break;
+    case NodeType::ASSIGNMENT_WRAPPER:
+        out += "AssignmentStatement\n";
+        child(static_cast<const AssignStmtNode*>(node)->assignment, indent + 1);
+        break;
+    case NodeType::COMPARISON_WRAPPER:
+        out += "ComparisonExpression\n";
+        child(static_cast<const ComparisonExprNode*>(node)->comparison, indent + 1);
+        break;
+    case NodeType::IDENTIFIER:
+        out += "Identifier: ";
+        out += static_cast<const IdentifierNode*>(node)->name;
+        out += " (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        break;
+    case NodeType::LITERAL: {
+        auto literal = static_cast<const LiteralNode*>(node);
+        out += "Literal: ";
+        out += literal->value;
+        out += " (";
+        out += literal->type;
+        out += ") (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        break;
+    }
+    case NodeType::LIST_LITERAL:
+        out += "List (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        for (ASTNode* element : static_cast<const ListNode*>(node)->elements) child(element, indent + 1);
+        break;
+    case NodeType::DICT_LITERAL:
+        out += "Dictionary (line ";
+        appendNumber(node->line_number);
+        out += ")\n";
+        for (const auto& item : static_cast<const DictNode*>(node)->items) {
+            label(indent + 1, "Key:");
+            child(item.first, indent + 2);
+            label(indent + 1, "Value:");
+            child(item.second, indent + 2);
+        }
+        break;
+    case NodeType::PARAM_LIST:
+        out += "Parameters:\n";
+        for (ParameterNode* param : static_cast<const ParamListNode*>(node)->parameters) child(param, indent + 1);
+        break;
+    case NodeType::PARAMETER_NODE: {
+        auto param = static_cast<const ParameterNode*>(node);
+        out += "Parameter: ";
+        out += param->name;
+        if (param->default_value) {
+            out += " (with default value)\n";
+            child(param->default_value, indent + 1);
+        } else {
+            out += " (no default)\n";
+        }
+        break;
+    }
+    case NodeType::ARG_LIST:
+        out += "Argument List:\n";
+        for (ASTNode* arg : static_cast<const ArgListNode*>(node)->arguments) child(arg, indent + 1);
+        break;
+    case NodeType::CONDITION_NODE:
+        out += "Condition:\n";
+        child(static_cast<const ConditionNode*>(node)->condition, indent + 1);
+        break;
+    case NodeType::TERMINAL:
+        out += "Terminal: ";
+        out += static_cast<const TerminalNode*>(node)->value;
+        out += " (line ";
+        appendNumber(node->line_number);
+        out += ", col ";
+        appendNumber(node->column_number);
+        out += ")\n";
+        break;
+    case NodeType::ERROR_NODE:
+        out += "ERROR (line ";
+        appendNumber(node->line_number);
+        out += "): ";
+        out += static_cast<const ErrorNode*>(node)->message;
+        out += '\n';
+        break;
+    }
+
+    reverse(pending.begin() + first, pending.end());
 }
 
-string ForNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "For Statement (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Target:" << endl;
-    ss << target->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Iterable:" << endl;
-    ss << iterable->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Body:" << endl;
-    ss << block->toString(indent + 2);
-    return ss.str();
+// Parser implementation
+Parser::Parser(TokenSource& source)
+    : source(source), current_token(source.nextToken()), has_error(false) {
 }
 
-string FunctionDefNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Function Definition: " << name << " (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Parameters:" << endl;
-    ss << params->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Body:" << endl;
-    ss << body->toString(indent + 2);
-    return ss.str();
+const Token& Parser::peek() {
+    return current_token;
 }
 
-string ReturnNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Return Statement (line " << line_number << ")" << endl;
-    if (expression) {
-        ss << expression->toString(indent + 1);
-    } else {
-        ss << getIndentation(indent + 1) << "None" << endl;
+Token Parser::consume() {
+    if (!isAtEnd()) {
+        Token token = current_token;
+        current_token = source.nextToken();
+        return token;
     }
-    return ss.str();
+    return current_token; // Return EOF token
 }
 
-string ImportNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Import Statement (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Module: " << module << endl;
-    if (!alias.empty()) {
-        ss << getIndentation(indent + 1) << "As: " << alias << endl;
+bool Parser::match(TokenType type) {
+    if (check(type)) {
+        consume();
+        return true;
     }
-    return ss.str();
-}
-
-string BinaryExprNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Binary Expression: " << op << " (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Left:" << endl;
-    ss << left->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Right:" << endl;
-    ss << right->toString(indent + 2);
-    return ss.str();
-}
-
-string UnaryExprNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Unary Expression: " << op << " (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Operand:" << endl;
-    ss << operand->toString(indent + 2);
-    return ss.str();
-}
-
-string CallExprNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Function Call (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Function:" << endl;
-    ss << function->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Arguments:" << endl;
-    ss << arguments->toString(indent + 2);
-    return ss.str();
-}
-
-string SubscriptExprNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Subscript Expression (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Container:" << endl;
-    ss << container->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Index:" << endl;
-    ss << index->toString(indent + 2);
-    return ss.str();
-}
-
-string AttrRefNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Attribute Reference (line " << line_number << ")" << endl;
-    ss << getIndentation(indent + 1) << "Object:" << endl;
-    ss << object->toString(indent + 2);
-    ss << getIndentation(indent + 1) << "Attribute: " << attribute << endl;
-    return ss.str();
-}
-
-string IdentifierNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Identifier: " << name << " (line " << line_number << ")" << endl;
-    return ss.str();
-}
-
-string LiteralNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Literal: " << value << " (" << type << ") (line " << line_number << ")" << endl;
-    return ss.str();
+    return false;
 }
 
-string ListNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "List (line " << line_number << ")" << endl;
-    for (const auto& el : elements) {
-        ss << el->toString(indent + 1);
+bool Parser::match(const string& lexeme) {
+    if (check(lexeme)) {
+        consume();
+        return true;
     }
-    return ss.str();
+    return false;
 }
 
-string DictNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Dictionary (line " << line_number << ")" << endl;
-    for (const auto& item : items) {
-        ss << getIndentation(indent + 1) << "Key:" << endl;
-        ss << item.first->toString(indent + 2);
-        ss << getIndentation(indent + 1) << "Value:" << endl;
-        ss << item.second->toString(indent + 2);
+bool Parser::match(LexemeId id) {
+    if (check(id)) {
+        consume();
+        return true;
     }
-    return ss.str();
+    return false;
 }
 
-string ParameterNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Parameter: " << name;
-
-    if (default_value) {
-        ss << " (with default value)" << endl;
-        ss << default_value->toString(indent + 1);
-    } else {
-        ss << " (no default)" << endl;
-    }
-
-    return ss.str();
+bool Parser::check(TokenType type) {
+    if (isAtEnd()) return false;
+    return current_token.type == type;
 }
 
-
-string ParamListNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Parameters:" << endl;
-
-    for (const auto& param : parameters) {
-        ss << param->toString(indent + 1);
-    }
-
-    return ss.str();
+bool Parser::check(const string& lexeme) {
+    if (isAtEnd()) return false;
+    return current_token.lexeme == lexeme;
 }
 
-string ArgListNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Argument List:" << endl;
-    for (const auto& arg : arguments) {
-        ss << arg->toString(indent + 1);
-    }
-    return ss.str();
+bool Parser::check(LexemeId id) {
+    if (isAtEnd()) return false;
+    return current_token.id == id;
 }
 
-// In parser.cpp:
-string ConditionNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Condition:" << endl;
-    if (condition) {
-        ss << condition->toString(indent + 1);
-    }
-    return ss.str();
+bool Parser::isAtEnd() {
+    return current_token.type == END_OF_FILE;
 }
 
-// Add this with your other toString implementations
-string TerminalNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Terminal: " << value
-       << " (line " << line_number << ", col " << column_number << ")\n";
-    return ss.str();
+bool Parser::isAssignmentOperator(uint32_t id) {
+    // =, and the compound assignments, which have consecutive IDs (+= ... >>=)
+    return id == LEX_ASSIGN || (id >= LEX_PLUS_ASSIGN && id <= LEX_RSHIFT_ASSIGN);
 }
 
-string ErrorNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "ERROR (line " << line_number << "): " << message << endl;
-    return ss.str();
-}
 
-string StatementNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Statement" << endl;
-    ss << statement->toString(indent + 1);
-    return ss.str();
+string SyntaxError::text() const
+{
+    return "Syntax Error at line " + to_string(line_number) + ", column "
+           + to_string(column_number) + ": " + message;
 }
-string ElsePartNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "ElsePart" << endl;
 
-    for (const auto& elif : elif_clauses) {
-        ss << elif->toString(indent + 1);
-    }
-
-    if (else_block) {
-        ss << else_block->toString(indent + 1);
-    }
-
-    return ss.str();
-}
-string ExpressionNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "Expression" << endl;
-    if (expression) {
-        ss << expression->toString(indent + 1);
-    }
-    return ss.str();
+void Parser::error(const string& message, int line, int column)
+{
+    errors.push_back({message, line, column});
+    has_error = true;
 }
 
-string AssignStmtNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "AssignmentStatement" << endl;
-    if (assignment) {
-        ss << assignment->toString(indent + 1);
+vector<string> Parser::getErrors() const {
+    vector<string> messages;
+    messages.reserve(errors.size());
+    for (const SyntaxError& error : errors) {
+        messages.push_back(error.text());
     }
-    return ss.str();
-}
-string ComparisonExprNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "ComparisonExpression" << endl;
-    if (comparison) {
-        ss << comparison->toString(indent + 1);
-    }
-    return ss.str();
-}
-
-string GroupExprNode::toString(int indent) const {
-    stringstream ss;
-    ss << getIndentation(indent) << "GroupExpr (line " << line_number << ")" << endl;
-    ss << expression->toString(indent + 1);
-    return ss.str();
-}
-
-// Parser implementation
-Parser::Parser(Lexer& lexer) : lexer(lexer), has_error(false) {
-    current_token = lexer.tokens.begin();
-}
-
-Token& Parser::peek() {
-    return *current_token;
+    return messages;
 }
 
-Token& Parser::consume() {
-    if (!isAtEnd()) {
-        return *(current_token++);
+void Parser::fail(const char* message) {
+    // Only the innermost failure is reported, as the first throw used to be
+    if (!failure) {
+        failure = arena.make<ErrorNode>(message, peek().line_number, peek().column_number);
     }
-    return *current_token; // Return EOF token
 }
 
-bool Parser::match(TokenType type) {
-    if (check(type)) {
-        consume();
-        return true;
+Parser::NestingScope::NestingScope(Parser& parser) : parser(parser) {
+    if (++parser.nesting > parser.max_nesting && !parser.failed()) {
+        parser.error("Nesting too deep: more than " + to_string(parser.max_nesting) + " levels of brackets, operators or blocks",
+                     parser.peek().line_number, parser.peek().column_number);
+        parser.fail("Syntax error: nesting too deep");
+        parser.too_deep = true;
     }
-    return false;
 }
 
-bool Parser::match(const string& lexeme) {
-    if (check(lexeme)) {
-        consume();
-        return true;
+void Parser::recover() {
+    error(string(failure->message), failure->line_number, failure->column_number);
+    failure = nullptr;
+    if (!too_deep || !check(INDENT)) {
+        synchronize();
     }
-    return false;
-}
-
-bool Parser::check(TokenType type) {
-    if (isAtEnd()) return false;
-    return current_token->type == type;
-}
-
-bool Parser::check(const string& lexeme) {
-    if (isAtEnd()) return false;
-    return current_token->lexeme == lexeme;
-}
-
-bool Parser::isAtEnd() {
-    return current_token == lexer.tokens.end() || current_token->type == END_OF_FILE;
-}
-
-bool Parser::isAssignmentOperator(const string &lexeme) {
-    return
-        lexeme == "="   ||
-        lexeme == "+="  ||
-        lexeme == "-="  ||
-        lexeme == "*="  ||
-        lexeme == "/="  ||
-        lexeme == "%="  ||
-        lexeme == "**=" ||
-        lexeme == "//=" ||
-        lexeme == "<<=" ||
-        lexeme == ">>=" ||
-        lexeme == "&="  ||
-        lexeme == "|="  ||
-        lexeme == "^=";
+    // Past the nesting limit, also drop the block under the failed
+    // statement: every level inside it would only fail again
+    if (too_deep && check(INDENT)) {
+        skipBlock();
+    }
+    too_deep = false;
 }
 
-
-void Parser::error(const string &message, int line, int column)
-{
-    string error_msg = "Syntax Error at line " + to_string(line) + ", column "
-                            + to_string(column) + ": " + message;
-    errors.push_back(error_msg);
-    has_error = true;
+void Parser::skipBlock() {
+    int levels = 0;
+    do {
+        if (check(INDENT)) {
+            ++levels;
+        } else if (check(DEDENT)) {
+            --levels;
+        }
+        consume();
+    } while (levels > 0 && !isAtEnd());
 }
 
 void Parser::synchronize() {
@@ -410,16 +529,16 @@ void Parser::synchronize() {
     // Skip tokens until we find a statement boundary
     while (!isAtEnd()) {
         // Check if we've reached a semicolon, which marks a statement boundary
-        if (peek().type == SYMBOL && peek().lexeme == ";") {
+        if (peek().type == SYMBOL && peek().id == LEX_SEMICOLON) {
             consume(); // Consume the semicolon
             return;
         }
 
         // These tokens often indicate a statement boundary
         if (peek().type == KEYWORD &&
-            (peek().lexeme == "if" || peek().lexeme == "while" ||
-             peek().lexeme == "for" || peek().lexeme == "def" ||
-             peek().lexeme == "return" || peek().lexeme == "import")) {
+            (peek().id == LEX_IF || peek().id == LEX_WHILE ||
+             peek().id == LEX_FOR || peek().id == LEX_DEF ||
+             peek().id == LEX_RETURN || peek().id == LEX_IMPORT)) {
             return;
         }
 
@@ -431,100 +550,118 @@ void Parser::synchronize() {
     }
 }
 
-shared_ptr<ProgramNode> Parser::parse() {
-    return parseProgram();
+ParseResult Parser::parse() {
+    ParseResult result;
+    result.root = parseProgram();
+    result.arena = move(arena);
+    return result;
 }
 
-shared_ptr<ProgramNode> Parser::parseProgram() {
-    auto program = make_shared<ProgramNode>();
+ProgramNode* Parser::parseProgram() {
+    auto program = arena.make<ProgramNode>();
 
-    try {
-        auto statements = parseStatementList();
-        program->statements = statements->statements;
-    } catch (const exception& e) {
-        error(e.what(), peek().line_number, peek().column_number);
-        synchronize();
-    }
+    // parseStatementList recovers from every failure itself
+    program->statements = parseStatementList()->statements;
 
     return program;
 }
 
-shared_ptr<StatementListNode> Parser::parseStatementList() {
-    auto statement_list = make_shared<StatementListNode>();
+StatementListNode* Parser::parseStatementList() {
+    auto statement_list = arena.make<StatementListNode>();
+    vector<ASTNode*> statements;
 
-    while (!isAtEnd() && peek().type != DEDENT) {
-        try {
-            auto stmt = parseStatement();
-            if (stmt) {
-                statement_list->statements.push_back(stmt);
-            }
-        } catch (const exception& e) {
-            error(e.what(), peek().line_number, peek().column_number);
-            synchronize();
+    while (!atStatementListEnd()) {
+        if (auto stmt = parseStatementOrRecover()) {
+            statements.push_back(stmt);
         }
     }
 
+    statement_list->statements = arena.list(statements);
     return statement_list;
 }
 
-shared_ptr<ASTNode> Parser::parseStatement() {
-    shared_ptr<ASTNode> statement;
+bool Parser::atStatementListEnd() {
+    return isAtEnd() || peek().type == DEDENT;
+}
+
+// The next statement, or nullptr if it had a syntax error (which has been
+// reported and skipped).
+ASTNode* Parser::parseStatementOrRecover() {
+    auto stmt = parseStatement();
+    if (failed()) {
+        recover();
+        return nullptr;
+    }
+    return stmt;
+}
+
+ASTNode* Parser::parseStatement() {
+    ASTNode* statement = nullptr;
 
     // Check for keywords that start specific statement types
     if (check(KEYWORD)) {
-        if (check("if")) {
+        if (check(LEX_IF)) {
             statement = parseIfStatement();
-        } else if (check("while")) {
+        } else if (check(LEX_WHILE)) {
             statement = parseWhileStatement();
-        } else if (check("for")) {
+        } else if (check(LEX_FOR)) {
             statement = parseForStatement();
-        } else if (check("def")) {
+        } else if (check(LEX_DEF)) {
             statement = parseFunctionDef();
-        } else if (check("return")) {
+        } else if (check(LEX_RETURN)) {
             statement = parseReturnStatement();
-        } else if (check("import")) {
+        } else if (check(LEX_IMPORT)) {
             statement = parseImportStatement();
+        } else {
+            // Nothing else starts a statement with a keyword ('else', 'in',
+            // ...); returning without consuming it would loop forever
+            error("Unexpected keyword '" + peek().text() + "'", peek().line_number, peek().column_number);
+            fail("Syntax error: unexpected keyword");
         }
+        if (failed()) return nullptr;
     } else {
         // If not a special statement, it's an expression or assignment
         auto expr = parseExpression();
+        if (failed()) return nullptr;
 
         // Check if this is an assignment (target = value)
-        if (check(OPERATOR) && isAssignmentOperator(peek().lexeme)) {
+        if (check(OPERATOR) && isAssignmentOperator(peek().id)) {
             statement = parseAssignment(expr);
+            if (failed()) return nullptr;
         } else {
             statement = expr;
         }
     }
 
     // Handle optional semicolon at the end of the statement
-    if (check(SYMBOL) && peek().lexeme == ";") {
+    if (check(SYMBOL) && peek().id == LEX_SEMICOLON) {
         consume(); // Consume the semicolon
     }
 
     return statement;
 }
 
-shared_ptr<AssignmentNode> Parser::parseAssignment(shared_ptr<ASTNode> target) {
+AssignmentNode* Parser::parseAssignment(ASTNode* target) {
     Token op = peek();
     consume(); // Consume = operator
 
     auto value = parseExpression();
-    // you’ll need an AssignmentNode constructor that also stores op.lexeme
-    return make_shared<AssignmentNode>(target,
+    if (failed()) return nullptr;
+    return arena.make<AssignmentNode>(target,
                                             value,
-                                            op.lexeme,
+                                            static_cast<OpCode>(op.id),
                                             op.line_number,
                                             op.column_number);
 }
 
-shared_ptr<IfNode> Parser::parseIfStatement() {
+IfNode* Parser::parseIfStatement() {
     Token if_token = consume(); // Consume 'if'
 
     bool hasParentheses = check(LPAREN);
     if (hasParentheses) consume(); // Consume '('
 
     auto condition = parseExpression();
+    if (failed()) return nullptr;
 
     if (hasParentheses) {
         if (!check(RPAREN)) {
@@ -534,37 +671,44 @@ shared_ptr<IfNode> Parser::parseIfStatement() {
         }
     }
 
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after if condition", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in if statement");
+        fail("Syntax error in if statement");
+        return nullptr;
     }
     consume();
 
     auto if_block = parseBlock();
-    // auto if_node = make_shared<IfNode>(condition, if_block, if_token.line_number, if_token.column_number);
-    auto if_node = make_shared<IfNode>(
+    if (failed()) return nullptr;
+    // auto if_node = arena.make<IfNode>(condition, if_block, if_token.line_number, if_token.column_number);
+    auto if_node = arena.make<IfNode>(
         condition, if_block, if_token.line_number, if_token.column_number, hasParentheses);
     // ...
-    // Process elif clauses directly into the vector
-    while (check(KEYWORD) && peek().lexeme == "elif") {
-        if_node->elif_clauses.push_back(parseElifClause());
+    // Process elif clauses
+    vector<ElifNode*> elif_clauses;
+    while (check(KEYWORD) && peek().id == LEX_ELIF) {
+        elif_clauses.push_back(parseElifClause());
+        if (failed()) return nullptr;
     }
+    if_node->elif_clauses = arena.list(elif_clauses);
 
     // Handle optional else clause
-    if (check(KEYWORD) && peek().lexeme == "else") {
+    if (check(KEYWORD) && peek().id == LEX_ELSE) {
         if_node->else_block = parseElseClause();
+        if (failed()) return nullptr;
     }
 
     return if_node;
 }
 
-shared_ptr<ElifNode> Parser::parseElifClause() {
+ElifNode* Parser::parseElifClause() {
     Token elif_token = consume(); // Consume 'elif'
 
     bool hasParentheses = check(LPAREN);
     if (hasParentheses) consume(); // Consume '('
 
     auto condition = parseExpression();
+    if (failed()) return nullptr;
 
     if (hasParentheses) {
         if (!check(RPAREN)) {
@@ -574,38 +718,43 @@ shared_ptr<ElifNode> Parser::parseElifClause() {
         }
     }
 
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after if condition", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in if statement");
+        fail("Syntax error in if statement");
+        return nullptr;
     }
     consume();
 
     auto block = parseBlock();
-    return make_shared<ElifNode>(condition, block, elif_token.line_number, elif_token.column_number, hasParentheses);
+    if (failed()) return nullptr;
+    return arena.make<ElifNode>(condition, block, elif_token.line_number, elif_token.column_number, hasParentheses);
 }
 
-shared_ptr<ElseNode> Parser::parseElseClause() {
+ElseNode* Parser::parseElseClause() {
     Token else_token = consume(); // Consume 'else'
 
     // Check specifically for the colon
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after else", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in else clause");
+        fail("Syntax error in else clause");
+        return nullptr;
     }
     consume(); // Consume the colon - this line is essential
 
     auto block = parseBlock();
-    return make_shared<ElseNode>(block, else_token.line_number, else_token.column_number);
+    if (failed()) return nullptr;
+    return arena.make<ElseNode>(block, else_token.line_number, else_token.column_number);
 }
 
 
-shared_ptr<WhileNode> Parser::parseWhileStatement() {
+WhileNode* Parser::parseWhileStatement() {
     Token while_token = consume(); // Consume 'while'
 
     bool hasParentheses = check(LPAREN);
     if (hasParentheses) consume(); // Consume '('
 
     auto condition = parseExpression();
+    if (failed()) return nullptr;
 
     if (hasParentheses) {
         if (!check(RPAREN)) {
@@ -615,33 +764,38 @@ shared_ptr<WhileNode> Parser::parseWhileStatement() {
         }
     }
 
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after while condition", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in while statement");
+        fail("Syntax error in while statement");
+        return nullptr;
     }
     consume();
 
     auto block = parseBlock();
-    return make_shared<WhileNode>(condition, block, while_token.line_number, while_token.column_number, hasParentheses);
+    if (failed()) return nullptr;
+    return arena.make<WhileNode>(condition, block, while_token.line_number, while_token.column_number, hasParentheses);
 }
 
-shared_ptr<ForNode> Parser::parseForStatement() {
+ForNode* Parser::parseForStatement() {
     Token for_token = consume(); // Consume 'for'
 
     bool hasParentheses = check(LPAREN);
     if (hasParentheses) consume(); // Consume '('
 
     auto target = parseExpression();
+    if (failed()) return nullptr;
 
-    if (!check(KEYWORD) || peek().lexeme != "in") {
+    if (!check(KEYWORD) || peek().id != LEX_IN) {
         error("Expected 'in' keyword in for loop", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in for statement");
+        fail("Syntax error in for statement");
+        return nullptr;
     }
 
     // Create a terminal node for "in" keyword (we'll handle this in visualization)
-    Token in_token = consume(); // Consume 'in'
+    consume(); // Consume 'in'
 
     auto iterable = parseExpression();
+    if (failed()) return nullptr;
 
     if (hasParentheses) {
         if (!check(RPAREN)) {
@@ -651,76 +805,84 @@ shared_ptr<ForNode> Parser::parseForStatement() {
         }
     }
 
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after for loop header", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in for statement");
+        fail("Syntax error in for statement");
+        return nullptr;
     }
     consume(); // Consume ':'
 
     auto block = parseBlock();
-    return make_shared<ForNode>(target, iterable, block, for_token.line_number, for_token.column_number, hasParentheses);
+    if (failed()) return nullptr;
+    return arena.make<ForNode>(target, iterable, block, for_token.line_number, for_token.column_number, hasParentheses);
 }
 
 
 
-shared_ptr<FunctionDefNode> Parser::parseFunctionDef() {
+FunctionDefNode* Parser::parseFunctionDef() {
     // Create a terminal node for the 'def' keyword
     Token def_token = peek();
-    auto defKeyword = make_shared<TerminalNode>(def_token.lexeme, def_token.line_number, def_token.column_number);
+    auto defKeyword = arena.make<TerminalNode>(arena.copy(def_token.lexeme), def_token.line_number, def_token.column_number);
     consume(); // Consume 'def'
 
     // Check for function name
     if (!check(IDENTIFIER) && !check(FUNCTION_IDENTIFIER)) {
         error("Expected function name after 'def'", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in function definition");
+        fail("Syntax error in function definition");
+        return nullptr;
     }
 
     // Create a terminal node for the function name
     Token nameToken = peek();
-    auto nameNode = make_shared<TerminalNode>(nameToken.lexeme, nameToken.line_number, nameToken.column_number);
-    string name = consume().lexeme;
+    auto nameNode = arena.make<TerminalNode>(arena.copy(nameToken.lexeme), nameToken.line_number, nameToken.column_number);
+    string_view name = arena.copy(consume().lexeme);
 
     // Check for opening parenthesis
     if (!check(LPAREN)) {
         error("Expected '(' after function name", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in function definition");
+        fail("Syntax error in function definition");
+        return nullptr;
     }
 
     // Create a terminal node for the opening parenthesis
     Token openParen = peek();
-    auto openParenNode = make_shared<TerminalNode>(openParen.lexeme, openParen.line_number, openParen.column_number);
+    auto openParenNode = arena.make<TerminalNode>(arena.copy(openParen.lexeme), openParen.line_number, openParen.column_number);
     consume(); // Consume '('
 
     // Parse parameter list
     auto params = parseParameters();
+    if (failed()) return nullptr;
 
     // Check for closing parenthesis
     if (!check(RPAREN)) {
         error("Expected ')' after function parameters", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in function definition");
+        fail("Syntax error in function definition");
+        return nullptr;
     }
 
     // Create a terminal node for the closing parenthesis
     Token closeParen = peek();
-    auto closeParenNode = make_shared<TerminalNode>(closeParen.lexeme, closeParen.line_number, closeParen.column_number);
+    auto closeParenNode = arena.make<TerminalNode>(arena.copy(closeParen.lexeme), closeParen.line_number, closeParen.column_number);
     consume(); // Consume ')'
 
     // Check for colon
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after function parameters", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in function definition");
+        fail("Syntax error in function definition");
+        return nullptr;
     }
 
     // Create a terminal node for the colon
     Token colon = peek();
-    auto colonNode = make_shared<TerminalNode>(colon.lexeme, colon.line_number, colon.column_number);
+    auto colonNode = arena.make<TerminalNode>(arena.copy(colon.lexeme), colon.line_number, colon.column_number);
     consume(); // Consume ':'
 
     // Parse function body
     auto body = parseBlock();
+    if (failed()) return nullptr;
 
     // Create the function definition node with the terminal nodes
-    auto funcDef = make_shared<FunctionDefNode>(name, params, body, def_token.line_number, def_token.column_number);
+    auto funcDef = arena.make<FunctionDefNode>(name, params, body, def_token.line_number, def_token.column_number);
     funcDef->defKeyword = defKeyword;   // Store the 'def' keyword
     funcDef->nameNode = nameNode;       // Store the function name
     funcDef->openParen = openParenNode;
@@ -730,51 +892,58 @@ shared_ptr<FunctionDefNode> Parser::parseFunctionDef() {
     return funcDef;
 }
 
-shared_ptr<ReturnNode> Parser::parseReturnStatement() {
+ReturnNode* Parser::parseReturnStatement() {
     Token return_token = consume(); // Consume 'return'
 
     // Return can be with or without an expression
-    if (peek().type == SYMBOL && peek().lexeme == ":") {
-        return make_shared<ReturnNode>(nullptr, return_token.line_number, return_token.column_number);
+    if (peek().type == SYMBOL && peek().id == LEX_COLON) {
+        return arena.make<ReturnNode>(nullptr, return_token.line_number, return_token.column_number);
     }
 
     auto expr = parseExpression();
-    return make_shared<ReturnNode>(expr, return_token.line_number, return_token.column_number);
+    if (failed()) return nullptr;
+    return arena.make<ReturnNode>(expr, return_token.line_number, return_token.column_number);
 }
 
-shared_ptr<ImportNode> Parser::parseImportStatement() {
+ImportNode* Parser::parseImportStatement() {
     Token import_token = consume(); // Consume 'import'
 
     if (!check(IDENTIFIER)) {
         error("Expected module name after 'import'", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in import statement");
+        fail("Syntax error in import statement");
+        return nullptr;
     }
 
-    string module = consume().lexeme;
-    string alias;
+    string_view module = arena.copy(consume().lexeme);
+    string_view alias;
 
     // Handle "import x as y" syntax
-    if (check(KEYWORD) && peek().lexeme == "as") {
+    if (check(KEYWORD) && peek().id == LEX_AS) {
         consume(); // Consume 'as'
 
         if (!check(IDENTIFIER)) {
             error("Expected alias name after 'as'", peek().line_number, peek().column_number);
-            throw runtime_error("Syntax error in import statement");
+            fail("Syntax error in import statement");
+            return nullptr;
         }
 
-        alias = consume().lexeme;
+        alias = arena.copy(consume().lexeme);
     }
 
-    return make_shared<ImportNode>(module, alias, import_token.line_number, import_token.column_number);
+    return arena.make<ImportNode>(module, alias, import_token.line_number, import_token.column_number);
 }
 
-shared_ptr<BlockNode> Parser::parseBlock() {
-    auto block = make_shared<BlockNode>();
+BlockNode* Parser::parseBlock() {
+    NestingScope scope(*this);
+    if (failed()) return nullptr;
+
+    auto block = arena.make<BlockNode>();
 
     // A block must start with an indent
     if (!match(INDENT)) {
         error("Expected indented block", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in code block");
+        fail("Syntax error in code block");
+        return nullptr;
     }
 
     block->statements = parseStatementList();
@@ -787,149 +956,142 @@ shared_ptr<BlockNode> Parser::parseBlock() {
     return block;
 }
 
-shared_ptr<ASTNode> Parser::parseExpression() {
-    return parseOrExpr();
-}
-
-shared_ptr<ASTNode> Parser::parseOrExpr() {
-    auto left = parseAndExpr();
-
-    while (check(KEYWORD) && peek().lexeme == "or") {
-        Token op = consume();
-        auto right = parseAndExpr();
-        left = make_shared<BinaryExprNode>("or", left, right, op.line_number, op.column_number);
-    }
-
-    return left;
-}
-
-shared_ptr<ASTNode> Parser::parseAndExpr() {
-    auto left = parseNotExpr();
-
-    while (check(KEYWORD) && peek().lexeme == "and") {
-        Token op = consume();
-        auto right = parseNotExpr();
-        left = make_shared<BinaryExprNode>("and", left, right, op.line_number, op.column_number);
-    }
-
-    return left;
-}
-
-shared_ptr<ASTNode> Parser::parseNotExpr() {
-    // Special handling for 'not' keyword
-    if (check(KEYWORD) && peek().lexeme == "not") {
+// Binding powers for parseBinary, loosest first.
+enum Precedence : uint8_t {
+    PREC_NONE = 0,
+    PREC_OR,
+    PREC_AND,
+    PREC_NOT,
+    PREC_COMPARISON,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE,
+    PREC_POWER,
+};
+
+struct BinaryOperator {
+    uint8_t precedence = PREC_NONE;
+    TokenType type = OPERATOR;   // 'and'/'or' are keywords
+};
+
+// Binary operators by lexeme ID; everything else has PREC_NONE.
+static constexpr array<BinaryOperator, LEX_FIRST_DYNAMIC> binary_operators = [] {
+    array<BinaryOperator, LEX_FIRST_DYNAMIC> table{};
+    table[LEX_OR] = {PREC_OR, KEYWORD};
+    table[LEX_AND] = {PREC_AND, KEYWORD};
+    table[LEX_EQ] = {PREC_COMPARISON, OPERATOR};
+    table[LEX_NE] = {PREC_COMPARISON, OPERATOR};
+    table[LEX_LT] = {PREC_COMPARISON, OPERATOR};
+    table[LEX_GT] = {PREC_COMPARISON, OPERATOR};
+    table[LEX_LE] = {PREC_COMPARISON, OPERATOR};
+    table[LEX_GE] = {PREC_COMPARISON, OPERATOR};
+    table[LEX_PLUS] = {PREC_ADDITIVE, OPERATOR};
+    table[LEX_MINUS] = {PREC_ADDITIVE, OPERATOR};
+    table[LEX_STAR] = {PREC_MULTIPLICATIVE, OPERATOR};
+    table[LEX_SLASH] = {PREC_MULTIPLICATIVE, OPERATOR};
+    table[LEX_PERCENT] = {PREC_MULTIPLICATIVE, OPERATOR};
+    table[LEX_POWER] = {PREC_POWER, OPERATOR};
+    return table;
+}();
+
+ASTNode* Parser::parseExpression() {
+    return parseBinary(PREC_OR);
+}
+
+// Precedence climbing over binary_operators: consumes the operators that
+// bind at least as tightly as min_precedence and leaves the looser ones to
+// the caller. Trees come out as the old one-method-per-level descent built
+// them: left-associative except for '**', a comparison is wrapped in a
+// ComparisonExprNode and does not chain, and 'not' applies to a whole
+// comparison.
+ASTNode* Parser::parseBinary(int min_precedence) {
+    NestingScope scope(*this);
+    if (failed()) return nullptr;
+
+    ASTNode* left;
+    // Tightest operator that may still follow `left`. Once it is a 'not'
+    // expression or a comparison, only 'and'/'or' can continue it; after
+    // any other operator, only operators of the same or looser precedence.
+    int max_precedence = PREC_POWER;
+
+    if (min_precedence <= PREC_NOT && check(KEYWORD) && peek().id == LEX_NOT) {
         Token op = consume(); // Consume 'not'
-
-        // DEBUG
-        // cout << "Processing NOT operator at line " << op.line_number << ", column " << op.column_number << endl;
-
-        // Parse the expression that follows the 'not'
-        auto operand = parseComparisonExpr();
-
-        return make_shared<UnaryExprNode>("not", operand, op.line_number, op.column_number);
-    }
-
-    return parseComparisonExpr();
-}
-
-shared_ptr<ASTNode> Parser::parseComparisonExpr() {
-    auto left = parseArithmeticExpr();
-
-    // Handle comparison operators: ==, !=, <, >, <=, >=
-    if (check(OPERATOR) && (
-        peek().lexeme == "==" || peek().lexeme == "!=" ||
-        peek().lexeme == "<" || peek().lexeme == ">" ||
-        peek().lexeme == "<=" || peek().lexeme == ">=")) {
-
-        Token op = consume();
-        auto right = parseArithmeticExpr();
-        // left = make_shared<BinaryExprNode>(op.lexeme, left, right, op.line_number, op.column_number);
-        // Create a BinaryExprNode first
-        auto binary = make_shared<BinaryExprNode>(op.lexeme, left, right, op.line_number, op.column_number);
-
-        // Wrap it in a ComparisonExprNode
-        return make_shared<ComparisonExprNode>(binary);
-    }
-
-    return left;
-}
-
-shared_ptr<ASTNode> Parser::parseArithmeticExpr() {
-    auto left = parseTerm();
-
-    // Handle addition and subtraction
-    while (check(OPERATOR) && (peek().lexeme == "+" || peek().lexeme == "-")) {
-        Token op = consume();
-        auto right = parseTerm();
-        left = make_shared<BinaryExprNode>(op.lexeme, left, right, op.line_number, op.column_number);
-    }
-
-    return left;
-}
-
-shared_ptr<ASTNode> Parser::parseTerm() {
-    auto left = parseFactor();
-
-    // Handle multiplication, division, and modulo
-    while (check(OPERATOR) && (
-        peek().lexeme == "*" || peek().lexeme == "/" || peek().lexeme == "%")) {
-
-        Token op = consume();
-        auto right = parseFactor();
-        left = make_shared<BinaryExprNode>(op.lexeme, left, right, op.line_number, op.column_number);
+        auto operand = parseBinary(PREC_COMPARISON);
+        if (failed()) return nullptr;
+        left = arena.make<UnaryExprNode>(LEX_NOT, operand, op.line_number, op.column_number);
+        max_precedence = PREC_AND;
+    } else {
+        left = parseUnary();
+        if (failed()) return nullptr;
     }
 
-    return left;
-}
-
-shared_ptr<ASTNode> Parser::parseFactor() {
-    auto left = parsePower();
+    while (peek().id < LEX_FIRST_DYNAMIC) {
+        const BinaryOperator& info = binary_operators[peek().id];
+        if (info.precedence < min_precedence || info.precedence > max_precedence ||
+            peek().type != info.type) {
+            break;
+        }
 
-    // Handle exponentiation
-    if (check(OPERATOR) && peek().lexeme == "**") {
         Token op = consume();
-        auto right = parseFactor(); // Exponentiation is right-associative
-        left = make_shared<BinaryExprNode>(op.lexeme, left, right, op.line_number, op.column_number);
+        if (info.precedence == PREC_COMPARISON) {
+            auto right = parseBinary(PREC_ADDITIVE);
+            if (failed()) return nullptr;
+            auto binary = arena.make<BinaryExprNode>(static_cast<OpCode>(op.id), left, right, op.line_number, op.column_number);
+            left = arena.make<ComparisonExprNode>(binary);
+            max_precedence = PREC_AND;
+        } else {
+            // '**' is right-associative, the rest are left-associative
+            int right_precedence = info.precedence == PREC_POWER ? PREC_POWER : info.precedence + 1;
+            auto right = parseBinary(right_precedence);
+            if (failed()) return nullptr;
+            left = arena.make<BinaryExprNode>(static_cast<OpCode>(op.id), left, right, op.line_number, op.column_number);
+            // Anything tighter was refused by the right operand, so it may
+            // not continue here either
+            max_precedence = info.precedence;
+        }
     }
 
     return left;
 }
 
-shared_ptr<ASTNode> Parser::parsePower() {
-    return parseUnary();
-}
-
-
-shared_ptr<ASTNode> Parser::parseUnary() {
+ASTNode* Parser::parseUnary() {
     // Handle unary operators: +, -
-    if (check(OPERATOR) && (peek().lexeme == "+" || peek().lexeme == "-")) {
+    if (check(OPERATOR) && (peek().id == LEX_PLUS || peek().id == LEX_MINUS)) {
         Token op = consume();
 
         // NEW: Check if the next token is also a unary operator
-        if (check(OPERATOR) && (peek().lexeme == "+" || peek().lexeme == "-")) {
+        if (check(OPERATOR) && (peek().id == LEX_PLUS || peek().id == LEX_MINUS)) {
             // This is an error - adjacent unary operators without parentheses
             error("Invalid syntax: adjacent unary operators are not allowed without parentheses",
                   peek().line_number, peek().column_number);
-            throw runtime_error("Syntax error in expression");
+            fail("Syntax error in expression");
+            return nullptr;
         }
 
         auto operand = parseUnary();
-        return make_shared<UnaryExprNode>(op.lexeme, operand, op.line_number, op.column_number);
+        if (failed()) return nullptr;
+        return arena.make<UnaryExprNode>(static_cast<OpCode>(op.id), operand, op.line_number, op.column_number);
     }
 
     return parsePrimary();
 }
-//remove these two functions later
-void Parser::debugToken(const string& context) {
+bool Parser::setTraceFile(const string& path) {
+    trace_file.close();
+    if (!path.empty()) {
+        trace_file.open(path);
+    }
+    return trace_file.is_open();
+}
+
+void Parser::debugToken(const char* context) {
     if (isAtEnd()) {
-        cout << context << ": At end of token stream" << endl;
+        trace_file << context << ": At end of token stream\n";
         return;
     }
 
-    cout << context << ": Token = " << peek().lexeme
-              << ", Type = " << tokenTypeToString(peek().type)
-              << ", Line " << peek().line_number
-              << ", Column " << peek().column_number << endl;
+    trace_file << context << ": Token = " << peek().lexeme
+               << ", Type = " << tokenTypeToString(peek().type)
+               << ", Line " << peek().line_number
+               << ", Column " << peek().column_number << '\n';
 }
 
 string Parser::tokenTypeToString(TokenType type) {
@@ -945,28 +1107,28 @@ string Parser::tokenTypeToString(TokenType type) {
 }
 
 
-shared_ptr<ASTNode> Parser::parsePrimary() {
+ASTNode* Parser::parsePrimary() {
     // Debug at the start to see what token we're starting with
-    debugToken("parsePrimary start");
+    traceToken<TRACE_PRIMARY>("parsePrimary start");
 
     // Skip any INDENT/DEDENT tokens that appear in expressions
     while (check(INDENT) || check(DEDENT)) {
-        cout << "Skipping INDENT/DEDENT in primary expression" << endl;
+        trace<TRACE_LAYOUT>("Skipping INDENT/DEDENT in primary expression");
         consume();
     }
 
     // Check for dictionary literals
     if (check(LBRACE)) {
-        debugToken("Found LBRACE, about to parse dictionary");
+        traceToken<TRACE_PRIMARY>("Found LBRACE, about to parse dictionary");
         return parseDictLiteral();
     }
 
     // Debug before checking for identifiers
-    debugToken("Checking for identifier");
+    traceToken<TRACE_PRIMARY>("Checking for identifier");
     // Handle identifiers
     if (check(IDENTIFIER) || check(FUNCTION_IDENTIFIER)) {
         Token id = consume();
-        auto node = make_shared<IdentifierNode>(id.lexeme, id.line_number, id.column_number);
+        auto node = arena.make<IdentifierNode>(arena.copy(id.lexeme), id.line_number, id.column_number);
 
         // Handle function calls: func()
         if (check(LPAREN)) {
@@ -975,13 +1137,14 @@ shared_ptr<ASTNode> Parser::parsePrimary() {
 
         // NEW: Check for built-in functions that should be called with parentheses
         if (isBuiltInFunction(id.lexeme) && (check(STRING) || check(IDENTIFIER) || check(NUMERIC))) {
-            error("Missing parentheses in call to '" + id.lexeme + "'",
+            error("Missing parentheses in call to '" + id.text() + "'",
                   peek().line_number, peek().column_number);
-            throw runtime_error("Syntax error in function call");
+            fail("Syntax error in function call");
+            return nullptr;
         }
 
         // Handle attribute access: obj.attr
-        if (check(OPERATOR) && peek().lexeme == ".") {
+        if (check(OPERATOR) && peek().id == LEX_DOT) {
             return parseAttributeReference(node);
         }
 
@@ -994,26 +1157,26 @@ shared_ptr<ASTNode> Parser::parsePrimary() {
     }
 
     // Debug before checking for literals
-    debugToken("Checking for literals");
+    traceToken<TRACE_PRIMARY>("Checking for literals");
 
     // Handle literals: numbers
     if (check(NUMERIC)) {
         Token num = consume();
-        string type = num.lexeme.find('.') != string::npos ? "float" : "int";
-        return make_shared<LiteralNode>(num.lexeme, type, num.line_number, num.column_number);
+        string_view type = num.lexeme.find('.') != string::npos ? "float" : "int";
+        return arena.make<LiteralNode>(arena.copy(num.lexeme), type, num.line_number, num.column_number);
     }
 
     // Handle literals: strings
     if (check(STRING)) {
         Token str = consume();
-        return make_shared<LiteralNode>(str.lexeme, "string", str.line_number, str.column_number);
+        return arena.make<LiteralNode>(arena.copy(str.lexeme), "string", str.line_number, str.column_number);
     }
 
     // Handle literals: booleans and None
     if (check(DATA_TYPE)) {
         Token data = consume();
-        string type = (data.lexeme == "True" || data.lexeme == "False") ? "bool" : "None";
-        return make_shared<LiteralNode>(data.lexeme, type, data.line_number, data.column_number);
+        string_view type = (data.id == LEX_TRUE || data.id == LEX_FALSE) ? "bool" : "None";
+        return arena.make<LiteralNode>(arena.copy(data.lexeme), type, data.line_number, data.column_number);
     }
 
     // Handle parenthesized expressions
@@ -1021,15 +1184,17 @@ shared_ptr<ASTNode> Parser::parsePrimary() {
         Token openParen = consume(); // Consume '('
 
         auto expr = parseExpression();
+        if (failed()) return nullptr;
 
         if (!check(RPAREN)) {
             error("Expected ')' after expression", peek().line_number, peek().column_number);
-            throw runtime_error("Syntax error in parenthesized expression");
+            fail("Syntax error in parenthesized expression");
+            return nullptr;
         }
-        Token closeParen = consume(); // Consume ')'
+        consume(); // Consume ')'
 
         // Create a GroupExprNode to represent the parenthesized expression
-        return make_shared<GroupExprNode>(expr, openParen.line_number, openParen.column_number);
+        return arena.make<GroupExprNode>(expr, openParen.line_number, openParen.column_number);
     }
 
     // Handle list literals
@@ -1038,99 +1203,114 @@ shared_ptr<ASTNode> Parser::parsePrimary() {
     }
 
     // Add final debug before error
-    debugToken("No valid expression found");
+    traceToken<TRACE_PRIMARY>("No valid expression found");
 
     error("Expected expression", peek().line_number, peek().column_number);
-    throw runtime_error("Unexpected token in expression");
+    fail("Unexpected token in expression");
+    return nullptr;
 }
 
-shared_ptr<ASTNode> Parser::parseAttributeReference(shared_ptr<ASTNode> object) {
-    consume(); // Consume '.'
+ASTNode* Parser::parseAttributeReference(ASTNode* object) {
+    // Chained attribute access (obj.attr1.attr2) loops rather than recursing
+    while (true) {
+        consume(); // Consume '.'
+
+        // Be more flexible with what we accept as an attribute name
+        // Check for both IDENTIFIER and FUNCTION_IDENTIFIER
+        if (!check(IDENTIFIER) && !check(FUNCTION_IDENTIFIER)) {
+            error("Expected attribute name after '.'", peek().line_number, peek().column_number);
+            fail("Syntax error in attribute reference");
+            return nullptr;
+        }
 
-    // Be more flexible with what we accept as an attribute name
-    // Check for both IDENTIFIER and FUNCTION_IDENTIFIER
-    if (!check(IDENTIFIER) && !check(FUNCTION_IDENTIFIER)) {
-        error("Expected attribute name after '.'", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in attribute reference");
-    }
+        Token attr = consume();
+        auto attr_ref = arena.make<AttrRefNode>(object, arena.copy(attr.lexeme), attr.line_number, attr.column_number);
 
-    Token attr = consume();
-    auto attr_ref = make_shared<AttrRefNode>(object, attr.lexeme, attr.line_number, attr.column_number);
+        if (check(OPERATOR) && peek().id == LEX_DOT) {
+            object = attr_ref;
+            continue;
+        }
 
-    // Handle chained attribute access: obj.attr1.attr2
-    if (check(OPERATOR) && peek().lexeme == ".") {
-        return parseAttributeReference(attr_ref);
-    }
+        // Handle method calls: obj.method()
+        if (check(LPAREN)) {
+            return parseCall(attr_ref);
+        }
 
-    // Handle method calls: obj.method()
-    if (check(LPAREN)) {
-        return parseCall(attr_ref);
+        return attr_ref;
     }
-
-    return attr_ref;
 }
 
-shared_ptr<ASTNode> Parser::parseSubscript(shared_ptr<ASTNode> container) {
-    Token bracket = consume(); // Consume '['
+ASTNode* Parser::parseSubscript(ASTNode* container) {
+    // Chained subscripts (list[i][j]) loop rather than recursing
+    while (true) {
+        Token bracket = consume(); // Consume '['
 
-    auto index = parseExpression();
+        auto index = parseExpression();
+        if (failed()) return nullptr;
 
-    if (!match(RBRACKET)) {
-        error("Expected ']' after subscript index", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in subscript expression");
-    }
+        if (!match(RBRACKET)) {
+            error("Expected ']' after subscript index", peek().line_number, peek().column_number);
+            fail("Syntax error in subscript expression");
+            return nullptr;
+        }
 
-    auto subscript = make_shared<SubscriptExprNode>(container, index, bracket.line_number, bracket.column_number);
+        auto subscript = arena.make<SubscriptExprNode>(container, index, bracket.line_number, bracket.column_number);
 
-    // Handle chained subscripts: list[i][j]
-    if (check(LBRACKET)) {
-        return parseSubscript(subscript);
-    }
+        if (check(LBRACKET)) {
+            container = subscript;
+            continue;
+        }
 
-    // Handle attribute access after subscript: list[i].append
-    if (check(OPERATOR) && peek().lexeme == ".") {
-        return parseAttributeReference(subscript);
-    }
+        // Handle attribute access after subscript: list[i].append
+        if (check(OPERATOR) && peek().id == LEX_DOT) {
+            return parseAttributeReference(subscript);
+        }
 
-    return subscript;
+        return subscript;
+    }
 }
 
 
-shared_ptr<ASTNode> Parser::parseCall(shared_ptr<ASTNode> function) {
+ASTNode* Parser::parseCall(ASTNode* function) {
     // Create a terminal node for the opening parenthesis
     Token openParen = consume(); // Consume '('
-    auto openParenNode = make_shared<TerminalNode>(openParen.lexeme, openParen.line_number, openParen.column_number);
+    auto openParenNode = arena.make<TerminalNode>(arena.copy(openParen.lexeme), openParen.line_number, openParen.column_number);
 
     // Parse arguments (without including the parentheses)
-    auto args = make_shared<ArgListNode>();
+    auto args = arena.make<ArgListNode>();
+    vector<ASTNode*> arguments;
 
     if (!check(RPAREN)) {
         // Parse the arguments
-        args->arguments.push_back(parseExpression());
+        arguments.push_back(parseExpression());
+        if (failed()) return nullptr;
 
         // Parse additional arguments if there are commas
-        while (check(SYMBOL) && peek().lexeme == ",") {
+        while (check(SYMBOL) && peek().id == LEX_COMMA) {
             // Create a terminal node for the comma
             Token comma = consume(); // Consume the comma
-            auto commaNode = make_shared<TerminalNode>(comma.lexeme, comma.line_number, comma.column_number);
-            args->arguments.push_back(commaNode);
+            auto commaNode = arena.make<TerminalNode>(arena.copy(comma.lexeme), comma.line_number, comma.column_number);
+            arguments.push_back(commaNode);
 
-            args->arguments.push_back(parseExpression());
+            arguments.push_back(parseExpression());
+            if (failed()) return nullptr;
         }
     }
+    args->arguments = arena.list(arguments);
 
     // Check for the closing parenthesis
     if (!check(RPAREN)) {
         error("Expected ')' after function arguments", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in function call");
+        fail("Syntax error in function call");
+        return nullptr;
     }
 
     // Create a terminal node for the closing parenthesis
     Token closeParen = consume(); // Consume ')'
-    auto closeParenNode = make_shared<TerminalNode>(closeParen.lexeme, closeParen.line_number, closeParen.column_number);
+    auto closeParenNode = arena.make<TerminalNode>(arena.copy(closeParen.lexeme), closeParen.line_number, closeParen.column_number);
 
     // Create the call node with function, args, and both parentheses nodes
-    auto call = make_shared<CallExprNode>(function, args, openParen.line_number, openParen.column_number);
+    auto call = arena.make<CallExprNode>(function, args, openParen.line_number, openParen.column_number);
 
     // Add the call node structure information to allow proper visualization
     call->openParen = openParenNode;
@@ -1140,81 +1320,86 @@ shared_ptr<ASTNode> Parser::parseCall(shared_ptr<ASTNode> function) {
 }
 
 
-shared_ptr<ArgListNode> Parser::parseArguments() {
-    auto arg_list = make_shared<ArgListNode>();
+ArgListNode* Parser::parseArguments() {
+    auto arg_list = arena.make<ArgListNode>();
+    vector<ASTNode*> arguments;
 
     // If not immediately at closing parenthesis, parse arguments
     if (!check(RPAREN)) {
         // Parse first argument
-        arg_list->arguments.push_back(parseExpression());
+        arguments.push_back(parseExpression());
+        if (failed()) return nullptr;
 
         // Parse remaining arguments
-        while (check(SYMBOL) && peek().lexeme == ",") {
+        while (check(SYMBOL) && peek().id == LEX_COMMA) {
             consume(); // Explicitly consume the comma
-            arg_list->arguments.push_back(parseExpression());
+            arguments.push_back(parseExpression());
+            if (failed()) return nullptr;
         }
     }
 
+    arg_list->arguments = arena.list(arguments);
     return arg_list;
 }
 
 
-shared_ptr<ParamListNode> Parser::parseParameters() {
-    auto param_list = make_shared<ParamListNode>();
+ParamListNode* Parser::parseParameters() {
+    auto param_list = arena.make<ParamListNode>();
+    vector<ParameterNode*> parameters;
 
     // If we're not immediately at the closing parenthesis, then parse parameters
     if (!check(RPAREN)) {
         // Parse first parameter
         if (!check(IDENTIFIER)) {
             error("Expected parameter name", peek().line_number, peek().column_number);
-            throw runtime_error("Syntax error in parameter list");
+            fail("Syntax error in parameter list");
+            return nullptr;
         }
 
         // Get parameter name
         Token param_token = consume();
-        shared_ptr<ASTNode> default_value = nullptr;
+        ASTNode* default_value = nullptr;
 
         // Check for default value (=)
-        if (check(OPERATOR) && peek().lexeme == "=") {
+        if (check(OPERATOR) && peek().id == LEX_ASSIGN) {
             // Create a terminal node for the equals sign
             Token equals = consume(); // Consume the equals sign
-            auto equalsNode = make_shared<TerminalNode>(equals.lexeme, equals.line_number, equals.column_number);
+            auto equalsNode = arena.make<TerminalNode>(arena.copy(equals.lexeme), equals.line_number, equals.column_number);
 
             // Parse and store the default value expression
             default_value = parseExpression();
+            if (failed()) return nullptr;
 
             // Create a statement list to hold the equals and the default value
-            auto defaultContainer = make_shared<StatementListNode>();
-            defaultContainer->statements.push_back(equalsNode);
-            defaultContainer->statements.push_back(default_value);
+            auto defaultContainer = arena.make<StatementListNode>();
+            defaultContainer->statements = arena.list(vector<ASTNode*>{equalsNode, default_value});
             default_value = defaultContainer;
         }
 
         // Create a ParameterNode for the parameter
-        auto param = make_shared<ParameterNode>(
-            param_token.lexeme,
+        auto param = arena.make<ParameterNode>(
+            arena.copy(param_token.lexeme),
             default_value,
             param_token.line_number,
             param_token.column_number
         );
 
-        param_list->parameters.push_back(param);
+        parameters.push_back(param);
 
         // Parse remaining parameters
-        while (check(SYMBOL) && peek().lexeme == ",") {
-            // Create a terminal node for the comma
+        while (check(SYMBOL) && peek().id == LEX_COMMA) {
             Token comma = consume(); // Explicitly consume the comma
-            auto commaNode = make_shared<TerminalNode>(comma.lexeme, comma.line_number, comma.column_number);
 
             // Store the comma as a parameter with empty name
-            auto commaParam = make_shared<ParameterNode>(
+            auto commaParam = arena.make<ParameterNode>(
                 ",", nullptr, comma.line_number, comma.column_number
             );
-            param_list->parameters.push_back(commaParam);
+            parameters.push_back(commaParam);
 
             if (!check(IDENTIFIER)) {
                 error("Expected parameter name after comma", peek().line_number, peek().column_number);
-                throw runtime_error("Syntax error in parameter list");
+                fail("Syntax error in parameter list");
+                return nullptr;
             }
 
             // Get parameter name
@@ -1222,46 +1407,48 @@ shared_ptr<ParamListNode> Parser::parseParameters() {
             default_value = nullptr;
 
             // Check for default value (=)
-            if (check(OPERATOR) && peek().lexeme == "=") {
+            if (check(OPERATOR) && peek().id == LEX_ASSIGN) {
                 // Create a terminal node for the equals sign
                 Token equals = consume(); // Consume the equals sign
-                auto equalsNode = make_shared<TerminalNode>(equals.lexeme, equals.line_number, equals.column_number);
+                auto equalsNode = arena.make<TerminalNode>(arena.copy(equals.lexeme), equals.line_number, equals.column_number);
 
                 // Parse and store the default value expression
                 default_value = parseExpression();
+                if (failed()) return nullptr;
 
                 // Create a statement list to hold the equals and the default value
-                auto defaultContainer = make_shared<StatementListNode>();
-                defaultContainer->statements.push_back(equalsNode);
-                defaultContainer->statements.push_back(default_value);
+                auto defaultContainer = arena.make<StatementListNode>();
+                defaultContainer->statements = arena.list(vector<ASTNode*>{equalsNode, default_value});
                 default_value = defaultContainer;
             }
 
             // Create a ParameterNode for each parameter
-            auto param = make_shared<ParameterNode>(
-                param_token.lexeme,
+            auto param = arena.make<ParameterNode>(
+                arena.copy(param_token.lexeme),
                 default_value,
                 param_token.line_number,
                 param_token.column_number
             );
 
-            param_list->parameters.push_back(param);
+            parameters.push_back(param);
         }
     }
 
+    param_list->parameters = arena.list(parameters);
     return param_list;
 }
 
 
-shared_ptr<ListNode> Parser::parseListLiteral() {
+ListNode* Parser::parseListLiteral() {
     // Create a terminal node for the opening bracket
     Token openBracket = consume(); // Consume '['
-    auto openBracketNode = make_shared<TerminalNode>(openBracket.lexeme, openBracket.line_number, openBracket.column_number);
+    auto openBracketNode = arena.make<TerminalNode>(arena.copy(openBracket.lexeme), openBracket.line_number, openBracket.column_number);
 
-    auto list = make_shared<ListNode>(openBracket.line_number, openBracket.column_number);
+    auto list = arena.make<ListNode>(openBracket.line_number, openBracket.column_number);
+    vector<ASTNode*> elements;
 
     // Add the opening bracket to the list
-    list->elements.push_back(openBracketNode);
+    elements.push_back(openBracketNode);
 
     // Skip any INDENT tokens within the list
     while (check(INDENT)) {
@@ -1270,7 +1457,8 @@ shared_ptr<ListNode> Parser::parseListLiteral() {
 
     if (!check(RBRACKET)) {
         // Parse first element
-        list->elements.push_back(parseExpression());
+        elements.push_back(parseExpression());
+        if (failed()) return nullptr;
 
         // Parse remaining elements
         while (true) {
@@ -1279,11 +1467,11 @@ shared_ptr<ListNode> Parser::parseListLiteral() {
                 consume();
             }
 
-            if (check(SYMBOL) && peek().lexeme == ",") {
+            if (check(SYMBOL) && peek().id == LEX_COMMA) {
                 // Create a terminal node for the comma
                 Token comma = consume(); // Consume the comma
-                auto commaNode = make_shared<TerminalNode>(comma.lexeme, comma.line_number, comma.column_number);
-                list->elements.push_back(commaNode);
+                auto commaNode = arena.make<TerminalNode>(arena.copy(comma.lexeme), comma.line_number, comma.column_number);
+                elements.push_back(commaNode);
 
                 // Skip any INDENT/DEDENT tokens after comma
                 while (check(INDENT) || check(DEDENT)) {
@@ -1295,47 +1483,52 @@ shared_ptr<ListNode> Parser::parseListLiteral() {
                     break;
                 }
 
-                list->elements.push_back(parseExpression());
+                elements.push_back(parseExpression());
+                if (failed()) return nullptr;
             } else if (check(RBRACKET)) {
                 break; // End of list
             } else {
                 error("Expected ',' or ']' after list element", peek().line_number, peek().column_number);
-                throw runtime_error("Syntax error in list literal");
+                fail("Syntax error in list literal");
+                return nullptr;
             }
         }
     }
 
     if (!check(RBRACKET)) {
         error("Expected ']' after list elements", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in list literal");
+        fail("Syntax error in list literal");
+        return nullptr;
     }
 
     // Create a terminal node for the closing bracket
     Token closeBracket = consume(); // Consume the closing bracket
-    auto closeBracketNode = make_shared<TerminalNode>(closeBracket.lexeme, closeBracket.line_number, closeBracket.column_number);
-    list->elements.push_back(closeBracketNode);
+    auto closeBracketNode = arena.make<TerminalNode>(arena.copy(closeBracket.lexeme), closeBracket.line_number, closeBracket.column_number);
+    elements.push_back(closeBracketNode);
 
+    list->elements = arena.list(elements);
     return list;
 }
 
 
-shared_ptr<DictNode> Parser::parseDictLiteral() {
-    cout << "Entering parseDictLiteral with token: " << peek().lexeme
-              << " at line " << peek().line_number
-              << ", column " << peek().column_number << endl;
+DictNode* Parser::parseDictLiteral() {
+    trace<TRACE_PRIMARY>("Entering parseDictLiteral with token: ", peek().lexeme,
+                         " at line ", peek().line_number,
+                         ", column ", peek().column_number);
 
     // Create a terminal node for the opening brace
     Token openBrace = consume(); // Consume '{'
-    auto openBraceNode = make_shared<TerminalNode>(openBrace.lexeme, openBrace.line_number, openBrace.column_number);
+    auto openBraceNode = arena.make<TerminalNode>(arena.copy(openBrace.lexeme), openBrace.line_number, openBrace.column_number);
 
-    auto dict = make_shared<DictNode>(openBrace.line_number, openBrace.column_number);
+    auto dict = arena.make<DictNode>(openBrace.line_number, openBrace.column_number);
+    vector<pair<ASTNode*, ASTNode*>> items;
 
     // Store opening brace as the first item (key with null value)
-    dict->items.emplace_back(openBraceNode, nullptr);
+    items.emplace_back(openBraceNode, nullptr);
 
     // Skip any INDENT tokens that appear within the dictionary
     while (check(INDENT)) {
-        cout << "Skipping INDENT in dictionary" << endl;
+        trace<TRACE_LAYOUT>("Skipping INDENT in dictionary");
         consume(); // Skip the INDENT token
     }
 
@@ -1343,55 +1536,59 @@ shared_ptr<DictNode> Parser::parseDictLiteral() {
     if (check(RBRACE)) {
         // Create a terminal node for the closing brace
         Token closeBrace = consume(); // Consume the closing brace
-        auto closeBraceNode = make_shared<TerminalNode>(closeBrace.lexeme, closeBrace.line_number, closeBrace.column_number);
+        auto closeBraceNode = arena.make<TerminalNode>(arena.copy(closeBrace.lexeme), closeBrace.line_number, closeBrace.column_number);
 
         // Store closing brace (null key with value)
-        dict->items.emplace_back(nullptr, closeBraceNode);
+        items.emplace_back(nullptr, closeBraceNode);
+        dict->items = arena.list(items);
         return dict;
     }
 
     // Parse first key-value pair
     auto key = parseExpression();
+    if (failed()) return nullptr;
 
     // Skip any DEDENT tokens that might appear between key and colon
     while (check(DEDENT)) {
-        cout << "Skipping DEDENT after key" << endl;
+        trace<TRACE_LAYOUT>("Skipping DEDENT after key");
         consume();
     }
 
-    if (!check(SYMBOL) || peek().lexeme != ":") {
+    if (!check(SYMBOL) || peek().id != LEX_COLON) {
         error("Expected ':' after dictionary key", peek().line_number, peek().column_number);
-        throw runtime_error("Syntax error in dictionary literal");
+        fail("Syntax error in dictionary literal");
+        return nullptr;
     }
 
     // Create a terminal node for the colon
     Token colon = consume(); // Consume the colon
-    auto colonNode = make_shared<TerminalNode>(colon.lexeme, colon.line_number, colon.column_number);
+    auto colonNode = arena.make<TerminalNode>(arena.copy(colon.lexeme), colon.line_number, colon.column_number);
 
     // Store the key:colon pair
-    dict->items.emplace_back(key, colonNode);
+    items.emplace_back(key, colonNode);
 
     auto value = parseExpression();
-    dict->items.emplace_back(nullptr, value);
+    if (failed()) return nullptr;
+    items.emplace_back(nullptr, value);
 
     // Parse remaining key-value pairs
     while (true) {
         // Skip any INDENT/DEDENT tokens between items
         while (check(INDENT) || check(DEDENT)) {
-            cout << "Skipping INDENT/DEDENT between dict items" << endl;
+            trace<TRACE_LAYOUT>("Skipping INDENT/DEDENT between dict items");
             consume();
         }
 
         // Check for comma to continue or closing brace to end
-        if (check(SYMBOL) && peek().lexeme == ",") {
+        if (check(SYMBOL) && peek().id == LEX_COMMA) {
             // Create a terminal node for the comma
             Token comma = consume(); // Consume the comma
-            auto commaNode = make_shared<TerminalNode>(comma.lexeme, comma.line_number, comma.column_number);
-            dict->items.emplace_back(nullptr, commaNode);
+            auto commaNode = arena.make<TerminalNode>(arena.copy(comma.lexeme), comma.line_number, comma.column_number);
+            items.emplace_back(nullptr, commaNode);
 
             // Skip any INDENT/DEDENT that might follow the comma
             while (check(INDENT) || check(DEDENT)) {
-                cout << "Skipping INDENT/DEDENT after comma" << endl;
+                trace<TRACE_LAYOUT>("Skipping INDENT/DEDENT after comma");
                 consume();
             }
 
@@ -1401,58 +1598,63 @@ shared_ptr<DictNode> Parser::parseDictLiteral() {
             }
 
             key = parseExpression();
+            if (failed()) return nullptr;
 
             // Skip any INDENT/DEDENT between key and colon
             while (check(INDENT) || check(DEDENT)) {
-                cout << "Skipping INDENT/DEDENT between key and colon" << endl;
+                trace<TRACE_LAYOUT>("Skipping INDENT/DEDENT between key and colon");
                 consume();
             }
 
-            if (!check(SYMBOL) || peek().lexeme != ":") {
+            if (!check(SYMBOL) || peek().id != LEX_COLON) {
                 error("Expected ':' after dictionary key", peek().line_number, peek().column_number);
-                throw runtime_error("Syntax error in dictionary literal");
+                fail("Syntax error in dictionary literal");
+                return nullptr;
             }
 
             // Create a terminal node for the colon
             Token colon = consume(); // Consume the colon
-            auto colonNode = make_shared<TerminalNode>(colon.lexeme, colon.line_number, colon.column_number);
+            auto colonNode = arena.make<TerminalNode>(arena.copy(colon.lexeme), colon.line_number, colon.column_number);
 
             // Store the key:colon pair
-            dict->items.emplace_back(key, colonNode);
+            items.emplace_back(key, colonNode);
 
             value = parseExpression();
-            dict->items.emplace_back(nullptr, value);
+            if (failed()) return nullptr;
+            items.emplace_back(nullptr, value);
         } else if (check(RBRACE)) {
             break; // End of dictionary
         } else {
             error("Expected ',' or '}' after dictionary item", peek().line_number, peek().column_number);
-            throw runtime_error("Syntax error in dictionary literal");
+            fail("Syntax error in dictionary literal");
+            return nullptr;
         }
     }
 
     // Create a terminal node for the closing brace
     Token closeBrace = consume(); // Consume the closing brace
-    auto closeBraceNode = make_shared<TerminalNode>(closeBrace.lexeme, closeBrace.line_number, closeBrace.column_number);
-    dict->items.emplace_back(nullptr, closeBraceNode);
+    auto closeBraceNode = arena.make<TerminalNode>(arena.copy(closeBrace.lexeme), closeBrace.line_number, closeBrace.column_number);
+    items.emplace_back(nullptr, closeBraceNode);
 
+    dict->items = arena.list(items);
     return dict;
 }
 
-void Parser::printParseTree(shared_ptr<ASTNode> root, int indent) {
-    cout << root->toString(indent);
+void Parser::printParseTree(const ASTNode* root, int indent) {
+    ASTPrinter(cout).print(root, indent);
 }
 
 void Parser::printErrors() {
     if (!errors.empty()) {
         cout << "\n--- Parse Errors ---\n";
         for (const auto& error : errors) {
-            cout << error << endl;
+            cout << error.text() << endl;
         }
         cout << "Total errors: " << errors.size() << endl;
     }
 }
 
-bool Parser::isBuiltInFunction(const string& name) {
+bool Parser::isBuiltInFunction(string_view name) {
     // List of common built-in functions in Python
     static const vector<string> builtins = {"print", "input",  "len",      "range",
                                                       "str",   "int",    "float",    "list",
@@ -1462,4 +1664,385 @@ bool Parser::isBuiltInFunction(const string& name) {
                                                       "zip",   "open",   "type"};
 
     return find(builtins.begin(), builtins.end(), name) != builtins.end();
-}
\ No newline at end of file
+}
+// Moves a reused subtree down by `delta` lines. Nodes without a position
+// (line 0) keep it. Walks with an explicit stack, since expression chains
+// like `a + b + ...` nest as deep as they are long; `pending` is that
+// stack, passed in so its storage is reused from statement to statement.
+static void shiftLines(ASTNode* root, int delta, vector<ASTNode*>& pending) {
+    pending.push_back(root);
+    while (!pending.empty()) {
+        ASTNode* node = pending.back();
+        pending.pop_back();
+        if (!node) continue;
+        if (node->line_number != 0) {
+            node->line_number += delta;
+        }
+
+        switch (node->type) {
+        case NodeType::PROGRAM:
+            for (ASTNode* statement : static_cast<ProgramNode*>(node)->statements) pending.push_back(statement);
+            break;
+        case NodeType::STATEMENT_LIST:
+            for (ASTNode* statement : static_cast<StatementListNode*>(node)->statements) pending.push_back(statement);
+            break;
+        case NodeType::STATEMENT:
+            pending.push_back(static_cast<StatementNode*>(node)->statement);
+            break;
+        case NodeType::ASSIGNMENT_STMT: {
+            auto assign = static_cast<AssignmentNode*>(node);
+            pending.push_back(assign->target);
+            pending.push_back(assign->value);
+            break;
+        }
+        case NodeType::IF_STMT: {
+            auto ifNode = static_cast<IfNode*>(node);
+            pending.push_back(ifNode->condition);
+            pending.push_back(ifNode->if_block);
+            for (ElifNode* elif : ifNode->elif_clauses) pending.push_back(elif);
+            pending.push_back(ifNode->else_block);
+            break;
+        }
+        case NodeType::ELIF_CLAUSE: {
+            auto elif = static_cast<ElifNode*>(node);
+            pending.push_back(elif->condition);
+            pending.push_back(elif->block);
+            break;
+        }
+        case NodeType::ELSE_CLAUSE:
+            pending.push_back(static_cast<ElseNode*>(node)->block);
+            break;
+        case NodeType::ELSE_PART: {
+            auto elsePart = static_cast<ElsePartNode*>(node);
+            for (ElifNode* elif : elsePart->elif_clauses) pending.push_back(elif);
+            pending.push_back(elsePart->else_block);
+            break;
+        }
+        case NodeType::WHILE_STMT: {
+            auto whileNode = static_cast<WhileNode*>(node);
+            pending.push_back(whileNode->condition);
+            pending.push_back(whileNode->block);
+            break;
+        }
+        case NodeType::FOR_STMT: {
+            auto forNode = static_cast<ForNode*>(node);
+            pending.push_back(forNode->target);
+            pending.push_back(forNode->iterable);
+            pending.push_back(forNode->block);
+            break;
+        }
+        case NodeType::FUNC_DEF: {
+            auto funcDef = static_cast<FunctionDefNode*>(node);
+            pending.push_back(funcDef->defKeyword);
+            pending.push_back(funcDef->nameNode);
+            pending.push_back(funcDef->openParen);
+            pending.push_back(funcDef->params);
+            pending.push_back(funcDef->closeParen);
+            pending.push_back(funcDef->colon);
+            pending.push_back(funcDef->body);
+            break;
+        }
+        case NodeType::RETURN_STMT:
+            pending.push_back(static_cast<ReturnNode*>(node)->expression);
+            break;
+        case NodeType::BINARY_EXPR: {
+            auto binary = static_cast<BinaryExprNode*>(node);
+            pending.push_back(binary->left);
+            pending.push_back(binary->right);
+            break;
+        }
+        case NodeType::UNARY_EXPR:
+            pending.push_back(static_cast<UnaryExprNode*>(node)->operand);
+            break;
+        case NodeType::CALL_EXPR: {
+            auto call = static_cast<CallExprNode*>(node);
+            pending.push_back(call->function);
+            pending.push_back(call->openParen);
+            pending.push_back(call->arguments);
+            pending.push_back(call->closeParen);
+            break;
+        }
+        case NodeType::SUBSCRIPT_EXPR: {
+            auto subscript = static_cast<SubscriptExprNode*>(node);
+            pending.push_back(subscript->container);
+            pending.push_back(subscript->index);
+            break;
+        }
+        case NodeType::ATTR_REF:
+            pending.push_back(static_cast<AttrRefNode*>(node)->object);
+            break;
+        case NodeType::EXPRESSION:
+            pending.push_back(static_cast<ExpressionNode*>(node)->expression);
+            break;
+        case NodeType::GROUP_EXPR:
+            pending.push_back(static_cast<GroupExprNode*>(node)->expression);
+            break;
+        case NodeType::ASSIGNMENT_WRAPPER:
+            pending.push_back(static_cast<AssignStmtNode*>(node)->assignment);
+            break;
+        case NodeType::COMPARISON_WRAPPER:
+            pending.push_back(static_cast<ComparisonExprNode*>(node)->comparison);
+            break;
+        case NodeType::LIST_LITERAL:
+            for (ASTNode* element : static_cast<ListNode*>(node)->elements) pending.push_back(element);
+            break;
+        case NodeType::DICT_LITERAL:
+            for (const auto& item : static_cast<DictNode*>(node)->items) {
+                pending.push_back(item.first);
+                pending.push_back(item.second);
+            }
+            break;
+        case NodeType::PARAM_LIST:
+            for (ParameterNode* param : static_cast<ParamListNode*>(node)->parameters) pending.push_back(param);
+            break;
+        case NodeType::ARG_LIST:
+            for (ASTNode* arg : static_cast<ArgListNode*>(node)->arguments) pending.push_back(arg);
+            break;
+        case NodeType::BLOCK:
+            pending.push_back(static_cast<BlockNode*>(node)->statements);
+            break;
+        case NodeType::CONDITION_NODE:
+            pending.push_back(static_cast<ConditionNode*>(node)->condition);
+            break;
+        case NodeType::PARAMETER_NODE:
+            pending.push_back(static_cast<ParameterNode*>(node)->default_value);
+            break;
+        case NodeType::IMPORT_STMT:
+        case NodeType::IDENTIFIER:
+        case NodeType::LITERAL:
+        case NodeType::TERMINAL:
+        case NodeType::ERROR_NODE:
+            break;
+        }
+    }
+}
+
+IncrementalParser::Statement IncrementalParser::parseStatement(Parser& parser, TokenCursor& cursor) {
+    Statement statement{cursor.current(), 0, parser.peek().line_number, parser.peek().column_number,
+                        nullptr, nullptr, {}};
+    size_t first_error = parser.errors.size();
+    statement.node = parser.parseStatementOrRecover();
+    statement.end = cursor.current();
+    statement.errors.assign(parser.errors.begin() + first_error, parser.errors.end());
+    return statement;
+}
+
+ParseResult IncrementalParser::parse(const TokenStream& tokens, const TokenEdit& edit) {
+    // Statements whose tokens, lookahead included, all precede the edit stay
+    // as they are; parsing resumes where the first of the others began
+    size_t kept = 0;
+    if (parsed) {
+        while (kept < statements.size() && statements[kept].end < edit.begin) ++kept;
+    } else {
+        statements.clear();
+    }
+    vector<Statement> old(make_move_iterator(statements.begin() + kept), make_move_iterator(statements.end()));
+    statements.resize(kept);
+    size_t start = kept > 0 ? statements[kept - 1].end : 0;
+    ptrdiff_t shift = static_cast<ptrdiff_t>(edit.new_end) - static_cast<ptrdiff_t>(edit.old_end);
+
+    // Nothing left to reuse: the whole stream gets parsed
+    bool everything = start == 0 && (old.empty() || edit.new_end >= tokens.size());
+    unsigned threads = worker_threads ? worker_threads : max(1u, thread::hardware_concurrency());
+    if (everything && threads > 1 && tokens.size() >= parallel_min_tokens) {
+        parseParallel(tokens, threads);
+        reparsed = statements.size();
+        old.clear();
+    } else {
+        TokenCursor cursor(tokens, start);
+        Parser parser(cursor);
+        size_t next_old = 0;
+        bool resynced = false;
+        reparsed = 0;
+        while (true) {
+            // Past the edit the tokens are the old ones again, so once a cached
+            // statement begins here everything from it on can be reused
+            size_t at = cursor.current();
+            if (at >= edit.new_end) {
+                size_t old_at = at - shift;
+                while (next_old < old.size() && old[next_old].begin < old_at) ++next_old;
+                if (next_old < old.size() && old[next_old].begin == old_at &&
+                    old[next_old].column_number == parser.peek().column_number) {
+                    resynced = true;
+                    break;
+                }
+            }
+            if (parser.atStatementListEnd()) break;
+            if (cancel_token) {
+                cancel_token->throwIfCancelled();
+                cancel_token->report(at, tokens.size());
+            }
+
+            statements.push_back(parseStatement(parser, cursor));
+            ++reparsed;
+        }
+
+        if (reparsed > 0) {
+            auto arena = make_shared<AstArena>(move(parser.arena));
+            for (size_t i = kept; i < statements.size(); ++i) statements[i].arena = arena;
+        }
+
+        if (resynced) {
+            int line_delta = parser.peek().line_number - old[next_old].line_number;
+            vector<ASTNode*> pending;
+            for (size_t i = next_old; i < old.size(); ++i) {
+                Statement& statement = old[i];
+                statement.begin += shift;
+                statement.end += shift;
+                if (line_delta != 0) {
+                    statement.line_number += line_delta;
+                    shiftLines(statement.node, line_delta, pending);
+                    for (SyntaxError& error : statement.errors) error.line_number += line_delta;
+                }
+                statements.push_back(move(statement));
+            }
+        }
+    }
+    parsed = true;
+
+    ParseResult result;
+    vector<ASTNode*> nodes;
+    nodes.reserve(statements.size());
+    for (const Statement& statement : statements) {
+        if (statement.node) nodes.push_back(statement.node);
+        if (statement.arena && (result.shared_arenas.empty() || result.shared_arenas.back() != statement.arena) &&
+            find(result.shared_arenas.begin(), result.shared_arenas.end(), statement.arena) == result.shared_arenas.end()) {
+            result.shared_arenas.push_back(statement.arena);
+        }
+    }
+    if (everything) {
+        base_arenas = result.shared_arenas.size();
+    } else if (result.shared_arenas.size() > base_arenas + MAX_SHARED_ARENAS) {
+        reset();
+        return parse(tokens, edit);
+    }
+
+    result.root = result.arena.make<ProgramNode>();
+    result.root->statements = result.arena.list(nodes);
+    return result;
+}
+
+// Splits the stream where a line starts outside every block and bracket,
+// and parses the pieces concurrently, each from its first token until a
+// statement begins at or past the next piece. Normally the serial parse
+// would have started a statement at each of those points too. Where error
+// recovery skipped past one, the merge parses serially from where the
+// previous piece really ended, until it meets a statement that the piece
+// recorded or the next piece begins.
+void IncrementalParser::parseParallel(const TokenStream& tokens, unsigned threads) {
+    size_t target = max(tokens.size() / (threads * 4), PARALLEL_MIN_CHUNK);
+    vector<size_t> starts{0};
+    int blocks = 0;
+    int brackets = 0;
+    int line = 0; // of the last token that is not an INDENT or DEDENT
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+        TokenType type = tokens.type(i);
+        if (type == INDENT || type == DEDENT) {
+            blocks += type == INDENT ? 1 : -1;
+            continue;
+        }
+        if (i - starts.back() >= target && blocks == 0 && brackets == 0 && tokens.line(i) != line &&
+            !(type == KEYWORD && (tokens.id(i) == LEX_ELSE || tokens.id(i) == LEX_ELIF))) {
+            starts.push_back(i);
+        }
+        line = tokens.line(i);
+        if (type == LPAREN || type == LBRACKET || type == LBRACE) {
+            brackets++;
+        } else if ((type == RPAREN || type == RBRACKET || type == RBRACE) && brackets > 0) {
+            brackets--;
+        }
+    }
+
+    struct Piece {
+        vector<Statement> statements;
+        bool finished = false; // the top-level statement loop ended inside it
+    };
+    vector<Piece> pieces(starts.size());
+    atomic<size_t> next_piece{0};
+    atomic<size_t> parsed_tokens{0};
+    auto work = [&]() {
+        for (size_t p = next_piece++; p < starts.size(); p = next_piece++) {
+            size_t stop = p + 1 < starts.size() ? starts[p + 1] : tokens.size();
+            TokenCursor cursor(tokens, starts[p]);
+            Parser parser(cursor);
+            while (cursor.current() < stop) {
+                if (parser.atStatementListEnd()) {
+                    pieces[p].finished = true;
+                    break;
+                }
+                // Thrown below, once the other workers are joined
+                if (cancel_token && cancel_token->isCancelled()) return;
+                pieces[p].statements.push_back(parseStatement(parser, cursor));
+            }
+            auto arena = make_shared<AstArena>(move(parser.arena));
+            for (Statement& statement : pieces[p].statements) statement.arena = arena;
+            if (cancel_token) cancel_token->report(parsed_tokens += stop - starts[p], tokens.size());
+        }
+    };
+    vector<thread> pool;
+    for (size_t t = 1; t < min<size_t>(threads, starts.size()); ++t)
+        pool.emplace_back(work);
+    work();
+    for (auto& t : pool)
+        t.join();
+    if (cancel_token) cancel_token->throwIfCancelled();
+
+    // Merge in source order
+    statements.clear();
+    size_t at = 0; // where the serial parse begins its next statement
+    for (size_t p = 0; p < pieces.size(); ++p) {
+        vector<Statement>& piece = pieces[p].statements;
+        size_t stop = p + 1 < starts.size() ? starts[p + 1] : tokens.size();
+        auto next = lower_bound(piece.begin(), piece.end(), at,
+                                [](const Statement& statement, size_t index) { return statement.begin < index; });
+
+        if (next == piece.end() || next->begin != at) {
+            TokenCursor cursor(tokens, at);
+            Parser parser(cursor);
+            size_t first = statements.size();
+            bool finished = false;
+            while (true) {
+                at = cursor.current();
+                while (next != piece.end() && next->begin < at) ++next;
+                if ((next != piece.end() && next->begin == at) || at >= stop) break;
+                if (parser.atStatementListEnd()) {
+                    finished = true;
+                    break;
+                }
+                statements.push_back(parseStatement(parser, cursor));
+            }
+            if (statements.size() > first) {
+                auto arena = make_shared<AstArena>(move(parser.arena));
+                for (size_t i = first; i < statements.size(); ++i) statements[i].arena = arena;
+            }
+            if (finished) return;
+            if (next == piece.end() || next->begin != at) continue;
+        }
+
+        for (; next != piece.end(); ++next) statements.push_back(move(*next));
+        at = statements.back().end;
+        if (pieces[p].finished) return;
+    }
+}
+
+void IncrementalParser::reset() {
+    statements.clear();
+    parsed = false;
+}
+
+bool IncrementalParser::hasError() const {
+    for (const Statement& statement : statements) {
+        if (!statement.errors.empty()) return true;
+    }
+    return false;
+}
+
+vector<string> IncrementalParser::getErrors() const {
+    vector<string> messages;
+    for (const Statement& statement : statements) {
+        for (const SyntaxError& error : statement.errors) {
+            messages.push_back(error.text());
+        }
+    }
+    return messages;
+}
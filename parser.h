@@ -4,9 +4,13 @@
 #define PARSER_H
 
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <new>
 #include "lexer.h"
 using namespace std;
 
@@ -67,6 +71,64 @@ enum class NodeType {
     ERROR_NODE,
 };
 
+// A run of children stored contiguously in an AstArena.
+template <typename T>
+struct NodeList {
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return items[i]; }
+};
+
+// Bump allocator that owns every node of a tree (and the strings and child
+// lists they point at). Memory is handed out from 64 KiB blocks and only
+// released when the arena goes away, so freeing a tree never walks it.
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(AstArena&& other) noexcept { *this = std::move(other); }
+    AstArena& operator=(AstArena&& other) noexcept;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    // Destructors are never run, so nodes may only hold trivially
+    // destructible members: raw pointers, string_views and NodeLists.
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    string_view copy(string_view text);
+
+    template <typename T>
+    NodeList<T> list(const vector<T>& items) {
+        static_assert(is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        NodeList<T> nodes;
+        if (items.empty()) return nodes;
+        nodes.items = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+        nodes.count = static_cast<uint32_t>(items.size());
+        uninitialized_copy(items.begin(), items.end(), nodes.items);
+        return nodes;
+    }
+
+    // Drop everything allocated so far.
+    void clear();
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    vector<unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+
+    void* allocate(size_t size, size_t align);
+};
+
 // Base AST Node class
 class ASTNode {
 public:
@@ -77,484 +139,617 @@ public:
     ASTNode(NodeType type, int line = 0, int col = 0)
         : type(type), line_number(line), column_number(col) {}
 
-    virtual ~ASTNode() = default;
-    virtual string toString(int indent = 0) const = 0;
+    // No virtual destructor: nodes live in an AstArena and are never
+    // deleted one by one (see AstArena::make). toString stays virtual only
+    // so that nodes remain polymorphic; ASTPrinter dispatches on `type`.
+    virtual string toString(int indent = 0) const;
 };
 
 // Program node (root of AST)
 class ProgramNode : public ASTNode {
 public:
-    vector<shared_ptr<ASTNode>> statements;
+    NodeList<ASTNode*> statements;
 
     ProgramNode() : ASTNode(NodeType::PROGRAM) {}
-    string toString(int indent = 0) const override;
 };
 
 // Statement list node
 class StatementListNode : public ASTNode {
 public:
-    vector<shared_ptr<ASTNode>> statements;
+    NodeList<ASTNode*> statements;
 
     StatementListNode() : ASTNode(NodeType::STATEMENT_LIST) {}
-    string toString(int indent = 0) const override;
 };
 
 // Block of statements (indented code block)
 class BlockNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> statements;
+    ASTNode* statements = nullptr;
 
     BlockNode() : ASTNode(NodeType::BLOCK) {}
-    string toString(int indent = 0) const override;
 };
 
 // Assignment statement
 class AssignmentNode : public ASTNode {
 public:
-    string op;                        // <- store the operator lexeme
-    shared_ptr<ASTNode> target;
-    shared_ptr<ASTNode> value;
+    OpCode op;                             // '=' or a compound assignment
+    ASTNode* target;
+    ASTNode* value;
 
     // Updated constructor:
-    AssignmentNode(shared_ptr<ASTNode> t,
-                   shared_ptr<ASTNode> v,
-                   const string &op_,
+    AssignmentNode(ASTNode* t,
+                   ASTNode* v,
+                   OpCode op_,
                    int line,
                    int col)
         : ASTNode(NodeType::ASSIGNMENT_STMT, line, col)
         , op(op_)
-        , target(move(t))
-        , value(move(v))
+        , target(t)
+        , value(v)
     {}
-
-    string toString(int indent = 0) const override;
 };
 
 // If statement
 class IfNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> condition;
-    shared_ptr<ASTNode> if_block;
-    // shared_ptr<ASTNode> elif_clauses;
-    vector<shared_ptr<ElifNode>> elif_clauses;
-    shared_ptr<ASTNode> else_block;
+    ASTNode* condition;
+    ASTNode* if_block;
+    // ASTNode* elif_clauses;
+    NodeList<ElifNode*> elif_clauses;
+    ASTNode* else_block;
     bool hasParentheses; // New field to track parentheses
 
-    IfNode(shared_ptr<ASTNode> cond, shared_ptr<ASTNode> block,
+    IfNode(ASTNode* cond, ASTNode* block,
             int line, int col, bool parentheses = false)
          : ASTNode(NodeType::IF_STMT, line, col), condition(cond), if_block(block),
            else_block(nullptr), hasParentheses(parentheses) {}
-
-    string toString(int indent = 0) const override;
 };
 
 
 class ElifNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> condition;
-    shared_ptr<ASTNode> block;
+    ASTNode* condition;
+    ASTNode* block;
     bool hasParentheses; // Add this field
 
-    ElifNode(shared_ptr<ASTNode> cond, shared_ptr<ASTNode> b, int line, int col, bool parentheses = false)
+    ElifNode(ASTNode* cond, ASTNode* b, int line, int col, bool parentheses = false)
         : ASTNode(NodeType::ELIF_CLAUSE, line, col),
           condition(cond), block(b), hasParentheses(parentheses) {}
-    string toString(int indent = 0) const override;
 };
 // Else clause
 class ElseNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> block;
+    ASTNode* block;
 
-    ElseNode(shared_ptr<ASTNode> b, int line, int col)
+    ElseNode(ASTNode* b, int line, int col)
         : ASTNode(NodeType::ELSE_CLAUSE, line, col), block(b) {}
-    string toString(int indent = 0) const override;
 };
 class ElsePartNode : public ASTNode {
 public:
-    vector<shared_ptr<ElifNode>> elif_clauses;
-    shared_ptr<ElseNode> else_block;
+    NodeList<ElifNode*> elif_clauses;
+    ElseNode* else_block;
 
-    ElsePartNode(const vector<shared_ptr<ElifNode>>& elifs,
-                shared_ptr<ElseNode> else_blk,
+    ElsePartNode(NodeList<ElifNode*> elifs,
+                ElseNode* else_blk,
                 int line = 0, int col = 0)
         : ASTNode(NodeType::ELSE_PART, line, col),
           elif_clauses(elifs), else_block(else_blk) {}
-
-    string toString(int indent = 0) const override;
 };
 
 // While statement
 class WhileNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> condition;
-    shared_ptr<ASTNode> block;
+    ASTNode* condition;
+    ASTNode* block;
     bool hasParentheses;
 
-    WhileNode(shared_ptr<ASTNode> condition, shared_ptr<BlockNode> block,
+    WhileNode(ASTNode* condition, BlockNode* block,
               int line_number, int column_number, bool hasParentheses = false)
         : ASTNode(NodeType::WHILE_STMT, line_number, column_number),
           condition(condition), block(block), hasParentheses(hasParentheses) {}
-
-    string toString(int indent = 0) const override;
 };
 
 // For statement
 class ForNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> target;
-    shared_ptr<ASTNode> iterable;
-    shared_ptr<ASTNode> block;
+    ASTNode* target;
+    ASTNode* iterable;
+    ASTNode* block;
     bool hasParentheses;  // Add this field
 
-    ForNode(shared_ptr<ASTNode> target, shared_ptr<ASTNode> iterable,
-            shared_ptr<BlockNode> block, int line_number, int column_number,
+    ForNode(ASTNode* target, ASTNode* iterable,
+            BlockNode* block, int line_number, int column_number,
             bool hasParentheses = false)
         : ASTNode(NodeType::FOR_STMT, line_number, column_number),
           target(target), iterable(iterable), block(block), hasParentheses(hasParentheses) {}
-
-
-    string toString(int indent = 0) const override;
 };
 
 // Function definition
 class FunctionDefNode : public ASTNode {
 public:
-    string name;
-    shared_ptr<ASTNode> params;
-    shared_ptr<ASTNode> body;
+    string_view name;
+    ASTNode* params;
+    ASTNode* body;
 
     // Terminal nodes for all parts of the function declaration syntax
-    shared_ptr<ASTNode> defKeyword;    // 'def' keyword as a terminal node
-    shared_ptr<ASTNode> nameNode;      // Function name as a terminal node
-    shared_ptr<ASTNode> openParen;     // '(' after function name
-    shared_ptr<ASTNode> closeParen;    // ')' after parameters
-    shared_ptr<ASTNode> colon;         // ':' after parameters
+    ASTNode* defKeyword;    // 'def' keyword as a terminal node
+    ASTNode* nameNode;      // Function name as a terminal node
+    ASTNode* openParen;     // '(' after function name
+    ASTNode* closeParen;    // ')' after parameters
+    ASTNode* colon;         // ':' after parameters
 
-    FunctionDefNode(const string& n, shared_ptr<ASTNode> p, shared_ptr<ASTNode> b,
+    FunctionDefNode(string_view n, ASTNode* p, ASTNode* b,
                    int line, int col)
         : ASTNode(NodeType::FUNC_DEF, line, col), name(n), params(p), body(b),
           defKeyword(nullptr), nameNode(nullptr), openParen(nullptr),
           closeParen(nullptr), colon(nullptr) {}
-
-    string toString(int indent = 0) const override;
 };
 
 // Return statement
 class ReturnNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> expression;
+    ASTNode* expression;
 
-    ReturnNode(shared_ptr<ASTNode> expr, int line, int col)
+    ReturnNode(ASTNode* expr, int line, int col)
         : ASTNode(NodeType::RETURN_STMT, line, col), expression(expr) {}
-    string toString(int indent = 0) const override;
 };
 
 // Import statement
 class ImportNode : public ASTNode {
 public:
-    string module;
-    string alias; // For "import x as y"
+    string_view module;
+    string_view alias; // For "import x as y"
 
-    ImportNode(const string& m, const string& a, int line, int col)
+    ImportNode(string_view m, string_view a, int line, int col)
         : ASTNode(NodeType::IMPORT_STMT, line, col), module(m), alias(a) {}
-    string toString(int indent = 0) const override;
 };
 
 // Binary expression
 class BinaryExprNode : public ASTNode {
 public:
-    string op;
-    shared_ptr<ASTNode> left;
-    shared_ptr<ASTNode> right;
+    OpCode op;
+    ASTNode* left;
+    ASTNode* right;
 
-    BinaryExprNode(const string& o, shared_ptr<ASTNode> l, shared_ptr<ASTNode> r, int line, int col)
+    BinaryExprNode(OpCode o, ASTNode* l, ASTNode* r, int line, int col)
         : ASTNode(NodeType::BINARY_EXPR, line, col), op(o), left(l), right(r) {}
-    string toString(int indent = 0) const override;
 };
 
 // Unary expression
 class UnaryExprNode : public ASTNode {
 public:
-    string op;
-    shared_ptr<ASTNode> operand;
+    OpCode op;
+    ASTNode* operand;
 
-    UnaryExprNode(const string& o, shared_ptr<ASTNode> opnd, int line, int col)
+    UnaryExprNode(OpCode o, ASTNode* opnd, int line, int col)
         : ASTNode(NodeType::UNARY_EXPR, line, col), op(o), operand(opnd) {}
-    string toString(int indent = 0) const override;
 };
 
 
 // Function call
 class CallExprNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> function;
-    shared_ptr<ASTNode> arguments;
+    ASTNode* function;
+    ASTNode* arguments;
 
     // Add these for parentheses visualization
-    shared_ptr<ASTNode> openParen;
-    shared_ptr<ASTNode> closeParen;
+    ASTNode* openParen;
+    ASTNode* closeParen;
 
-    CallExprNode(shared_ptr<ASTNode> func, shared_ptr<ASTNode> args, int line, int col)
+    CallExprNode(ASTNode* func, ASTNode* args, int line, int col)
         : ASTNode(NodeType::CALL_EXPR, line, col), function(func), arguments(args),
           openParen(nullptr), closeParen(nullptr) {}
-
-    string toString(int indent = 0) const override;
 };
 
 // Subscript expression (list/dict indexing)
 class SubscriptExprNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> container;
-    shared_ptr<ASTNode> index;
+    ASTNode* container;
+    ASTNode* index;
 
-    SubscriptExprNode(shared_ptr<ASTNode> c, shared_ptr<ASTNode> i, int line, int col)
+    SubscriptExprNode(ASTNode* c, ASTNode* i, int line, int col)
         : ASTNode(NodeType::SUBSCRIPT_EXPR, line, col), container(c), index(i) {}
-    string toString(int indent = 0) const override;
 };
 
 // Attribute reference (obj.attr)
 class AttrRefNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> object;
-    string attribute;
+    ASTNode* object;
+    string_view attribute;
 
-    AttrRefNode(shared_ptr<ASTNode> obj, const string& attr, int line, int col)
+    AttrRefNode(ASTNode* obj, string_view attr, int line, int col)
         : ASTNode(NodeType::ATTR_REF, line, col), object(obj), attribute(attr) {}
-    string toString(int indent = 0) const override;
 };
 
 // Identifier
 class IdentifierNode : public ASTNode {
 public:
-    string name;
+    string_view name;
 
-    IdentifierNode(const string& n, int line, int col)
+    IdentifierNode(string_view n, int line, int col)
         : ASTNode(NodeType::IDENTIFIER, line, col), name(n) {}
-    string toString(int indent = 0) const override;
 };
 
 // Literal (number, string, etc.)
 class LiteralNode : public ASTNode {
 public:
-    string value;
-    string type; // e.g. "int", "float", "string", "bool"
+    string_view value;
+    string_view type; // e.g. "int", "float", "string", "bool"
 
-    LiteralNode(const string& v, const string& t, int line, int col)
+    LiteralNode(string_view v, string_view t, int line, int col)
         : ASTNode(NodeType::LITERAL, line, col), value(v), type(t) {}
-    string toString(int indent = 0) const override;
 };
 
 // List literal
 class ListNode : public ASTNode {
 public:
-    vector<shared_ptr<ASTNode>> elements;
+    NodeList<ASTNode*> elements;
 
     ListNode(int line, int col) : ASTNode(NodeType::LIST_LITERAL, line, col) {}
-    string toString(int indent = 0) const override;
 };
 
 // Dict literal
 class DictNode : public ASTNode {
 public:
-    vector<pair<shared_ptr<ASTNode>, shared_ptr<ASTNode>>> items;
+    NodeList<pair<ASTNode*, ASTNode*>> items;
 
     DictNode(int line, int col) : ASTNode(NodeType::DICT_LITERAL, line, col) {}
-    string toString(int indent = 0) const override;
 };
 
 // Parameter node for function parameters
 class ParameterNode : public ASTNode {
 public:
-    string name;
-    shared_ptr<ASTNode> default_value; // nullptr means no default value
+    string_view name;
+    ASTNode* default_value; // nullptr means no default value
 
-    ParameterNode(const string& name, shared_ptr<ASTNode> default_value = nullptr,
+    ParameterNode(string_view name, ASTNode* default_value = nullptr,
                  int line = 0, int col = 0)
         : ASTNode(NodeType::PARAMETER_NODE, line, col),
           name(name), default_value(default_value) {}
-
-    string toString(int indent = 0) const override;
 };
 
 
 // Parameter list for function definitions
 class ParamListNode : public ASTNode {
 public:
-    // Change from vector<shared_ptr<IdentifierNode>> to vector<shared_ptr<ParameterNode>>
-    vector<shared_ptr<ParameterNode>> parameters;
+    NodeList<ParameterNode*> parameters;
 
     ParamListNode() : ASTNode(NodeType::PARAM_LIST) {}
-    string toString(int indent = 0) const override;
 };
 
 // Argument list for function calls
 class ArgListNode : public ASTNode {
 public:
-    vector<shared_ptr<ASTNode>> arguments;
+    NodeList<ASTNode*> arguments;
 
     ArgListNode() : ASTNode(NodeType::ARG_LIST) {}
-    string toString(int indent = 0) const override;
 };
 
 // New Condition Node class to represent the condition container
 class ConditionNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> condition;
+    ASTNode* condition;
 
-    ConditionNode(shared_ptr<ASTNode> cond, int line, int col)
+    ConditionNode(ASTNode* cond, int line, int col)
         : ASTNode(NodeType::CONDITION_NODE, line, col), condition(cond) {}
-
-    string toString(int indent = 0) const override;
 };
 
 // Error node for error recovery
 class ErrorNode : public ASTNode {
 public:
-    string message;
+    string_view message;
 
-    ErrorNode(const string& msg, int line, int col)
+    ErrorNode(string_view msg, int line, int col)
         : ASTNode(NodeType::ERROR_NODE, line, col), message(msg) {}
-    string toString(int indent = 0) const override;
 };
 
 // Terminal node for symbols like '(', ')', '{', '}', '[', ']'
 class TerminalNode : public ASTNode {
 public:
-    string value; // The value of the terminal (e.g., "(", "{", etc.)
+    string_view value; // The value of the terminal (e.g., "(", "{", etc.)
 
-    TerminalNode(const string& value, int line = 0, int col = 0)
+    TerminalNode(string_view value, int line = 0, int col = 0)
         : ASTNode(NodeType::TERMINAL, line, col), value(value) {}
-
-    string toString(int indent = 0) const override; // Declare the toString function
 };
 
 class StatementNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> statement;
+    ASTNode* statement;
 
-    StatementNode(shared_ptr<ASTNode> stmt)
+    StatementNode(ASTNode* stmt)
         : ASTNode(NodeType::STATEMENT), statement(stmt) {}
-
-    string toString(int indent = 0) const override;
 };
 
 
 class ExpressionNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> expression;
+    ASTNode* expression;
 
-    ExpressionNode(shared_ptr<ASTNode> expr)
+    ExpressionNode(ASTNode* expr)
         : ASTNode(NodeType::EXPRESSION, expr->line_number, expr->column_number),
           expression(expr) {}
-
-    string toString(int indent = 0) const override;
 };
 
 class AssignStmtNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> assignment;
+    ASTNode* assignment;
 
-    AssignStmtNode(shared_ptr<ASTNode> assign)
+    AssignStmtNode(ASTNode* assign)
         : ASTNode(NodeType::ASSIGNMENT_WRAPPER, assign->line_number, assign->column_number),
           assignment(assign) {}
-
-    string toString(int indent = 0) const override;
 };
 
 class ComparisonExprNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> comparison;
+    ASTNode* comparison;
 
-    ComparisonExprNode(shared_ptr<ASTNode> comp)
+    ComparisonExprNode(ASTNode* comp)
         : ASTNode(NodeType::COMPARISON_WRAPPER, comp->line_number, comp->column_number),
           comparison(comp) {}
-
-    // Fix: Replace with direct string creation like other inline toString methods
-    string toString(int indent = 0) const override;
 };
 // Group expression node for parenthesized expressions (e.g., (a + b))
 class GroupExprNode : public ASTNode {
 public:
-    shared_ptr<ASTNode> expression;
+    ASTNode* expression;
 
-    GroupExprNode(shared_ptr<ASTNode> expr, int line, int col)
+    GroupExprNode(ASTNode* expr, int line, int col)
         : ASTNode(NodeType::GROUP_EXPR, line, col), expression(expr) {}
+};
+
+// Writes the indented tree dump returned by ASTNode::toString. Nodes are
+// visited from an explicit stack and every line is appended to one buffer,
+// so printing takes time linear in the output however deeply the tree
+// nests. Missing (null) children print nothing.
+class ASTPrinter {
+public:
+    explicit ASTPrinter(string& out) : out(out) {}
+    // Streams into `sink`, handing it the buffer every FLUSH_BYTES.
+    explicit ASTPrinter(ostream& sink) : out(buffer), sink(&sink) {}
+
+    void print(const ASTNode* root, int indent = 0);
 
-    string toString(int indent = 0) const override;
+private:
+    static constexpr size_t FLUSH_BYTES = 64 << 10;
+
+    // A node still to be visited, or (node == nullptr) a line of text.
+    struct Item {
+        const ASTNode* node;
+        int indent;
+        string_view text;
+        string_view detail;
+    };
+
+    string buffer;
+    string& out;
+    ostream* sink = nullptr;
+    vector<Item> pending;
+
+    void visit(const ASTNode* node, int indent);
+    void child(const ASTNode* node, int indent);
+    void label(int indent, string_view text, string_view detail = {});
+    void startLine(int indent);
+    void appendNumber(int value);
+    void flush();
+};
+
+// Parser tracing is compiled in only up to PARSER_TRACE_LEVEL, which is 0 by
+// default so normal builds contain no trace code at all. Build with
+// -DPARSER_TRACE_LEVEL=1 to trace every parsePrimary step, or 2 to also log
+// the INDENT/DEDENT tokens skipped inside expressions. The trace is written
+// to the file opened with Parser::setTraceFile().
+#ifndef PARSER_TRACE_LEVEL
+#define PARSER_TRACE_LEVEL 0
+#endif
+
+enum TraceLevel {
+    TRACE_PRIMARY = 1,
+    TRACE_LAYOUT = 2,
+};
+
+// What Parser::parse() returns: the tree together with the arena that owns
+// it. Every node is gone once the result is dropped.
+struct ParseResult {
+    ProgramNode* root = nullptr;
+    AstArena arena;
+    // Arenas holding statements an IncrementalParser reused from earlier
+    // results; empty for Parser::parse()
+    vector<shared_ptr<AstArena>> shared_arenas;
+};
+
+// A syntax error as reported; text() formats it as
+// "Syntax Error at line 3, column 5: <message>".
+struct SyntaxError {
+    string message;
+    int line_number;
+    int column_number;
+
+    string text() const;
 };
 
 // The Parser class
 class Parser {
 private:
-    Lexer& lexer;
-    vector<Token>::iterator current_token;
-    vector<string> errors;
+    TokenSource& source;    // pulled one token at a time
+    AstArena arena;         // nodes of the tree being built
+    Token current_token;    // one-token lookahead
+    vector<SyntaxError> errors;
     bool has_error;
+    // Set by fail() when a statement cannot be parsed. Every parse method
+    // returns nullptr as soon as it sees failed(), without consuming or
+    // reporting anything else, until parseStatementList recovers.
+    ErrorNode* failure = nullptr;
+    ofstream trace_file;    // buffered; only written when tracing is compiled in
+    // Expressions and blocks being parsed inside each other. Each level
+    // costs a few recursive calls (up to ~1.6 KB of stack in a debug
+    // build), so past max_nesting the statement fails instead, and
+    // too_deep tells recover() to skip its block too.
+    int nesting = 0;
+    int max_nesting = DEFAULT_MAX_NESTING;
+    bool too_deep = false;
+
+    // Holds one level of `nesting` for as long as it lives, failing the
+    // statement if that is one too many.
+    struct NestingScope {
+        Parser& parser;
+        explicit NestingScope(Parser& parser);
+        ~NestingScope() { --parser.nesting; }
+    };
 
     // Helper methods
-    Token& peek();
-    Token& consume();
+    const Token& peek();
+    Token consume();
     bool match(TokenType type);
     bool match(const string& lexeme);
+    bool match(LexemeId id);
     bool check(TokenType type);
     bool check(const string& lexeme);
+    bool check(LexemeId id);
     bool isAtEnd();
 
-    bool isAssignmentOperator(const string &lexeme);
+    bool isAssignmentOperator(uint32_t id);
 
-    bool isBuiltInFunction(const string& name); // Add this line
+    bool isBuiltInFunction(string_view name); // Add this line
     void synchronize();
     void error(const string& message, int line, int column);
+    void fail(const char* message);
+    bool failed() const { return failure != nullptr; }
+    void recover();
+    void skipBlock();
 
     // Recursive descent parsing methods
     // ...rest of the code
     // Recursive descent parsing methods
-    shared_ptr<ProgramNode> parseProgram();
-    shared_ptr<StatementListNode> parseStatementList();
-    shared_ptr<ASTNode> parseStatement();
-    shared_ptr<AssignmentNode> parseAssignment(shared_ptr<ASTNode> target);
-    shared_ptr<IfNode> parseIfStatement();
-    shared_ptr<ElifNode> parseElifClause();
-    shared_ptr<ElseNode> parseElseClause();
-    shared_ptr<WhileNode> parseWhileStatement();
-    shared_ptr<ForNode> parseForStatement();
-    shared_ptr<FunctionDefNode> parseFunctionDef();
-    shared_ptr<ReturnNode> parseReturnStatement();
-    shared_ptr<ImportNode> parseImportStatement();
-    shared_ptr<BlockNode> parseBlock();
-
-    shared_ptr<ASTNode> parseExpression();
-    shared_ptr<ASTNode> parseOrExpr();
-    shared_ptr<ASTNode> parseAndExpr();
-    shared_ptr<ASTNode> parseNotExpr();
-    shared_ptr<ASTNode> parseComparisonExpr();
-    shared_ptr<ASTNode> parseArithmeticExpr();
-    shared_ptr<ASTNode> parseTerm();
-    shared_ptr<ASTNode> parseFactor();
-    shared_ptr<ASTNode> parsePower();
-    shared_ptr<ASTNode> parseUnary();
-
-    void debugToken(const string &context);
+    ProgramNode* parseProgram();
+    StatementListNode* parseStatementList();
+    bool atStatementListEnd();
+    ASTNode* parseStatementOrRecover();
+    ASTNode* parseStatement();
+    AssignmentNode* parseAssignment(ASTNode* target);
+    IfNode* parseIfStatement();
+    ElifNode* parseElifClause();
+    ElseNode* parseElseClause();
+    WhileNode* parseWhileStatement();
+    ForNode* parseForStatement();
+    FunctionDefNode* parseFunctionDef();
+    ReturnNode* parseReturnStatement();
+    ImportNode* parseImportStatement();
+    BlockNode* parseBlock();
+
+    ASTNode* parseExpression();
+    ASTNode* parseBinary(int min_precedence);
+    ASTNode* parseUnary();
+
+    // One trace line per call when Level is compiled in and a trace file is
+    // open; otherwise these compile to nothing.
+    template <int Level, typename... Parts>
+    void trace(const Parts&... parts) {
+        if constexpr (Level <= PARSER_TRACE_LEVEL) {
+            if (trace_file.is_open()) {
+                (trace_file << ... << parts) << '\n';
+            }
+        }
+    }
+
+    template <int Level>
+    void traceToken(const char* context) {
+        if constexpr (Level <= PARSER_TRACE_LEVEL) {
+            if (trace_file.is_open()) {
+                debugToken(context);
+            }
+        }
+    }
+
+    void debugToken(const char* context);
 
 
     string tokenTypeToString(TokenType type);
 
-    shared_ptr<ASTNode> parsePrimary();
-    shared_ptr<ASTNode> parseAttributeReference(shared_ptr<ASTNode> object);
-    shared_ptr<ASTNode> parseSubscript(shared_ptr<ASTNode> container);
-    shared_ptr<ASTNode> parseCall(shared_ptr<ASTNode> function);
-    shared_ptr<ArgListNode> parseArguments();
-    shared_ptr<ParamListNode> parseParameters();
-    shared_ptr<ListNode> parseListLiteral();
-    shared_ptr<DictNode> parseDictLiteral();
+    ASTNode* parsePrimary();
+    ASTNode* parseAttributeReference(ASTNode* object);
+    ASTNode* parseSubscript(ASTNode* container);
+    ASTNode* parseCall(ASTNode* function);
+    ArgListNode* parseArguments();
+    ParamListNode* parseParameters();
+    ListNode* parseListLiteral();
+    DictNode* parseDictLiteral();
 
 public:
-    Parser(Lexer& lexer);
-    shared_ptr<ProgramNode> parse();
-    void printParseTree(shared_ptr<ASTNode> root, int indent = 0);
+    // Deep enough for any hand-written code, shallow enough to stay well
+    // inside the 1 MB stack of a Windows main thread
+    static constexpr int DEFAULT_MAX_NESTING = 200;
+
+    Parser(TokenSource& source);
+    ParseResult parse();
+    void setMaxNesting(int levels) { max_nesting = levels; }
+    void printParseTree(const ASTNode* root, int indent = 0);
     void printErrors();
+    // Opt-in runtime trace (see PARSER_TRACE_LEVEL). An empty path closes it.
+    bool setTraceFile(const string& path);
     bool hasError() const { return !errors.empty(); }
-    const vector<string>& getErrors() const { return errors; }
+    vector<string> getErrors() const;
+
+    friend class IncrementalParser;
+};
+
+// Parses a token stream again after edits, reusing the subtree of every
+// top-level statement whose tokens did not change. Each top-level statement
+// is cached with the token range it was parsed from, up to and including
+// the lookahead token that ended it. After an edit, parsing restarts at the
+// first statement whose range reaches the changed tokens and stops as soon
+// as a statement begins, past the change, where a cached one began: from
+// there on the parser would see the same tokens in the same state. Reused
+// statements are shared with the previous result, and when lines moved
+// their line numbers are updated in place, so that result is stale once
+// the next one is returned. Parsing everything (the first call, or after a
+// full re-lex) splits streams of at least parallel_min_tokens between top-
+// level statements and parses the pieces on several threads.
+class IncrementalParser {
+public:
+    // `edit` is how `tokens` changed since the previous call, e.g. from
+    // Lexer::takeTokenEdit(); the first call parses everything.
+    ParseResult parse(const TokenStream& tokens, const TokenEdit& edit);
+    void reset();
+    // threads == 0 picks std::thread::hardware_concurrency(); 1 forces the serial path
+    void setParallelism(unsigned threads, size_t min_tokens = PARALLEL_MIN_TOKENS)
+    {
+        worker_threads = threads;
+        parallel_min_tokens = min_tokens;
+    }
+    // Checked before each top-level statement; nullptr: never cancelled
+    void setCancelToken(CancelToken* token) { cancel_token = token; }
+    bool hasError() const;
+    vector<string> getErrors() const;
+    size_t reparsedCount() const { return reparsed; } // statements parsed by the last call
+
+    static constexpr size_t PARALLEL_MIN_TOKENS = 64 << 10;
+    static constexpr size_t PARALLEL_MIN_CHUNK = 4 << 10;
+
+private:
+    struct Statement {
+        size_t begin;            // first token
+        size_t end;              // lookahead token that ended it
+        int line_number;         // position of the first token, to tell
+        int column_number;       // how far a reused statement moved
+        ASTNode* node;           // nullptr if it failed to parse
+        shared_ptr<AstArena> arena;
+        vector<SyntaxError> errors;
+    };
+
+    // Once a result holds this many more arenas than the last parse of
+    // everything did, everything is parsed again so that replaced
+    // statements stop holding on to memory
+    static constexpr size_t MAX_SHARED_ARENAS = 16;
+
+    static Statement parseStatement(Parser& parser, TokenCursor& cursor);
+    void parseParallel(const TokenStream& tokens, unsigned threads);
+
+    vector<Statement> statements;
+    bool parsed = false;
+    size_t reparsed = 0;
+    size_t base_arenas = 0;      // arenas of the last parse of everything
+    unsigned worker_threads = 0;
+    size_t parallel_min_tokens = PARALLEL_MIN_TOKENS;
+    CancelToken* cancel_token = nullptr;
 };
 
 #endif // PARSER_H
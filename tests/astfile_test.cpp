@@ -0,0 +1,204 @@
+//astfile_test.cpp
+
+// Round-trips the sources in a directory through the binary AST file and
+// checks that damaged files are rejected:
+//
+//   astfile_test <data directory>
+//
+// Every *.py file is parsed, saved with saveAstFile(), read back with
+// AstFile::openFile() and load(), and must print the same ASTPrinter
+// output and serialize to the same bytes as the original tree. Exits with
+// the number of failed checks.
+
+#include "astfile.h"
+#include "lexer.h"
+#include "parser.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        printf("FAIL %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+string readFile(const filesystem::path& path) {
+    ifstream in(path, ios::binary);
+    ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+string printed(const ASTNode* root) {
+    string out;
+    if (root) ASTPrinter(out).print(root);
+    return out;
+}
+
+// The parse of `source`, errors included; error nodes are saved like any other
+ParseResult parseSource(const string& source) {
+    Lexer lexer;
+    lexer.tokenize(source);
+    Parser parser(lexer);
+    return parser.parse();
+}
+
+void roundTrip(const filesystem::path& source, const filesystem::path& scratch) {
+    const string name = source.filename().string();
+    ParseResult original = parseSource(readFile(source));
+    const string expected = printed(original.root);
+
+    saveAstFile(original.root, scratch.string());
+    AstFile file;
+    try {
+        file.openFile(scratch.string());
+        ParseResult loaded = file.load();
+        check(printed(loaded.root) == expected, name + ": loaded tree prints differently");
+        check(serializeAst(loaded.root) == serializeAst(original.root),
+              name + ": loaded tree serializes differently");
+    } catch (const exception& e) {
+        check(false, name + ": " + e.what());
+    }
+    check(file.nodeCount() > 0 || !original.root, name + ": saved file has no nodes");
+}
+
+AstFileHeader& headerOf(string& bytes) {
+    return *reinterpret_cast<AstFileHeader*>(&bytes[0]);
+}
+
+AstFileNode* nodesOf(string& bytes) {
+    return reinterpret_cast<AstFileNode*>(&bytes[sizeof(AstFileHeader)]);
+}
+
+uint32_t* childrenOf(string& bytes) {
+    return reinterpret_cast<uint32_t*>(nodesOf(bytes) + headerOf(bytes).node_count);
+}
+
+// Index of the first node of `type`
+uint32_t findNode(string& bytes, NodeType type) {
+    AstFileNode* nodes = nodesOf(bytes);
+    for (uint32_t i = 0; i < headerOf(bytes).node_count; ++i) {
+        if (nodes[i].type == static_cast<uint8_t>(type)) return i;
+    }
+    throw runtime_error("test input has no node of the expected type");
+}
+
+bool rejects(const string& bytes) {
+    try {
+        AstFile file;
+        file.open(bytes);
+        file.load();
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// `source` must parse cleanly and contain every node type damaged below
+void corruptFiles(const filesystem::path& source) {
+    const ParseResult tree = parseSource(readFile(source));
+    const string good = serializeAst(tree.root);
+    check(!rejects(good), "intact file rejected");
+
+    // One damaged copy of `good` per case; each must be rejected
+    struct Case {
+        const char* name;
+        function<void(string&)> damage;
+    };
+    const Case cases[] = {
+        {"bad magic", [](string& b) { headerOf(b).magic ^= 1; }},
+        {"other version", [](string& b) { headerOf(b).version = AST_FILE_VERSION + 1; }},
+        {"truncated", [](string& b) { b.resize(b.size() - 4); }},
+        {"trailing data", [](string& b) { b.append(4, '\0'); }},
+        {"unknown node type", [](string& b) { nodesOf(b)[1].type = 0xFF; }},
+        {"wrong arity", [](string& b) {
+             nodesOf(b)[findNode(b, NodeType::ASSIGNMENT_STMT)].child_count = 1;
+         }},
+        {"children outside the file", [](string& b) {
+             nodesOf(b)[0].first_child = headerOf(b).child_count;
+         }},
+        {"child pointing back at the root", [](string& b) {
+             AstFileNode& node = nodesOf(b)[findNode(b, NodeType::ASSIGNMENT_STMT)];
+             childrenOf(b)[node.first_child] = 0;
+         }},
+        {"child used twice", [](string& b) {
+             AstFileNode& node = nodesOf(b)[findNode(b, NodeType::BINARY_EXPR)];
+             childrenOf(b)[node.first_child + 1] = childrenOf(b)[node.first_child];
+         }},
+        {"missing required child", [](string& b) {
+             AstFileNode& node = nodesOf(b)[findNode(b, NodeType::COMPARISON_WRAPPER)];
+             childrenOf(b)[node.first_child] = AST_FILE_NONE;
+         }},
+        {"text outside the file", [](string& b) {
+             nodesOf(b)[findNode(b, NodeType::IDENTIFIER)].text[0].offset = headerOf(b).string_bytes;
+         }},
+        {"invalid operator", [](string& b) {
+             nodesOf(b)[findNode(b, NodeType::BINARY_EXPR)].op = LEX_FIRST_DYNAMIC;
+         }},
+        {"root not a program", [](string& b) {
+             nodesOf(b)[0].type = static_cast<uint8_t>(NodeType::ARG_LIST);
+         }},
+    };
+    for (const Case& test : cases) {
+        string bytes = good;
+        test.damage(bytes);
+        check(rejects(bytes), string("corrupt file accepted: ") + test.name);
+    }
+
+    // Random damage past the header must be rejected or yield a tree, never
+    // read out of bounds (run under a sanitizer to catch that)
+    mt19937 rng(20);
+    for (int run = 0; run < 2000; ++run) {
+        string bytes = good;
+        uniform_int_distribution<size_t> position(sizeof(AstFileHeader), bytes.size() - 1);
+        for (int flips = 0; flips < 4; ++flips) bytes[position(rng)] ^= char(1 << (rng() % 8));
+        try {
+            AstFile file;
+            file.open(bytes);
+            printed(file.load().root);
+        } catch (const runtime_error&) {
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <data directory>\n", argv[0]);
+        return 2;
+    }
+    vector<filesystem::path> sources;
+    for (const auto& entry : filesystem::directory_iterator(argv[1])) {
+        if (entry.path().extension() == ".py") sources.push_back(entry.path());
+    }
+    sort(sources.begin(), sources.end());
+    if (sources.empty()) {
+        fprintf(stderr, "no .py files in %s\n", argv[1]);
+        return 2;
+    }
+
+    const filesystem::path scratch = filesystem::temp_directory_path() / "astfile_test.ast";
+    for (const auto& source : sources) roundTrip(source, scratch);
+    filesystem::remove(scratch);
+
+    corruptFiles(filesystem::path(argv[1]) / "gen50.py");
+
+    printf("%zu files round-tripped, %d failures\n", sources.size(), failures);
+    return failures;
+}
@@ -0,0 +1,31 @@
+import math
+x = 5
+y = 3.14
+name = "hello world"
+s2 = 'single \' quote'
+def add(a, b=2, c=-1):
+    total = a + b * c - (a / b) % 3
+    return total ** 2
+if (x > 3 and y < 4) or not x == 2:
+    print(x)
+elif x != 2:
+    print("elif")
+else:
+    z = [1, 2, -3, [4, 5]]
+while x >= 0:
+    x -= 1
+for i in range(10):
+    d = {"a": 1, "b": -2, 3: [1]}
+    d["a"] += i
+result = add(1, 2).real
+lst[0][1] = obj.attr.method(x, y)
+# comment line
+z = x // 2 + x << 1
+w = True
+v = None
+q = -x ** 2
+'''
+docstring
+'''
+a = 1 # trailing
+b = """inline""" + 2
@@ -0,0 +1,6 @@
+x = 1
+y = 2
+if x:
+    z = 3
+
+    w = 4
@@ -0,0 +1,28 @@
+x = 1.2.3
+y = 123abc
+z = ab$c
+if = 5
+hello world = 1
+x = 1 2
+for = 3
+a = .5 + 1.
+b = 1..5
+print "hi"
+c = @
+def f(:
+    pass
+x = (1 + 2
+y = [1, 2
+z = {1: 2
+w = --x
+if x
+    y = 1
+	tabbed = 1
+  bad = 2
+abc1.foo = 3
+k = x.True
+m = 5 if
+n = 'unterminated
+o = a!b
+p = x ~ y & z | w ^ q
+r = "a\\"
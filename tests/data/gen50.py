@@ -0,0 +1,450 @@
+def func_0(a, b=2):
+    x_0 = a + b * 0 - (a / 3.5) % 2
+    if x_0 > 0 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_0, obj.attr.method(a))
+    return x_0 ** 2
+y_0 = func_0(1, 2)
+def func_1(a, b=2):
+    x_1 = a + b * 1 - (a / 3.5) % 2
+    if x_1 > 1 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_1, obj.attr.method(a))
+    return x_1 ** 2
+y_1 = func_1(1, 2)
+def func_2(a, b=2):
+    x_2 = a + b * 2 - (a / 3.5) % 2
+    if x_2 > 2 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_2, obj.attr.method(a))
+    return x_2 ** 2
+y_2 = func_2(1, 2)
+def func_3(a, b=2):
+    x_3 = a + b * 3 - (a / 3.5) % 2
+    if x_3 > 3 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_3, obj.attr.method(a))
+    return x_3 ** 2
+y_3 = func_3(1, 2)
+def func_4(a, b=2):
+    x_4 = a + b * 4 - (a / 3.5) % 2
+    if x_4 > 4 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_4, obj.attr.method(a))
+    return x_4 ** 2
+y_4 = func_4(1, 2)
+def func_5(a, b=2):
+    x_5 = a + b * 5 - (a / 3.5) % 2
+    if x_5 > 5 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_5, obj.attr.method(a))
+    return x_5 ** 2
+y_5 = func_5(1, 2)
+def func_6(a, b=2):
+    x_6 = a + b * 6 - (a / 3.5) % 2
+    if x_6 > 6 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_6, obj.attr.method(a))
+    return x_6 ** 2
+y_6 = func_6(1, 2)
+def func_7(a, b=2):
+    x_7 = a + b * 7 - (a / 3.5) % 2
+    if x_7 > 7 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_7, obj.attr.method(a))
+    return x_7 ** 2
+y_7 = func_7(1, 2)
+def func_8(a, b=2):
+    x_8 = a + b * 8 - (a / 3.5) % 2
+    if x_8 > 8 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_8, obj.attr.method(a))
+    return x_8 ** 2
+y_8 = func_8(1, 2)
+def func_9(a, b=2):
+    x_9 = a + b * 9 - (a / 3.5) % 2
+    if x_9 > 9 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_9, obj.attr.method(a))
+    return x_9 ** 2
+y_9 = func_9(1, 2)
+def func_10(a, b=2):
+    x_10 = a + b * 10 - (a / 3.5) % 2
+    if x_10 > 10 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_10, obj.attr.method(a))
+    return x_10 ** 2
+y_10 = func_10(1, 2)
+def func_11(a, b=2):
+    x_11 = a + b * 11 - (a / 3.5) % 2
+    if x_11 > 11 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_11, obj.attr.method(a))
+    return x_11 ** 2
+y_11 = func_11(1, 2)
+def func_12(a, b=2):
+    x_12 = a + b * 12 - (a / 3.5) % 2
+    if x_12 > 12 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_12, obj.attr.method(a))
+    return x_12 ** 2
+y_12 = func_12(1, 2)
+def func_13(a, b=2):
+    x_13 = a + b * 13 - (a / 3.5) % 2
+    if x_13 > 13 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_13, obj.attr.method(a))
+    return x_13 ** 2
+y_13 = func_13(1, 2)
+def func_14(a, b=2):
+    x_14 = a + b * 14 - (a / 3.5) % 2
+    if x_14 > 14 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_14, obj.attr.method(a))
+    return x_14 ** 2
+y_14 = func_14(1, 2)
+def func_15(a, b=2):
+    x_15 = a + b * 15 - (a / 3.5) % 2
+    if x_15 > 15 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_15, obj.attr.method(a))
+    return x_15 ** 2
+y_15 = func_15(1, 2)
+def func_16(a, b=2):
+    x_16 = a + b * 16 - (a / 3.5) % 2
+    if x_16 > 16 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_16, obj.attr.method(a))
+    return x_16 ** 2
+y_16 = func_16(1, 2)
+def func_17(a, b=2):
+    x_17 = a + b * 17 - (a / 3.5) % 2
+    if x_17 > 17 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_17, obj.attr.method(a))
+    return x_17 ** 2
+y_17 = func_17(1, 2)
+def func_18(a, b=2):
+    x_18 = a + b * 18 - (a / 3.5) % 2
+    if x_18 > 18 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_18, obj.attr.method(a))
+    return x_18 ** 2
+y_18 = func_18(1, 2)
+def func_19(a, b=2):
+    x_19 = a + b * 19 - (a / 3.5) % 2
+    if x_19 > 19 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_19, obj.attr.method(a))
+    return x_19 ** 2
+y_19 = func_19(1, 2)
+def func_20(a, b=2):
+    x_20 = a + b * 20 - (a / 3.5) % 2
+    if x_20 > 20 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_20, obj.attr.method(a))
+    return x_20 ** 2
+y_20 = func_20(1, 2)
+def func_21(a, b=2):
+    x_21 = a + b * 21 - (a / 3.5) % 2
+    if x_21 > 21 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_21, obj.attr.method(a))
+    return x_21 ** 2
+y_21 = func_21(1, 2)
+def func_22(a, b=2):
+    x_22 = a + b * 22 - (a / 3.5) % 2
+    if x_22 > 22 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_22, obj.attr.method(a))
+    return x_22 ** 2
+y_22 = func_22(1, 2)
+def func_23(a, b=2):
+    x_23 = a + b * 23 - (a / 3.5) % 2
+    if x_23 > 23 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_23, obj.attr.method(a))
+    return x_23 ** 2
+y_23 = func_23(1, 2)
+def func_24(a, b=2):
+    x_24 = a + b * 24 - (a / 3.5) % 2
+    if x_24 > 24 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_24, obj.attr.method(a))
+    return x_24 ** 2
+y_24 = func_24(1, 2)
+def func_25(a, b=2):
+    x_25 = a + b * 25 - (a / 3.5) % 2
+    if x_25 > 25 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_25, obj.attr.method(a))
+    return x_25 ** 2
+y_25 = func_25(1, 2)
+def func_26(a, b=2):
+    x_26 = a + b * 26 - (a / 3.5) % 2
+    if x_26 > 26 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_26, obj.attr.method(a))
+    return x_26 ** 2
+y_26 = func_26(1, 2)
+def func_27(a, b=2):
+    x_27 = a + b * 27 - (a / 3.5) % 2
+    if x_27 > 27 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_27, obj.attr.method(a))
+    return x_27 ** 2
+y_27 = func_27(1, 2)
+def func_28(a, b=2):
+    x_28 = a + b * 28 - (a / 3.5) % 2
+    if x_28 > 28 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_28, obj.attr.method(a))
+    return x_28 ** 2
+y_28 = func_28(1, 2)
+def func_29(a, b=2):
+    x_29 = a + b * 29 - (a / 3.5) % 2
+    if x_29 > 29 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_29, obj.attr.method(a))
+    return x_29 ** 2
+y_29 = func_29(1, 2)
+def func_30(a, b=2):
+    x_30 = a + b * 30 - (a / 3.5) % 2
+    if x_30 > 30 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_30, obj.attr.method(a))
+    return x_30 ** 2
+y_30 = func_30(1, 2)
+def func_31(a, b=2):
+    x_31 = a + b * 31 - (a / 3.5) % 2
+    if x_31 > 31 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_31, obj.attr.method(a))
+    return x_31 ** 2
+y_31 = func_31(1, 2)
+def func_32(a, b=2):
+    x_32 = a + b * 32 - (a / 3.5) % 2
+    if x_32 > 32 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_32, obj.attr.method(a))
+    return x_32 ** 2
+y_32 = func_32(1, 2)
+def func_33(a, b=2):
+    x_33 = a + b * 33 - (a / 3.5) % 2
+    if x_33 > 33 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_33, obj.attr.method(a))
+    return x_33 ** 2
+y_33 = func_33(1, 2)
+def func_34(a, b=2):
+    x_34 = a + b * 34 - (a / 3.5) % 2
+    if x_34 > 34 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_34, obj.attr.method(a))
+    return x_34 ** 2
+y_34 = func_34(1, 2)
+def func_35(a, b=2):
+    x_35 = a + b * 35 - (a / 3.5) % 2
+    if x_35 > 35 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_35, obj.attr.method(a))
+    return x_35 ** 2
+y_35 = func_35(1, 2)
+def func_36(a, b=2):
+    x_36 = a + b * 36 - (a / 3.5) % 2
+    if x_36 > 36 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_36, obj.attr.method(a))
+    return x_36 ** 2
+y_36 = func_36(1, 2)
+def func_37(a, b=2):
+    x_37 = a + b * 37 - (a / 3.5) % 2
+    if x_37 > 37 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_37, obj.attr.method(a))
+    return x_37 ** 2
+y_37 = func_37(1, 2)
+def func_38(a, b=2):
+    x_38 = a + b * 38 - (a / 3.5) % 2
+    if x_38 > 38 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_38, obj.attr.method(a))
+    return x_38 ** 2
+y_38 = func_38(1, 2)
+def func_39(a, b=2):
+    x_39 = a + b * 39 - (a / 3.5) % 2
+    if x_39 > 39 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_39, obj.attr.method(a))
+    return x_39 ** 2
+y_39 = func_39(1, 2)
+def func_40(a, b=2):
+    x_40 = a + b * 40 - (a / 3.5) % 2
+    if x_40 > 40 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_40, obj.attr.method(a))
+    return x_40 ** 2
+y_40 = func_40(1, 2)
+def func_41(a, b=2):
+    x_41 = a + b * 41 - (a / 3.5) % 2
+    if x_41 > 41 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_41, obj.attr.method(a))
+    return x_41 ** 2
+y_41 = func_41(1, 2)
+def func_42(a, b=2):
+    x_42 = a + b * 42 - (a / 3.5) % 2
+    if x_42 > 42 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_42, obj.attr.method(a))
+    return x_42 ** 2
+y_42 = func_42(1, 2)
+def func_43(a, b=2):
+    x_43 = a + b * 43 - (a / 3.5) % 2
+    if x_43 > 43 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_43, obj.attr.method(a))
+    return x_43 ** 2
+y_43 = func_43(1, 2)
+def func_44(a, b=2):
+    x_44 = a + b * 44 - (a / 3.5) % 2
+    if x_44 > 44 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_44, obj.attr.method(a))
+    return x_44 ** 2
+y_44 = func_44(1, 2)
+def func_45(a, b=2):
+    x_45 = a + b * 45 - (a / 3.5) % 2
+    if x_45 > 45 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_45, obj.attr.method(a))
+    return x_45 ** 2
+y_45 = func_45(1, 2)
+def func_46(a, b=2):
+    x_46 = a + b * 46 - (a / 3.5) % 2
+    if x_46 > 46 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_46, obj.attr.method(a))
+    return x_46 ** 2
+y_46 = func_46(1, 2)
+def func_47(a, b=2):
+    x_47 = a + b * 47 - (a / 3.5) % 2
+    if x_47 > 47 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[2] + lst[0]
+    else:
+        print("value", x_47, obj.attr.method(a))
+    return x_47 ** 2
+y_47 = func_47(1, 2)
+def func_48(a, b=2):
+    x_48 = a + b * 48 - (a / 3.5) % 2
+    if x_48 > 48 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[0] + lst[0]
+    else:
+        print("value", x_48, obj.attr.method(a))
+    return x_48 ** 2
+y_48 = func_48(1, 2)
+def func_49(a, b=2):
+    x_49 = a + b * 49 - (a / 3.5) % 2
+    if x_49 > 49 and not a == b:
+        lst = [1, 2, -3, a]
+        d = lst[1] + lst[0]
+    else:
+        print("value", x_49, obj.attr.method(a))
+    return x_49 ** 2
+y_49 = func_49(1, 2)
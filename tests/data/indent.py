@@ -0,0 +1,21 @@
+def outer():
+    def inner(x):
+        if x:
+            return 1
+        else:
+            return 2
+    return inner
+class_ = outer()
+for i in [1,
+    2,
+    3]:
+    print(i)
+x = {
+    "a": 1,
+    "b": 2
+}
+while True:
+    x = x + 1
+        y = 2
+    z = 3
+  w = 4
@@ -0,0 +1,9 @@
+x = 1
+"""start
+middle
+end""" y = 2
+ab"""c"""d = 3
+q = 1 '''open
+still
+'''
+z = été